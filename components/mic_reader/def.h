@@ -30,12 +30,22 @@ typedef int16_t audio_t;
 #define MIC_FRAME_LEN    (CONFIG_MIC_SAMPLE_RATE / 1000 * MIC_FRAME_LEN_MS)
 #define MIC_FRAME_SZ     (MIC_FRAME_LEN * MIC_ELEM_BYTES * MIC_CHANNEL_NUM)
 
+#if CONFIG_MIC_RESAMPLE
+#define MIC_CAPTURE_SAMPLE_RATE CONFIG_MIC_CAPTURE_SAMPLE_RATE
+#else
+#define MIC_CAPTURE_SAMPLE_RATE CONFIG_MIC_SAMPLE_RATE
+#endif
+#define MIC_CAPTURE_FRAME_LEN                                                  \
+  (MIC_CAPTURE_SAMPLE_RATE / 1000 * MIC_FRAME_LEN_MS)
+#define MIC_CAPTURE_FRAME_SZ                                                   \
+  (MIC_CAPTURE_FRAME_LEN * MIC_ELEM_BYTES * MIC_CHANNEL_NUM)
+
 #define I2S_RX_PORT_NUMBER I2S_NUM_0
 #define I2S_RX_BIT_WIDTH   I2S_DATA_BIT_WIDTH_16BIT
 #define I2S_RX_SLOT_MODE   I2S_SLOT_MODE_MONO
 
-#define I2S_RX_DMA_BUF_LEN (MIC_FRAME_LEN * MIC_CHANNEL_NUM)
-#define I2S_RX_DMA_BUF_SZ  MIC_FRAME_SZ
+#define I2S_RX_DMA_BUF_LEN (MIC_CAPTURE_FRAME_LEN * MIC_CHANNEL_NUM)
+#define I2S_RX_DMA_BUF_SZ  MIC_CAPTURE_FRAME_SZ
 #define I2S_RX_DMA_BUF_NUM 2
 
 #endif // _DEF_H_
@@ -0,0 +1,24 @@
+#include "esp_log.h"
+
+#include "def.h"
+#include "i2s_rx_slot.h"
+#include "sim.h"
+
+static const char *TAG = "i2s_rx_slot";
+
+void i2s_rx_slot_init(const rx_slot_conf_t &conf) {
+  const size_t channels = conf.slot_type == stBoth ? 2 : 1;
+  if (sim_mic_open(conf.sample_rate, channels) < 0) {
+    ESP_LOGE(TAG, "Unable to open sim mic");
+  }
+}
+
+void i2s_rx_slot_start() {}
+
+void i2s_rx_slot_stop() {}
+
+void i2s_rx_slot_release() {}
+
+int i2s_rx_slot_read(void *buffer, size_t bytes, size_t timeout_ms) {
+  return sim_mic_read(buffer, bytes);
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "mic_proc.h"
+
+static const char *TAG = "mic_proc";
+
+/*! \brief DC blocker cutoff, the pole is 0.995 at 16 kHz. */
+#define DC_BLOCK_CUTOFF_HZ 12.76f
+/*! \brief Fraction bits of the filter output and the gain. */
+#define COND_FRAC_BITS 12
+
+mic_conditioner::mic_conditioner(size_t sample_rate, float gain_db) {
+  const float pole =
+    std::exp(-2 * 3.14159265f * DC_BLOCK_CUTOFF_HZ / sample_rate);
+  pole_ = int32_t(std::lround(pole * (1 << 15)));
+  gain_ =
+    int32_t(std::lround(std::pow(10.f, gain_db / 20) * (1 << COND_FRAC_BITS)));
+  reset();
+}
+
+void mic_conditioner::reset() {
+  x_m_ = 0;
+  y_m_ = 0;
+}
+
+void mic_conditioner::process(const int16_t *in, size_t channels, size_t len,
+                              int16_t *out) {
+  if (channels == 2) {
+    filter<2>(in, len, out);
+  } else {
+    filter<1>(in, len, out);
+  }
+}
+
+template <size_t channels>
+void mic_conditioner::filter(const int16_t *in, size_t len, int16_t *out) {
+  // the recursion is sequential, mixing, gain and saturation are fused in
+  // the loop; esp-dsp dsps_add_s16 of the interleaved channels (stride 2) is
+  // its scalar C version, a pass of its own only costs more
+  int32_t x_m = x_m_;
+  int32_t y_m = y_m_;
+  for (size_t i = 0; i < len; i++) {
+    // the mean of the channels never leaves int16
+    const int32_t val =
+      channels == 2 ? (int32_t(in[2 * i]) + in[2 * i + 1]) >> 1 : in[i];
+    y_m = ((val - x_m) << COND_FRAC_BITS) +
+          int32_t((int64_t(pole_) * y_m) >> 15);
+    x_m = val;
+    const int32_t res = int32_t(
+      (int64_t(y_m) * gain_ + (1 << (2 * COND_FRAC_BITS - 1))) >>
+      (2 * COND_FRAC_BITS));
+    out[i] = int16_t(std::clamp(res, int32_t(INT16_MIN), int32_t(INT16_MAX)));
+  }
+  x_m_ = x_m;
+  y_m_ = y_m;
+}
+
+// the fixed point formula of mic_conditioner one sample at a time, without
+// templates and fused loops
+static int16_t reference_fixed(int32_t val, int32_t pole_q15, int32_t gain,
+                               int32_t &x_m, int32_t &y_m) {
+  const int32_t diff = (val - x_m) * (1 << COND_FRAC_BITS);
+  const int64_t fb = int64_t(pole_q15) * y_m;
+  y_m = diff + int32_t(fb >> 15);
+  x_m = val;
+  int64_t res = int64_t(y_m) * gain;
+  res = (res + (int64_t(1) << (2 * COND_FRAC_BITS - 1))) >>
+        (2 * COND_FRAC_BITS);
+  if (res > INT16_MAX) {
+    return INT16_MAX;
+  }
+  if (res < INT16_MIN) {
+    return INT16_MIN;
+  }
+  return int16_t(res);
+}
+
+// fixed point and floating point conditioning of one sample at a time with
+// the same pole and gain
+static void reference(const int16_t *in, size_t channels, size_t len,
+                      int32_t pole_q15, int32_t gain, int16_t *fixed,
+                      int16_t *flt) {
+  const double pole = double(pole_q15) / (1 << 15);
+  const double gain_f = double(gain) / (1 << COND_FRAC_BITS);
+  int32_t x_m = 0, y_m = 0;
+  double x_m_f = 0, y_m_f = 0;
+  for (size_t i = 0; i < len; i++) {
+    int32_t val = in[i * channels];
+    if (channels == 2) {
+      // floor of the mean
+      val = (val + in[2 * i + 1]) >> 1;
+    }
+    fixed[i] = reference_fixed(val, pole_q15, gain, x_m, y_m);
+
+    y_m_f = val - x_m_f + pole * y_m_f;
+    x_m_f = val;
+    flt[i] = int16_t(std::clamp(std::lround(y_m_f * gain_f), long(INT16_MIN),
+                                long(INT16_MAX)));
+  }
+}
+
+void mic_conditioner_benchmark(size_t sample_rate, float gain_db,
+                               size_t iterations) {
+  // one second of a tone with a DC offset over pseudo random noise, loud
+  // enough to saturate with some gain
+  const size_t len = sample_rate;
+  std::vector<int16_t> in(2 * len);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < 2 * len; i++) {
+    seed = seed * 1664525 + 1013904223;
+    in[i] = int16_t(1000 + 12000 * std::sin(0.02 * (i / 2)) +
+                    int32_t(seed >> 20) - 2048);
+  }
+  std::vector<int16_t> out(len), split(len), fixed(len), flt(len);
+
+  for (size_t channels = 1; channels <= 2; channels++) {
+    mic_conditioner cond(sample_rate, gain_db);
+    cond.process(in.data(), channels, len, out.data());
+
+    // the same samples in blocks of 1 to 256 frames
+    cond.reset();
+    for (size_t i = 0, n = 1; i < len; i += n, n = n * 7 % 257) {
+      n = std::min(n, len - i);
+      cond.process(&in[i * channels], channels, n, &split[i]);
+    }
+    reference(in.data(), channels, len, cond.pole_, cond.gain_, fixed.data(),
+              flt.data());
+    size_t mismatches = 0, ref_mismatches = 0;
+    int32_t err = 0;
+    for (size_t i = 0; i < len; i++) {
+      mismatches += out[i] != split[i];
+      ref_mismatches += out[i] != fixed[i];
+      err = std::max(err, std::abs(int32_t(out[i]) - flt[i]));
+    }
+
+    const size_t block = sample_rate / 100;
+    const int64_t t1 = esp_timer_get_time();
+    for (size_t i = 0; i < iterations; i++) {
+      cond.process(in.data(), channels, block, out.data());
+    }
+    const double us = double(esp_timer_get_time() - t1) / iterations;
+    if (mismatches) {
+      ESP_LOGE(TAG, "%u channels: %u samples differ in blocks",
+               unsigned(channels), unsigned(mismatches));
+    }
+    if (ref_mismatches) {
+      ESP_LOGE(TAG, "%u channels: %u samples differ from the reference",
+               unsigned(channels), unsigned(ref_mismatches));
+    }
+    ESP_LOGI(TAG,
+             "%u channels at %u Hz, %+.0f dB: %u samples differ in blocks, "
+             "%u from the reference, max error to floating point %d, %.1f us "
+             "per 10 ms (%.2f%% CPU)",
+             unsigned(channels), unsigned(sample_rate), double(gain_db),
+             unsigned(mismatches), unsigned(ref_mismatches), int(err), us,
+             us / 100);
+  }
+}
@@ -5,21 +5,60 @@
 #include "stdint.h"
 #include "string.h"
 
-template <typename T> struct dc_blocker {
+/*!
+ * \brief Capture conditioning of DMA buffers of int16 samples: the channels
+ * are mixed to their mean, DC is blocked by y[n] = x[n] - x[n-1] + a * y[n-1]
+ * with the pole a of a 12.8 Hz cutoff (0.995 at 16 kHz) in Q15 and y kept
+ * with 12 fraction bits, and the result is multiplied by the pre-gain with
+ * saturation, all in one loop. The state carries over buffers, the output
+ * does not depend on how samples are split.
+ */
+class mic_conditioner {
+public:
+  /*!
+   * \brief Constructor.
+   * \param sample_rate Sample rate.
+   * \param gain_db Pre-gain, dB.
+   */
+  mic_conditioner(size_t sample_rate, float gain_db = 0);
+
+  /*!
+   * \brief Condition a buffer.
+   * \param in len frames of channels interleaved samples.
+   * \param channels 1 or 2.
+   * \param len Number of frames.
+   * \param out len samples, not in.
+   */
+  void process(const int16_t *in, size_t channels, size_t len, int16_t *out);
+  /*! \brief Clear the filter state. */
+  void reset();
+
 private:
-  T xM_ = 0;
-  T yM_ = 0;
-  T y_ = 0;
+  friend void mic_conditioner_benchmark(size_t sample_rate, float gain_db,
+                                        size_t iterations);
+  template <size_t channels>
+  void filter(const int16_t *in, size_t len, int16_t *out);
 
-public:
-  T proc_val(T val) {
-    y_ = val - xM_ + 0.995 * yM_;
-    xM_ = val;
-    yM_ = y_;
-    return y_;
-  }
+  int32_t pole_;
+  /*! \brief Pre-gain with 12 fraction bits. */
+  int32_t gain_;
+  int32_t x_m_;
+  /*! \brief Last output with 12 fraction bits. */
+  int32_t y_m_;
 };
 
+/*!
+ * \brief Check that mic_conditioner output does not depend on the block
+ * split and is bit exact to a scalar fixed point conditioning of one sample at
+ * a time, log its largest difference to a floating point one with the same
+ * pole and gain and the time per 10 ms, mono and stereo.
+ * \param sample_rate Sample rate.
+ * \param gain_db Pre-gain, dB.
+ * \param iterations Blocks of 10 ms timed.
+ */
+void mic_conditioner_benchmark(size_t sample_rate, float gain_db,
+                               size_t iterations);
+
 template <typename T> T compute_max_abs(T *data, size_t len) {
   T max_abs = 0;
   for (size_t j = 0; j < len; j++) {
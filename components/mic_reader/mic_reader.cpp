@@ -9,6 +9,9 @@
 #include "i2s_rx_slot.h"
 #include "mic_proc.h"
 #include "mic_reader.h"
+#if CONFIG_MIC_RESAMPLE
+#include "resampler.h"
+#endif
 
 static const char *TAG = "mic_reader";
 
@@ -21,25 +24,51 @@ static constexpr size_t DEF_STD_DEV =
 
 SemaphoreHandle_t xMicSema = NULL;
 
-static dc_blocker<int32_t> s_dc_blocker;
+static mic_conditioner s_conditioner(MIC_CAPTURE_SAMPLE_RATE,
+                                     CONFIG_MIC_GAIN_DB);
 
-static audio_t mic_frame_buf[MIC_FRAME_LEN * MIC_CHANNEL_NUM] = {0};
+static audio_t mic_frame_buf[MIC_CAPTURE_FRAME_LEN * MIC_CHANNEL_NUM] = {0};
 
-int mic_reader_read_frame(audio_t *buffer, size_t timeout_ms) {
-  if (i2s_rx_slot_read(mic_frame_buf, MIC_FRAME_SZ, timeout_ms) < 0) {
+#if CONFIG_MIC_RESAMPLE
+static polyphase_resampler *s_resampler = NULL;
+/*! \brief Conditioned samples at capture rate. */
+static audio_t s_capture_buf[MIC_CAPTURE_FRAME_LEN] = {0};
+/*! \brief Resampled samples not read yet, less than a frame and a new one. */
+static audio_t s_resampled_buf[2 * MIC_FRAME_LEN + 1] = {0};
+static size_t s_resampled_len = 0;
+#endif
+
+/*!
+ * \brief Read a frame at capture rate, mixed, DC blocked and amplified.
+ * \param buffer MIC_CAPTURE_FRAME_LEN samples.
+ */
+static int read_capture_frame(audio_t *buffer, size_t timeout_ms) {
+  if (i2s_rx_slot_read(mic_frame_buf, MIC_CAPTURE_FRAME_SZ, timeout_ms) < 0) {
     return -1;
   }
+  s_conditioner.process(mic_frame_buf, MIC_CHANNEL_NUM, MIC_CAPTURE_FRAME_LEN,
+                        buffer);
+  return 0;
+}
 
-  for (size_t i = 0; i < MIC_FRAME_LEN; i++) {
-    const audio_t val =
-#if CONFIG_MIC_CHANNEL_BOTH
-      mic_frame_buf[i * 2] + mic_frame_buf[i * 2 + 1];
-#else
-      mic_frame_buf[i];
-#endif
-    buffer[i] = s_dc_blocker.proc_val(val);
+int mic_reader_read_frame(audio_t *buffer, size_t timeout_ms) {
+#if CONFIG_MIC_RESAMPLE
+  while (s_resampled_len < MIC_FRAME_LEN) {
+    if (read_capture_frame(s_capture_buf, timeout_ms) < 0) {
+      return -1;
+    }
+    s_resampled_len +=
+      s_resampler->process(s_capture_buf, MIC_CAPTURE_FRAME_LEN,
+                           &s_resampled_buf[s_resampled_len]);
   }
+  memcpy(buffer, s_resampled_buf, MIC_FRAME_LEN * MIC_ELEM_BYTES);
+  s_resampled_len -= MIC_FRAME_LEN;
+  memmove(s_resampled_buf, &s_resampled_buf[MIC_FRAME_LEN],
+          s_resampled_len * MIC_ELEM_BYTES);
   return 0;
+#else
+  return read_capture_frame(buffer, timeout_ms);
+#endif
 };
 
 static float compute_mean(const audio_t *data, size_t samples) {
@@ -62,13 +91,14 @@ static float compute_std_dev(const audio_t *data, size_t samples,
 static MicResult_t test_microphone() {
   float mean = 0.0;
   float std_dev = 0.0;
+  audio_t frame[MIC_FRAME_LEN];
 
   for (size_t i = 0; i < MIC_TEST_FRAME_NUM; i++) {
-    memset(mic_frame_buf, 0, MIC_FRAME_SZ);
-    mic_reader_read_frame(mic_frame_buf, MIC_FRAME_LEN_MS * 2);
-    const float frame_mean = compute_mean(mic_frame_buf, MIC_FRAME_LEN);
+    memset(frame, 0, sizeof(frame));
+    mic_reader_read_frame(frame, MIC_FRAME_LEN_MS * 2);
+    const float frame_mean = compute_mean(frame, MIC_FRAME_LEN);
     const float frame_std_dev =
-      compute_std_dev(mic_frame_buf, MIC_FRAME_LEN, frame_mean);
+      compute_std_dev(frame, MIC_FRAME_LEN, frame_mean);
     ESP_LOGV(TAG, "frame_mean=%f, frame_std_dev=%f", mean, std_dev);
     mean += frame_mean / MIC_TEST_FRAME_NUM;
     std_dev += frame_std_dev / MIC_TEST_FRAME_NUM;
@@ -93,19 +123,26 @@ MicResult_t mic_reader_init() {
     return MIC_INIT_ERROR;
   }
 
+  s_conditioner.reset();
+#if CONFIG_MIC_RESAMPLE
+  s_resampler = new polyphase_resampler(
+    MIC_CAPTURE_SAMPLE_RATE, CONFIG_MIC_SAMPLE_RATE, MIC_CAPTURE_FRAME_LEN);
+  s_resampled_len = 0;
+#endif
+
   const rx_slot_conf_t rx_slot_conf[] = {
 #if CONFIG_MIC_CHANNEL_BOTH
     {
-      .sample_rate = CONFIG_MIC_SAMPLE_RATE,
+      .sample_rate = MIC_CAPTURE_SAMPLE_RATE,
       .slot_type = stBoth,
     },
 #else
     {
-      .sample_rate = CONFIG_MIC_SAMPLE_RATE,
+      .sample_rate = MIC_CAPTURE_SAMPLE_RATE,
       .slot_type = stRight,
     },
     {
-      .sample_rate = CONFIG_MIC_SAMPLE_RATE,
+      .sample_rate = MIC_CAPTURE_SAMPLE_RATE,
       .slot_type = stLeft,
     },
 #endif
@@ -119,8 +156,9 @@ MicResult_t mic_reader_init() {
     i2s_rx_slot_start();
 
     // read first bad samples, init filter
+    audio_t frame[MIC_FRAME_LEN];
     for (size_t i = 0; i < FILTER_INIT_FRAME_NUM; i++) {
-      mic_reader_read_frame(mic_frame_buf, MIC_FRAME_LEN_MS * 2);
+      mic_reader_read_frame(frame, MIC_FRAME_LEN_MS * 2);
     }
 
     test_result = test_microphone();
@@ -141,6 +179,10 @@ MicResult_t mic_reader_init() {
 void mic_reader_release() {
   i2s_rx_slot_stop();
   i2s_rx_slot_release();
+#if CONFIG_MIC_RESAMPLE
+  delete s_resampler;
+  s_resampler = NULL;
+#endif
 
   if (xMicSema) {
     vSemaphoreDelete(xMicSema);
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "dsps_dotprod.h"
+#endif
+
+#include "resampler.h"
+
+static const char *TAG = "resampler";
+
+/*! \brief Stopband attenuation, dB. */
+#define RESAMPLER_STOPBAND_DB 70.f
+/*! \brief Transition band, fraction of the lower Nyquist frequency. */
+#define RESAMPLER_TRANSITION 0.25f
+/*!
+ * \brief Passband gain, the headroom takes the filter overshoot of full scale
+ * steps.
+ */
+#define RESAMPLER_GAIN 0.9f
+/*! \brief Taps per phase are a multiple of the dot product SIMD width. */
+#define RESAMPLER_TAPS_ALIGN 8
+
+static const float PI = 3.14159265358979f;
+
+// zeroth order modified Bessel function of the first kind
+static double bessel_i0(double x) {
+  double sum = 1, term = 1;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+static inline int16_t dot_q15(const int16_t *a, const int16_t *b,
+                              size_t len) {
+#if !CONFIG_IDF_TARGET_LINUX
+  int16_t res;
+  dsps_dotprod_s16(a, b, &res, len, 0);
+  return res;
+#else
+  int32_t acc = 1 << 14;
+  for (size_t i = 0; i < len; i += 4) {
+    acc += int32_t(a[i]) * b[i] + int32_t(a[i + 1]) * b[i + 1] +
+           int32_t(a[i + 2]) * b[i + 2] + int32_t(a[i + 3]) * b[i + 3];
+  }
+  return int16_t(std::clamp(acc >> 15, int32_t(INT16_MIN),
+                            int32_t(INT16_MAX)));
+#endif
+}
+
+polyphase_resampler::polyphase_resampler(size_t in_rate, size_t out_rate,
+                                         size_t max_in) {
+  const size_t g = std::gcd(in_rate, out_rate);
+  up_ = out_rate / g;
+  down_ = in_rate / g;
+
+  // Kaiser window length for the attenuation and transition at input rate
+  const float cutoff = 0.5f * std::min(in_rate, out_rate);
+  const float transition = 2 * PI * RESAMPLER_TRANSITION * cutoff / in_rate;
+  const size_t taps = size_t(
+    std::ceil((RESAMPLER_STOPBAND_DB - 8) / (2.285f * transition)));
+  taps_ = (taps + RESAMPLER_TAPS_ALIGN - 1) / RESAMPLER_TAPS_ALIGN *
+          RESAMPLER_TAPS_ALIGN;
+  const float beta = 0.1102f * (RESAMPLER_STOPBAND_DB - 8.7f);
+
+  // prototype at up_ * in_rate, gain up_ for the inserted zeros
+  const size_t len = up_ * taps_;
+  const double wc = double(cutoff) / (double(up_) * in_rate);
+  const double center = 0.5 * (len - 1);
+  std::vector<float> proto(len);
+  for (size_t i = 0; i < len; i++) {
+    const double x = i - center;
+    const double sinc =
+      x == 0 ? 2 * wc : std::sin(2 * M_PI * wc * x) / (M_PI * x);
+    const double r = 2 * x / (len - 1);
+    const double w = bessel_i0(beta * std::sqrt(std::max(0., 1 - r * r))) /
+                     bessel_i0(beta);
+    proto[i] = float(up_ * sinc * w);
+  }
+
+  // DC gain of the phases is up to the window ripple
+  float max_sum = 0;
+  for (size_t p = 0; p < up_; p++) {
+    float sum = 0;
+    for (size_t k = 0; k < taps_; k++) {
+      sum += proto[p + k * up_];
+    }
+    max_sum = std::max(max_sum, sum);
+  }
+  gain_ = RESAMPLER_GAIN / max_sum;
+
+  coeffs_.resize(len);
+  for (size_t p = 0; p < up_; p++) {
+    for (size_t k = 0; k < taps_; k++) {
+      coeffs_[p * taps_ + taps_ - 1 - k] =
+        int16_t(std::lround(proto[p + k * up_] * gain_ * 32768.f));
+    }
+  }
+  buf_.resize(taps_ - 1 + max_in);
+  reset();
+  ESP_LOGD(TAG, "%u -> %u Hz: %u/%u, %u taps, gain %.3f", unsigned(in_rate),
+           unsigned(out_rate), unsigned(up_), unsigned(down_),
+           unsigned(taps_), double(gain_));
+}
+
+void polyphase_resampler::reset() {
+  std::fill(buf_.begin(), buf_.end(), 0);
+  base_ = 0;
+  phase_ = 0;
+}
+
+size_t polyphase_resampler::process(const int16_t *in, size_t in_len,
+                                    int16_t *out) {
+  // input sample j is buf_[taps_ - 1 + j], output n is the dot product of
+  // the taps_ samples ending with its base one
+  memcpy(&buf_[taps_ - 1], in, in_len * sizeof(int16_t));
+  const size_t base_step = down_ / up_;
+  const size_t phase_step = down_ % up_;
+  size_t n = 0;
+  while (base_ < in_len) {
+    out[n++] = dot_q15(&coeffs_[phase_ * taps_], &buf_[base_], taps_);
+    base_ += base_step;
+    phase_ += phase_step;
+    if (phase_ >= up_) {
+      phase_ -= up_;
+      base_++;
+    }
+  }
+  base_ -= in_len;
+  memmove(buf_.data(), &buf_[in_len], (taps_ - 1) * sizeof(int16_t));
+  return n;
+}
+
+// level of a tone after resampling relative to full scale, dB
+static float tone_level(polyphase_resampler &rs, size_t in_rate, float freq,
+                        size_t block) {
+  std::vector<int16_t> in(block);
+  std::vector<int16_t> out(rs.max_out(block));
+  rs.reset();
+  double sum_sq = 0;
+  size_t count = 0;
+  // skip the first blocks, the filter delay
+  for (size_t b = 0, t = 0; b < 20; b++) {
+    for (size_t i = 0; i < block; i++, t++) {
+      in[i] = int16_t(16384 * std::sin(2 * M_PI * freq * t / in_rate));
+    }
+    const size_t n = rs.process(in.data(), block, out.data());
+    if (b < 4) {
+      continue;
+    }
+    for (size_t i = 0; i < n; i++) {
+      sum_sq += double(out[i]) * out[i];
+    }
+    count += n;
+  }
+  const double rms = std::sqrt(sum_sq / std::max<size_t>(count, 1));
+  return float(20 * std::log10(std::max(rms, 1e-3) / (16384 / M_SQRT2)));
+}
+
+void resampler_benchmark(size_t in_rate, size_t out_rate, size_t iterations) {
+  const size_t block = in_rate / 100;
+  polyphase_resampler rs(in_rate, out_rate, block);
+
+  const float nyquist = 0.5f * std::min(in_rate, out_rate);
+  const float pass = tone_level(rs, in_rate, 1000, block);
+  // tones past the stopband edge up to the input Nyquist frequency, they
+  // fold below 7/8 of the output one, none if upsampling
+  float alias = -200;
+  for (float f = nyquist * (2 - 7 / 8.f); f < 0.5f * in_rate;
+       f += 0.05f * nyquist) {
+    alias = std::max(alias, tone_level(rs, in_rate, f, block) - pass);
+  }
+
+  std::vector<int16_t> in(block);
+  std::vector<int16_t> out(rs.max_out(block));
+  for (size_t i = 0; i < block; i++) {
+    in[i] = int16_t(8192 * std::sin(0.05 * i));
+  }
+  const int64_t t1 = esp_timer_get_time();
+  for (size_t i = 0; i < iterations; i++) {
+    rs.process(in.data(), block, out.data());
+  }
+  const double us = double(esp_timer_get_time() - t1) / iterations;
+  ESP_LOGI(TAG,
+           "%u -> %u Hz, %u taps: 1 kHz %.1f dB, aliasing %.1f dB, "
+           "%.1f us per 10 ms (%.2f%% CPU)",
+           unsigned(in_rate), unsigned(out_rate), unsigned(rs.taps()),
+           double(pass), double(alias), us, us / 100);
+}
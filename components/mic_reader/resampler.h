@@ -0,0 +1,70 @@
+#ifndef _RESAMPLER_H_
+#define _RESAMPLER_H_
+
+#include "stddef.h"
+#include "stdint.h"
+
+#include <vector>
+
+/*!
+ * \brief Polyphase FIR resampler of int16 samples by a rational ratio
+ * out_rate / in_rate = L / M. The Kaiser windowed sinc lowpass is cut at the
+ * lower Nyquist frequency with the transition band 7/8 to 9/8 of it, so the
+ * content aliased by decimation lands above the passband, with 70 dB
+ * stopband. Each output sample is one dot product of a phase of taps() Q15
+ * coefficients, esp-dsp dsps_dotprod_s16 (SIMD on ESP32-S3) on the target.
+ */
+class polyphase_resampler {
+public:
+  /*!
+   * \brief Constructor.
+   * \param in_rate Input sample rate.
+   * \param out_rate Output sample rate.
+   * \param max_in Max samples per process() call.
+   */
+  polyphase_resampler(size_t in_rate, size_t out_rate, size_t max_in);
+
+  /*!
+   * \brief Resample the next block.
+   * \param in in_len samples, in_len <= max_in.
+   * \param in_len Number of samples.
+   * \param out max_out(in_len) samples.
+   * \return Number of output samples.
+   */
+  size_t process(const int16_t *in, size_t in_len, int16_t *out);
+  /*! \brief Max output samples of in_len input ones. */
+  size_t max_out(size_t in_len) const { return in_len * up_ / down_ + 1; }
+  /*! \brief Taps per output sample. */
+  size_t taps() const { return taps_; }
+  /*!
+   * \brief Passband gain, below 1 for headroom. The target dot product wraps
+   * on overflow, the host one saturates.
+   */
+  float gain() const { return gain_; }
+  /*! \brief Clear the input history. */
+  void reset();
+
+private:
+  size_t up_;
+  size_t down_;
+  size_t taps_;
+  float gain_;
+  /*! \brief up_ phases of taps_ coefficients, reversed. */
+  std::vector<int16_t> coeffs_;
+  /*! \brief taps_ - 1 history samples and the block. */
+  std::vector<int16_t> buf_;
+  /*! \brief Next output position, input sample and phase. */
+  size_t base_;
+  size_t phase_;
+};
+
+/*!
+ * \brief Log passband gain, aliasing of tones above the output Nyquist
+ * frequency and time per 10 ms of input of the resampler.
+ * \param in_rate Input sample rate.
+ * \param out_rate Output sample rate.
+ * \param iterations Blocks of 10 ms timed.
+ */
+void resampler_benchmark(size_t in_rate, size_t out_rate, size_t iterations);
+
+#endif // _RESAMPLER_H_
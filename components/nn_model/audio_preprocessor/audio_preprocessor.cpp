@@ -20,60 +20,85 @@
  * Description: MFCC feature extraction to match with TensorFlow MFCC Op
  */
 
+#include <algorithm>
 #include <cfloat>
 #include <cstring>
 
+#include "esp_log.h"
+
 #include "audio_preprocessor.h"
 
+static const char *TAG = "audio_preprocessor";
+
 AudioPreprocessor::AudioPreprocessor(int samp_freq, int numMfccFeatures,
                                      int frameLen, int numFbankBins,
-                                     int melLowF, int melHighF)
+                                     int melLowF, int melHighF,
+                                     bool padToPow2,
+                                     const preproc_tables_t *generated)
   : numMfccFeatures(numMfccFeatures), frameLen(frameLen),
     numFbankBins(numFbankBins) {
-  // Round-up to nearest power of 2.
-  frameLenPadded = pow(2, ceil((log(frameLen) / log(2))));
+  // Round-up to nearest power of 2, or mixed-radix FFT of the frame.
+  if (!padToPow2 && (frameLen & (frameLen - 1)) &&
+      !FFTMixedRadix::Supported(frameLen)) {
+    ESP_LOGW(TAG, "no FFT of %d samples, padded to a power of 2", frameLen);
+    padToPow2 = true;
+  }
+  frameLenPadded =
+    padToPow2 ? pow(2, ceil((log(frameLen) / log(2)))) : frameLen;
 
   frame = std::vector<float>(frameLenPadded, 0.0);
   buffer = std::vector<float>(frameLenPadded, 0.0);
   melEnergies = std::vector<float>(numFbankBins, 0.0);
 
-  // Create window function.
-  windowFunc = std::vector<float>(frameLen, 0.0);
-  for (int i = 0; i < frameLen; i++)
-    windowFunc[i] =
-      0.5 - 0.5 * riscv_cos_f32(M_2PI * (static_cast<float>(i)) / (frameLen));
-
-  // Create mel filterbank.
-  fbankFilterFirst = std::vector<int32_t>(numFbankBins, 0);
-  fbankFilterLast = std::vector<int32_t>(numFbankBins, 0);
-  melFbank = CreateMelFbank(samp_freq, melLowF, melHighF);
+  tables = preproc_tables_t{
+    .samp_freq = samp_freq,
+    .frame_len = frameLen,
+    .fft_len = frameLenPadded,
+    .num_fbank_bins = numFbankBins,
+    .num_mfcc = numMfccFeatures,
+    .mel_low_freq = melLowF,
+    .mel_high_freq = melHighF,
+  };
+  // Generated tables of the same configuration, computed ones otherwise.
+  if (generated && generated->samp_freq == samp_freq &&
+      generated->frame_len == frameLen &&
+      generated->fft_len == frameLenPadded &&
+      generated->num_fbank_bins == numFbankBins &&
+      generated->mel_low_freq == melLowF &&
+      generated->mel_high_freq == melHighF &&
+      (generated->num_mfcc == numMfccFeatures || numMfccFeatures == 0)) {
+    tables.window = generated->window;
+    tables.fbank_first = generated->fbank_first;
+    tables.fbank_last = generated->fbank_last;
+    tables.fbank_weights = generated->fbank_weights;
+    tables.dct_matrix = numMfccFeatures ? generated->dct_matrix : nullptr;
+  } else {
+    // Create window function.
+    windowFunc = std::vector<float>(frameLen, 0.0);
+    for (int i = 0; i < frameLen; i++)
+      windowFunc[i] =
+        0.5 -
+        0.5 * riscv_cos_f32(M_2PI * (static_cast<float>(i)) / (frameLen));
+    tables.window = windowFunc.data();
+
+    // Create mel filterbank.
+    fbankFilterFirst = std::vector<int32_t>(numFbankBins, 0);
+    fbankFilterLast = std::vector<int32_t>(numFbankBins, 0);
+    CreateMelFbank(samp_freq, melLowF, melHighF);
+    tables.fbank_first = fbankFilterFirst.data();
+    tables.fbank_last = fbankFilterLast.data();
+    tables.fbank_weights = melFbank.data();
+  }
 
-  // Create DCT matrix.
-  dctMatrix = CreateDctMatrix(numFbankBins, numMfccFeatures);
+  // Create DCT, matrix or FFT based depending on the size.
+  dct.reset(new DCT(numFbankBins, numMfccFeatures, tables.dct_matrix));
 
   // Initialize FFT.
-  riscv_rfft_fast_init_f32(&fft, frameLenPadded);
-}
-
-std::vector<float>
-AudioPreprocessor::CreateDctMatrix(int32_t inputLength,
-                                   int32_t coefficientCount) {
-  int32_t k, n;
-  std::vector<float> M(inputLength * coefficientCount);
-  float normalizer;
-  normalizer = sqrt(2.0 / static_cast<float>(inputLength));
-  for (k = 0; k < coefficientCount; k++) {
-    for (n = 0; n < inputLength; n++) {
-      M[k * inputLength + n] =
-        normalizer * riscv_cos_f32((static_cast<double>(M_PI)) / inputLength *
-                                   (n + 0.5) * k);
-    }
-  }
-  return M;
+  fft.reset(IFFT::Create(frameLenPadded));
 }
 
-std::vector<std::vector<float>>
-AudioPreprocessor::CreateMelFbank(int samp_freq, int melLowF, int melHighF) {
+void AudioPreprocessor::CreateMelFbank(int samp_freq, int melLowF,
+                                       int melHighF) {
   int32_t bin, i;
 
   int32_t numFftBins = frameLenPadded / 2;
@@ -83,7 +108,6 @@ AudioPreprocessor::CreateMelFbank(int samp_freq, int melLowF, int melHighF) {
   float melFreqDelta = (melHighFreq - melLowFreq) / (numFbankBins + 1);
 
   std::vector<float> thisBin(numFftBins);
-  std::vector<std::vector<float>> melFbank(numFbankBins);
 
   for (bin = 0; bin < numFbankBins; bin++) {
     float leftMel = melLowFreq + bin * melFreqDelta;
@@ -115,31 +139,95 @@ AudioPreprocessor::CreateMelFbank(int samp_freq, int melLowF, int melHighF) {
     fbankFilterFirst[bin] = firstIndex;
     fbankFilterLast[bin] = lastIndex;
 
-    // Copy the part we care about.
+    // Copy the part we care about, filters one after another.
     for (i = firstIndex; i <= lastIndex; i++) {
-      melFbank[bin].push_back(thisBin[i]);
+      melFbank.push_back(thisBin[i]);
     }
   }
-
-  return melFbank;
 }
 
 void AudioPreprocessor::LogMelCompute(const float *audioData, float *outData) {
-  int32_t i, j, bin;
+  int32_t i;
 
   for (i = 0; i < frameLen; i++) {
     frame[i] = audioData[i];
   }
 
   // Fill up remaining with zeros.
-  memset(&frame[frameLen], 0, sizeof(float) * (frameLenPadded - frameLen));
+  memset(frame.data() + frameLen, 0,
+         sizeof(float) * (frameLenPadded - frameLen));
 
   for (i = 0; i < frameLen; i++) {
-    frame[i] *= windowFunc[i];
+    frame[i] *= tables.window[i];
   }
 
+  FrameLogMel(outData);
+}
+
+void AudioPreprocessor::LoadFrame(const int16_t *pcm, size_t count,
+                                  float scale) {
+  // Convert, scale and window in one pass, zeros past the samples.
+  const float *w = tables.window;
+  float *f = frame.data();
+  const size_t count4 = count & ~size_t(3);
+  size_t i = 0;
+  for (; i < count4; i += 4) {
+    f[i] = pcm[i] * scale * w[i];
+    f[i + 1] = pcm[i + 1] * scale * w[i + 1];
+    f[i + 2] = pcm[i + 2] * scale * w[i + 2];
+    f[i + 3] = pcm[i + 3] * scale * w[i + 3];
+  }
+  for (; i < count; i++) {
+    f[i] = pcm[i] * scale * w[i];
+  }
+  memset(f + count, 0, sizeof(float) * (frameLenPadded - count));
+}
+
+size_t AudioPreprocessor::LogMelBatch(const int16_t *pcm, size_t samples,
+                                      size_t frameShift, float scale,
+                                      float *out, size_t maxFrames) {
+  const size_t frames =
+    std::min((samples + frameShift - 1) / frameShift, maxFrames);
+  for (size_t f = 0; f < frames; f++) {
+    const size_t start = f * frameShift;
+    LoadFrame(&pcm[start], std::min(samples - start, size_t(frameLen)),
+              scale);
+    FrameLogMel(&out[f * numFbankBins]);
+  }
+  return frames;
+}
+
+size_t AudioPreprocessor::MfccBatch(const int16_t *pcm, size_t samples,
+                                    size_t frameShift, float scale,
+                                    float *out, size_t maxFrames) {
+  if (melBatch.size() < maxFrames * numFbankBins) {
+    melBatch.resize(maxFrames * numFbankBins);
+  }
+  const size_t frames = LogMelBatch(pcm, samples, frameShift, scale,
+                                    melBatch.data(), maxFrames);
+  // All the rows in one DCT call.
+  if (frames) {
+    dct->Compute(melBatch.data(), out, frames);
+  }
+  return frames;
+}
+
+void AudioPreprocessor::FrameLogMel(float *outData) {
+  FramePower(buffer.data());
+  PowerToLogMel(buffer.data(), outData);
+}
+
+void AudioPreprocessor::PowerSpectrum(const int16_t *pcm, float scale,
+                                      float *power) {
+  LoadFrame(pcm, frameLen, scale);
+  FramePower(power);
+}
+
+void AudioPreprocessor::FramePower(float *power) {
+  int32_t i;
+
   // Compute FFT.
-  riscv_rfft_fast_f32(&fft, frame.data(), buffer.data(), 0);
+  fft->Forward(frame.data(), buffer.data());
 
   // Convert to power spectrum.
   // frame is stored as [real0, realN/2-1, real1, im1, real2, im2, ...]
@@ -148,45 +236,107 @@ void AudioPreprocessor::LogMelCompute(const float *audioData, float *outData) {
         lastEnergy = buffer[1] * buffer[1]; // Handle this special case.
   for (i = 1; i < halfDim; i++) {
     float real = buffer[i * 2], im = buffer[i * 2 + 1];
-    buffer[i] = real * real + im * im;
+    power[i] = real * real + im * im;
   }
-  buffer[0] = firstEnergy;
-  buffer[halfDim] = lastEnergy;
+  power[0] = firstEnergy;
+  power[halfDim] = lastEnergy;
+}
+
+void AudioPreprocessor::PowerToMel(const float *power, float *outData) {
+  int32_t i, j, bin;
 
   float sqrtData;
   // Apply mel filterbanks.
+  j = 0;
   for (bin = 0; bin < numFbankBins; bin++) {
-    j = 0;
     float melEnergy = 0;
-    int32_t firstIndex = fbankFilterFirst[bin];
-    int32_t lastIndex = fbankFilterLast[bin];
+    int32_t firstIndex = tables.fbank_first[bin];
+    int32_t lastIndex = tables.fbank_last[bin];
     for (i = firstIndex; i <= lastIndex; i++) {
-      sqrtData = sqrt(buffer[i]);
-      melEnergy += (sqrtData)*melFbank[bin][j++];
+      sqrtData = sqrt(power[i]);
+      melEnergy += (sqrtData)*tables.fbank_weights[j++];
     }
-    melEnergies[bin] = melEnergy;
+    outData[bin] = melEnergy;
+  }
+}
+
+void AudioPreprocessor::PowerToLogMel(const float *power, float *outData) {
+  PowerToMel(power, melEnergies.data());
 
+  for (int32_t bin = 0; bin < numFbankBins; bin++) {
     // Avoid log of zero.
-    if (melEnergy == 0.0)
-      melEnergies[bin] = FLT_MIN;
+    outData[bin] = logf(melEnergies[bin] == 0.0 ? FLT_MIN : melEnergies[bin]);
   }
+}
 
-  for (bin = 0; bin < numFbankBins; bin++) {
-    outData[bin] = logf(melEnergies[bin]);
+void AudioPreprocessor::PcenInit(float smoothing, float inputScale,
+                                 float alpha, float delta, float root,
+                                 float eps) {
+  pcenSmoothing = smoothing;
+  pcenInputScale = inputScale;
+  pcenAlpha = alpha;
+  pcenDelta = delta;
+  pcenRoot = root;
+  pcenEps = eps;
+  pcenState = std::vector<float>(numFbankBins, 0.0);
+  pcenStarted = false;
+}
+
+float AudioPreprocessor::PcenSmoothing(float timeConstant, float frameRate) {
+  // Pole of the first order IIR filter of the time constant in frames.
+  const float t = timeConstant * frameRate;
+  return (sqrtf(1 + 4 * t * t) - 1) / (2 * t * t);
+}
+
+void AudioPreprocessor::PowerToPcen(const float *power, float *outData) {
+  PowerToMel(power, melEnergies.data());
+  MelToPcen(melEnergies.data(), outData);
+}
+
+void AudioPreprocessor::MelToPcen(const float *mel, float *outData) {
+  float *m = pcenState.data();
+  if (!pcenStarted) {
+    for (int32_t bin = 0; bin < numFbankBins; bin++) {
+      m[bin] = mel[bin] * pcenInputScale;
+    }
+    pcenStarted = true;
+  }
+  const float s = pcenSmoothing;
+  const float deltaRoot = powf(pcenDelta, pcenRoot);
+  for (int32_t bin = 0; bin < numFbankBins; bin++) {
+    const float e = mel[bin] * pcenInputScale;
+    m[bin] += s * (e - m[bin]);
+    // E / (eps + M)^alpha with one log and exp.
+    const float v =
+      e * expf(-pcenAlpha * logf(pcenEps + m[bin])) + pcenDelta;
+    outData[bin] =
+      (pcenRoot == 0.5f ? sqrtf(v) : powf(v, pcenRoot)) - deltaRoot;
   }
 }
 
+size_t AudioPreprocessor::PcenBatch(const int16_t *pcm, size_t samples,
+                                    size_t frameShift, float scale,
+                                    float *out, size_t maxFrames) {
+  const size_t frames =
+    std::min((samples + frameShift - 1) / frameShift, maxFrames);
+  for (size_t f = 0; f < frames; f++) {
+    const size_t start = f * frameShift;
+    LoadFrame(&pcm[start], std::min(samples - start, size_t(frameLen)),
+              scale);
+    FramePower(buffer.data());
+    PowerToPcen(buffer.data(), &out[f * numFbankBins]);
+  }
+  return frames;
+}
+
 void AudioPreprocessor::MfccCompute(const float *audioData, float *outData) {
   LogMelCompute(audioData, melEnergies.data());
-  int32_t i, j;
 
-  // Take DCT. Uses matrix mul.
-  for (i = 0; i < numMfccFeatures; i++) {
-    float sum = 0.0;
-    for (j = 0; j < numFbankBins; j++) {
-      sum += dctMatrix[i * numFbankBins + j] * melEnergies[j];
-    }
+  // Take DCT.
+  dct->Compute(melEnergies.data(), outData);
+}
 
-    outData[i] = sum;
-  }
+void AudioPreprocessor::LogMelToMfcc(const float *logMel, float *mfccOut,
+                                     int frames) {
+  dct->Compute(logMel, mfccOut, frames);
 }
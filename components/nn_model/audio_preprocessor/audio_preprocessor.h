@@ -24,8 +24,11 @@ extern "C" {
 #include <string.h>
 }
 
+#include "dct.h"
 #include "dsp/fast_math_functions.h"
-#include "dsp/transform_functions.h"
+#include "fft.h"
+#include "preproc_tables.h"
+#include <memory>
 #include <vector>
 
 #define M_2PI 6.283185307179586476925286766559005
@@ -42,16 +45,29 @@ private:
   std::vector<float> frame;
   std::vector<float> buffer;
   std::vector<float> melEnergies;
+  /*! \brief Window, filterbank and DCT matrix, generated or tables below. */
+  preproc_tables_t tables;
   std::vector<float> windowFunc;
   std::vector<int32_t> fbankFilterFirst;
   std::vector<int32_t> fbankFilterLast;
-  std::vector<std::vector<float>> melFbank;
-  std::vector<float> dctMatrix;
-  riscv_rfft_fast_instance_f32 fft;
-  static std::vector<float> CreateDctMatrix(int32_t inputLength,
-                                            int32_t coefficientCount);
-  std::vector<std::vector<float>> CreateMelFbank(int samp_freq, int melLowF,
-                                                 int melHighF);
+  std::vector<float> melFbank;
+  /*! \brief Log-mel rows of an MFCC batch. */
+  std::vector<float> melBatch;
+  /*! \brief PCEN parameters and smoothed mel energies, see PcenInit(). */
+  float pcenSmoothing = 0;
+  float pcenAlpha = 0;
+  float pcenDelta = 0;
+  float pcenRoot = 0;
+  float pcenEps = 0;
+  float pcenInputScale = 1;
+  std::vector<float> pcenState;
+  bool pcenStarted = false;
+  std::unique_ptr<DCT> dct;
+  std::unique_ptr<IFFT> fft;
+  void CreateMelFbank(int samp_freq, int melLowF, int melHighF);
+  void LoadFrame(const int16_t *pcm, size_t count, float scale);
+  void FrameLogMel(float *outData);
+  void FramePower(float *power);
 
   static inline float InverseMelScale(float melFreq) {
     return 700.0f * (expf(melFreq / 1127.0f) - 1.0f);
@@ -63,11 +79,104 @@ private:
 
 public:
   AudioPreprocessor(int samp_freq, int numMfccFeatures, int frameLen,
-                    int numFbankBins, int melLowF, int melHighF);
+                    int numFbankBins, int melLowF, int melHighF,
+                    bool padToPow2 = true,
+                    const preproc_tables_t *generated = nullptr);
   ~AudioPreprocessor() = default;
 
   void MfccCompute(const float *data, float *mfccOut);
   void LogMelCompute(const float *data, float *mfccOut);
+  /*!
+   * \brief MFCC of frames rows of numFbankBins log-mel energies, the rows are
+   * transformed in one batch.
+   */
+  void LogMelToMfcc(const float *logMel, float *mfccOut, int frames);
+
+  /*!
+   * \brief Log-mel energies of the frames of int16 samples, frame f starts at
+   * sample f * frameShift, samples past the end are zeros.
+   * \param pcm Samples.
+   * \param samples Number of samples.
+   * \param frameShift Samples between frames.
+   * \param scale Multiplier of the samples.
+   * \param out Rows of numFbankBins values.
+   * \param maxFrames Rows of out.
+   * \return Number of frames, the ones starting before the end of the
+   * samples up to maxFrames.
+   */
+  size_t LogMelBatch(const int16_t *pcm, size_t samples, size_t frameShift,
+                     float scale, float *out, size_t maxFrames);
+  /*!
+   * \brief MFCC of the frames of int16 samples, as LogMelBatch().
+   * \param out Rows of numMfccFeatures values.
+   */
+  size_t MfccBatch(const int16_t *pcm, size_t samples, size_t frameShift,
+                   float scale, float *out, size_t maxFrames);
+
+  /*! \brief Values of PowerSpectrum(), FFT length / 2 + 1. */
+  int SpectrumLen() const { return frameLenPadded / 2 + 1; }
+  /*!
+   * \brief Power spectrum of a windowed frame of int16 samples.
+   * \param pcm frameLen samples.
+   * \param scale Multiplier of the samples.
+   * \param power SpectrumLen() values.
+   */
+  void PowerSpectrum(const int16_t *pcm, float scale, float *power);
+  /*!
+   * \brief Log-mel energies of a power spectrum.
+   * \param power SpectrumLen() values.
+   * \param out numFbankBins values.
+   */
+  void PowerToLogMel(const float *power, float *out);
+  /*!
+   * \brief Mel energies of a power spectrum, the filterbank of the magnitude.
+   * \param power SpectrumLen() values.
+   * \param out numFbankBins values.
+   */
+  void PowerToMel(const float *power, float *out);
+
+  /*!
+   * \brief Configure per-channel energy normalization of the mel energies E:
+   * M = (1 - s) * M + s * E, PCEN = (E / (eps + M)^alpha + delta)^r -
+   * delta^r, M starts from E of the first frame.
+   * \param smoothing Smoothing coefficient s per frame, see PcenSmoothing().
+   * \param inputScale Multiplier of the mel energies.
+   * \param alpha Gain normalization exponent.
+   * \param delta Bias.
+   * \param root Compression exponent r.
+   * \param eps Floor of M.
+   */
+  void PcenInit(float smoothing, float inputScale = 1.f, float alpha = 0.98f,
+                float delta = 2.f, float root = 0.5f, float eps = 1e-6f);
+  /*! \brief Restart PCEN smoothing with the next frame. */
+  void PcenReset() { pcenStarted = false; }
+  /*!
+   * \brief PCEN smoothing coefficient of the time constant as librosa
+   * computes it.
+   * \param timeConstant Time constant, s.
+   * \param frameRate Frames per second.
+   */
+  static float PcenSmoothing(float timeConstant, float frameRate);
+  /*!
+   * \brief PCEN of a power spectrum, the next frame of the smoothing.
+   * \param power SpectrumLen() values.
+   * \param out numFbankBins values.
+   */
+  void PowerToPcen(const float *power, float *out);
+  /*!
+   * \brief PCEN of mel energies of PowerToMel(), the next frame of the
+   * smoothing.
+   * \param mel numFbankBins values.
+   * \param out numFbankBins values, may be mel.
+   */
+  void MelToPcen(const float *mel, float *out);
+  /*!
+   * \brief PCEN of the frames of int16 samples, as LogMelBatch(), the
+   * smoothing continues from the last frame.
+   * \param out Rows of numFbankBins values.
+   */
+  size_t PcenBatch(const int16_t *pcm, size_t samples, size_t frameShift,
+                   float scale, float *out, size_t maxFrames);
 };
 
 #endif
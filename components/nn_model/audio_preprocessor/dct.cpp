@@ -0,0 +1,121 @@
+#include <math.h>
+
+#include "dsp/fast_math_functions.h"
+#include "sdkconfig.h"
+
+#include "dct.h"
+
+#if CONFIG_NN_MODEL_FFT_ESP_DSP
+#include "dspm_mult.h"
+#endif
+
+DCT::DCT(int inputLength, int coefficientCount, const float *generated)
+  : inputLength(inputLength), coefficientCount(coefficientCount),
+    matrix(generated) {
+  const double normalizer = sqrt(2.0 / inputLength);
+  if (FFTIsFaster(inputLength, coefficientCount)) {
+    fft.reset(IFFT::Create(inputLength));
+    reordered.resize(inputLength);
+    spectrum.resize(inputLength);
+    rotation.resize(2 * coefficientCount);
+    for (int k = 0; k < coefficientCount; k++) {
+      const double phase = -M_PI * k / (2 * inputLength);
+      rotation[2 * k] = normalizer * cos(phase);
+      rotation[2 * k + 1] = normalizer * sin(phase);
+    }
+    return;
+  }
+
+  if (matrix) {
+    return;
+  }
+  matrixData.resize(inputLength * coefficientCount);
+  for (int n = 0; n < inputLength; n++) {
+    for (int k = 0; k < coefficientCount; k++) {
+      matrixData[n * coefficientCount + k] =
+        normalizer * riscv_cos_f32(M_PI / inputLength * (n + 0.5) * k);
+    }
+  }
+  matrix = matrixData.data();
+}
+
+bool DCT::FFTIsFaster(int inputLength, int coefficientCount) {
+  if (!FFTMixedRadix::Supported(inputLength)) {
+    return false;
+  }
+  // N * K multiply-adds against an N point FFT plus reordering and rotation,
+  // the crossover is about K = 4 * log2(N) with the portable and mixed-radix
+  // backends
+  const float log2n = log2f(inputLength);
+  return coefficientCount > 4 * log2n;
+}
+
+void DCT::Compute(const float *in, float *out, int frames) {
+  if (!fft) {
+    MatrixCompute(in, out, frames);
+    return;
+  }
+  for (int f = 0; f < frames; f++) {
+    FFTCompute(&in[f * inputLength], &out[f * coefficientCount]);
+  }
+}
+
+void DCT::MatrixCompute(const float *in, float *out, int frames) {
+#if CONFIG_NN_MODEL_FFT_ESP_DSP
+  // [frames x N] * [N x K], one call for the whole batch
+  dspm_mult_f32(in, matrix, out, frames, inputLength,
+                coefficientCount);
+#else
+  const int n4 = inputLength & ~3;
+  for (int f = 0; f < frames; f++) {
+    const float *x = &in[f * inputLength];
+    float *y = &out[f * coefficientCount];
+    for (int k = 0; k < coefficientCount; k++) {
+      const float *m = &matrix[k];
+      const int stride = coefficientCount;
+      float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+      int n = 0;
+      for (; n < n4; n += 4) {
+        s0 += x[n] * m[n * stride];
+        s1 += x[n + 1] * m[(n + 1) * stride];
+        s2 += x[n + 2] * m[(n + 2) * stride];
+        s3 += x[n + 3] * m[(n + 3) * stride];
+      }
+      for (; n < inputLength; n++) {
+        s0 += x[n] * m[n * stride];
+      }
+      y[k] = (s0 + s1) + (s2 + s3);
+    }
+  }
+#endif
+}
+
+void DCT::FFTCompute(const float *in, float *out) {
+  // Makhoul: v = even samples, then odd ones reversed,
+  // X[k] = Re(exp(-j * pi * k / 2N) * FFT(v)[k])
+  const int half = inputLength / 2;
+  for (int n = 0; n < half; n++) {
+    reordered[n] = in[2 * n];
+    reordered[inputLength - 1 - n] = in[2 * n + 1];
+  }
+  fft->Forward(reordered.data(), spectrum.data());
+
+  for (int k = 0; k < coefficientCount; k++) {
+    float re, im;
+    if (k == 0) {
+      re = spectrum[0];
+      im = 0;
+    } else if (k == half) {
+      re = spectrum[1];
+      im = 0;
+    } else if (k < half) {
+      re = spectrum[2 * k];
+      im = spectrum[2 * k + 1];
+    } else {
+      // spectrum of real input: V[k] = conj(V[N - k])
+      re = spectrum[2 * (inputLength - k)];
+      im = -spectrum[2 * (inputLength - k) + 1];
+    }
+    out[k] = re * rotation[2 * k] - im * rotation[2 * k + 1];
+  }
+}
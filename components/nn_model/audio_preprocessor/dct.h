@@ -0,0 +1,53 @@
+#ifndef _DCT_H_
+#define _DCT_H_
+
+#include <memory>
+#include <vector>
+
+#include "fft.h"
+
+/*!
+ * \brief DCT-II of log-mel rows as in the TensorFlow MFCC op:
+ * out[k] = sqrt(2 / N) * sum(in[n] * cos(pi / N * (n + 0.5) * k)), k < K.
+ * Small transforms, as the ones of the current models (N = 40, K = 10), are
+ * a matrix multiply (esp-dsp dspm_mult_f32 with the esp-dsp FFT backend,
+ * unrolled C++ otherwise); larger ones use an FFT of N points.
+ */
+class DCT {
+public:
+  /*!
+   * \brief Constructor.
+   * \param inputLength N, values per input row.
+   * \param coefficientCount K, values per output row.
+   * \param generated Generated matrix as the one below, nullptr - compute it.
+   */
+  DCT(int inputLength, int coefficientCount,
+      const float *generated = nullptr);
+
+  /*!
+   * \brief Transform rows.
+   * \param in frames rows of N values.
+   * \param out frames rows of K values.
+   * \param frames Number of rows.
+   */
+  void Compute(const float *in, float *out, int frames = 1);
+  bool UsesFFT() const { return fft != nullptr; }
+
+private:
+  static bool FFTIsFaster(int inputLength, int coefficientCount);
+  void MatrixCompute(const float *in, float *out, int frames);
+  void FFTCompute(const float *in, float *out);
+
+  const int inputLength;
+  const int coefficientCount;
+  /*! \brief inputLength x coefficientCount, transposed DCT matrix. */
+  const float *matrix;
+  std::vector<float> matrixData;
+  std::unique_ptr<IFFT> fft;
+  std::vector<float> reordered;
+  std::vector<float> spectrum;
+  /*! \brief sqrt(2 / N) * exp(-j * pi * k / 2N), k < K. */
+  std::vector<float> rotation;
+};
+
+#endif // _DCT_H_
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "fft.h"
+
+static const char *TAG = "fft";
+
+IFFT *IFFT::Create(int len) {
+  if (len & (len - 1)) {
+    if (!FFTMixedRadix::Supported(len)) {
+      ESP_LOGE(TAG, "no FFT of %d samples", len);
+      return NULL;
+    }
+    return new FFTMixedRadix(len);
+  }
+#if CONFIG_NN_MODEL_FFT_ESP_DSP
+  if (FFTEspDsp::Init(len) == 0) {
+    return new FFTEspDsp(len);
+  }
+  ESP_LOGW(TAG, "esp-dsp FFT of %d is not available, using portable one",
+           len);
+  return new FFTPortable(len);
+#elif CONFIG_NN_MODEL_FFT_PORTABLE
+  return new FFTPortable(len);
+#else
+  return new FFTNmsis(len);
+#endif
+}
+
+FFTNmsis::FFTNmsis(int len) : IFFT(len) {
+  if (riscv_rfft_fast_init_f32(&rfft_, len) != RISCV_MATH_SUCCESS) {
+    ESP_LOGE(TAG, "unsupported NMSIS FFT length %d", len);
+  }
+}
+
+void FFTNmsis::Forward(float *in, float *out) {
+  riscv_rfft_fast_f32(&rfft_, in, out, 0);
+}
+
+FFTHalfComplex::FFTHalfComplex(int len) : IFFT(len), twiddle_(len) {
+  for (int k = 0; k < len / 2; k++) {
+    const double phase = 2 * M_PI * k / len;
+    twiddle_[2 * k] = cos(phase);
+    twiddle_[2 * k + 1] = sin(phase);
+  }
+}
+
+void FFTHalfComplex::Forward(float *in, float *out) {
+  ComplexForward(in);
+
+  // Z = FFT(x[2n] + j * x[2n + 1]), X[k] = E[k] + W^k * O[k], where
+  // E[k] = (Z[k] + conj(Z[M - k])) / 2, O[k] = (Z[k] - conj(Z[M - k])) / 2j
+  const int half = len_ / 2;
+  out[0] = in[0] + in[1];
+  out[1] = in[0] - in[1];
+  for (int k = 1; k < half; k++) {
+    const float ar = in[2 * k], ai = in[2 * k + 1];
+    const float br = in[2 * (half - k)], bi = -in[2 * (half - k) + 1];
+    const float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+    const float or_ = 0.5f * (ai - bi), oi = -0.5f * (ar - br);
+    const float c = twiddle_[2 * k], s = twiddle_[2 * k + 1];
+    out[2 * k] = er + c * or_ + s * oi;
+    out[2 * k + 1] = ei + c * oi - s * or_;
+  }
+}
+
+FFTPortable::FFTPortable(int len) : FFTHalfComplex(len) {
+  const int points = len / 2;
+  int bits = 0;
+  while ((1 << bits) < points) {
+    bits++;
+  }
+  for (int i = 0; i < points; i++) {
+    int j = 0;
+    for (int b = 0; b < bits; b++) {
+      j |= ((i >> b) & 1) << (bits - 1 - b);
+    }
+    if (i < j) {
+      bitrev_.push_back(i);
+      bitrev_.push_back(j);
+    }
+  }
+}
+
+void FFTPortable::ComplexForward(float *data) {
+  for (size_t i = 0; i < bitrev_.size(); i += 2) {
+    float *a = &data[2 * bitrev_[i]];
+    float *b = &data[2 * bitrev_[i + 1]];
+    const float re = a[0], im = a[1];
+    a[0] = b[0];
+    a[1] = b[1];
+    b[0] = re;
+    b[1] = im;
+  }
+
+  const int points = len_ / 2;
+  for (int size = 2; size <= points; size *= 2) {
+    const int half = size / 2;
+    // W_points^j = W_len^(2j)
+    const int step = 2 * (points / size);
+    for (int j = 0; j < half; j++) {
+      const float wr = twiddle_[2 * j * step];
+      const float wi = -twiddle_[2 * j * step + 1];
+      for (int start = j; start < points; start += size) {
+        float *a = &data[2 * start];
+        float *b = &data[2 * (start + half)];
+        const float tr = wr * b[0] - wi * b[1];
+        const float ti = wr * b[1] + wi * b[0];
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+bool FFTMixedRadix::Supported(int len) {
+  if (len < 4 || len % 2) {
+    return false;
+  }
+  int n = len / 2;
+  for (int p : {2, 3, 5}) {
+    while (n % p == 0) {
+      n /= p;
+    }
+  }
+  return n == 1;
+}
+
+FFTMixedRadix::FFTMixedRadix(int len)
+  : FFTHalfComplex(len), points_(len / 2), cpx_twiddle_(points_),
+    scratch_(points_) {
+  for (int k = 0; k < points_; k++) {
+    const double phase = -2 * M_PI * k / points_;
+    cpx_twiddle_[k] = {float(cos(phase)), float(sin(phase))};
+  }
+  // radix 4 first, the rest of the length goes to the next stages
+  int n = points_;
+  int p = 4;
+  while (n > 1) {
+    while (n % p) {
+      p = p == 4 ? 2 : p == 2 ? 3 : p + 2;
+      if (p * p > n) {
+        p = n;
+      }
+    }
+    n /= p;
+    factors_.push_back(p);
+    factors_.push_back(n);
+  }
+}
+
+void FFTMixedRadix::ComplexForward(float *data) {
+  cpx_t *x = reinterpret_cast<cpx_t *>(data);
+  std::copy(x, x + points_, scratch_.begin());
+  Work(x, scratch_.data(), 1, factors_.data());
+}
+
+void FFTMixedRadix::Work(cpx_t *out, const cpx_t *in, int stride,
+                         const int *factors) {
+  // decimation in time: p interleaved sub-transforms of m points each
+  const int p = factors[0];
+  const int m = factors[1];
+  if (m == 1) {
+    for (int i = 0; i < p; i++) {
+      out[i] = in[i * stride];
+    }
+  } else {
+    for (int i = 0; i < p; i++) {
+      Work(&out[i * m], &in[i * stride], stride * p, factors + 2);
+    }
+  }
+
+  switch (p) {
+  case 2:
+    Butterfly2(out, stride, m);
+    break;
+  case 4:
+    Butterfly4(out, stride, m);
+    break;
+  case 5:
+    Butterfly5(out, stride, m);
+    break;
+  default:
+    ButterflyGeneric(out, stride, m, p);
+    break;
+  }
+}
+
+typedef FFTMixedRadix::cpx_t cpx_t;
+
+static inline cpx_t cmul(const cpx_t &a, const cpx_t &b) {
+  return {a.r * b.r - a.i * b.i, a.r * b.i + a.i * b.r};
+}
+
+void FFTMixedRadix::Butterfly2(cpx_t *out, int stride, int m) {
+  cpx_t *out2 = out + m;
+  for (int k = 0; k < m; k++) {
+    const cpx_t t = cmul(out2[k], cpx_twiddle_[k * stride]);
+    out2[k] = {out[k].r - t.r, out[k].i - t.i};
+    out[k].r += t.r;
+    out[k].i += t.i;
+  }
+}
+
+void FFTMixedRadix::Butterfly4(cpx_t *out, int stride, int m) {
+  for (int k = 0; k < m; k++) {
+    const cpx_t s0 = cmul(out[k + m], cpx_twiddle_[k * stride]);
+    const cpx_t s1 = cmul(out[k + 2 * m], cpx_twiddle_[2 * k * stride]);
+    const cpx_t s2 = cmul(out[k + 3 * m], cpx_twiddle_[3 * k * stride]);
+    const cpx_t s5 = {out[k].r - s1.r, out[k].i - s1.i};
+    const cpx_t s0p = {out[k].r + s1.r, out[k].i + s1.i};
+    const cpx_t s3 = {s0.r + s2.r, s0.i + s2.i};
+    const cpx_t s4 = {s0.r - s2.r, s0.i - s2.i};
+    out[k] = {s0p.r + s3.r, s0p.i + s3.i};
+    out[k + m] = {s5.r + s4.i, s5.i - s4.r};
+    out[k + 2 * m] = {s0p.r - s3.r, s0p.i - s3.i};
+    out[k + 3 * m] = {s5.r - s4.i, s5.i + s4.r};
+  }
+}
+
+void FFTMixedRadix::Butterfly5(cpx_t *out, int stride, int m) {
+  // exp(-2 * pi * j / 5) and exp(-4 * pi * j / 5)
+  const cpx_t ya = cpx_twiddle_[stride * m];
+  const cpx_t yb = cpx_twiddle_[2 * stride * m];
+  for (int u = 0; u < m; u++) {
+    const cpx_t s0 = out[u];
+    const cpx_t s1 = cmul(out[u + m], cpx_twiddle_[u * stride]);
+    const cpx_t s2 = cmul(out[u + 2 * m], cpx_twiddle_[2 * u * stride]);
+    const cpx_t s3 = cmul(out[u + 3 * m], cpx_twiddle_[3 * u * stride]);
+    const cpx_t s4 = cmul(out[u + 4 * m], cpx_twiddle_[4 * u * stride]);
+    const cpx_t s7 = {s1.r + s4.r, s1.i + s4.i};
+    const cpx_t s10 = {s1.r - s4.r, s1.i - s4.i};
+    const cpx_t s8 = {s2.r + s3.r, s2.i + s3.i};
+    const cpx_t s9 = {s2.r - s3.r, s2.i - s3.i};
+
+    out[u] = {s0.r + s7.r + s8.r, s0.i + s7.i + s8.i};
+
+    const cpx_t s5 = {s0.r + s7.r * ya.r + s8.r * yb.r,
+                      s0.i + s7.i * ya.r + s8.i * yb.r};
+    const cpx_t s6 = {s10.i * ya.i + s9.i * yb.i,
+                      -s10.r * ya.i - s9.r * yb.i};
+    out[u + m] = {s5.r - s6.r, s5.i - s6.i};
+    out[u + 4 * m] = {s5.r + s6.r, s5.i + s6.i};
+
+    const cpx_t s11 = {s0.r + s7.r * yb.r + s8.r * ya.r,
+                       s0.i + s7.i * yb.r + s8.i * ya.r};
+    const cpx_t s12 = {-s10.i * yb.i + s9.i * ya.i,
+                       s10.r * yb.i - s9.r * ya.i};
+    out[u + 2 * m] = {s11.r + s12.r, s11.i + s12.i};
+    out[u + 3 * m] = {s11.r - s12.r, s11.i - s12.i};
+  }
+}
+
+void FFTMixedRadix::ButterflyGeneric(cpx_t *out, int stride, int m, int p) {
+  // radix 3, Supported() limits p to 5
+  assert(p <= 5);
+  cpx_t tmp[5];
+  for (int u = 0; u < m; u++) {
+    for (int q = 0; q < p; q++) {
+      tmp[q] = out[u + q * m];
+    }
+    for (int q1 = 0; q1 < p; q1++) {
+      const int k = u + q1 * m;
+      cpx_t sum = tmp[0];
+      int tw = 0;
+      for (int q = 1; q < p; q++) {
+        tw += stride * k;
+        if (tw >= points_) {
+          tw -= points_;
+        }
+        const cpx_t t = cmul(tmp[q], cpx_twiddle_[tw]);
+        sum.r += t.r;
+        sum.i += t.i;
+      }
+      out[k] = sum;
+    }
+  }
+}
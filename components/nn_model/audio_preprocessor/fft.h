@@ -0,0 +1,158 @@
+#ifndef _FFT_H_
+#define _FFT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "dsp/transform_functions.h"
+
+/*!
+ * \brief Real forward FFT of len samples. The spectrum
+ * is packed as by riscv_rfft_fast_f32: [re(0), re(len/2), re(1), im(1), ...,
+ * re(len/2-1), im(len/2-1)], not scaled.
+ */
+class IFFT {
+public:
+  /*!
+   * \brief Constructor.
+   * \param len Number of samples.
+   */
+  explicit IFFT(int len) : len_(len) {}
+  virtual ~IFFT() = default;
+  /*!
+   * \brief Compute spectrum.
+   * \param in len samples, overwritten.
+   * \param out len packed spectrum values.
+   */
+  virtual void Forward(float *in, float *out) = 0;
+  /*! \brief Backend name. */
+  virtual const char *Name() const = 0;
+  int Len() const { return len_; }
+
+  /*!
+   * \brief Create the backend selected by CONFIG_NN_MODEL_FFT_*, NMSIS if
+   * there is no such config (host tools). Lengths other than powers of 2 get
+   * FFTMixedRadix.
+   * \param len Number of samples.
+   * \return FFT, NULL if len is not a power of 2 and not
+   * FFTMixedRadix::Supported().
+   */
+  static IFFT *Create(int len);
+
+protected:
+  const int len_;
+};
+
+/*! \brief NMSIS riscv_rfft_fast_f32, generic C on Xtensa and on the host. */
+class FFTNmsis final : public IFFT {
+public:
+  explicit FFTNmsis(int len);
+  void Forward(float *in, float *out) override;
+  const char *Name() const override { return "nmsis"; }
+
+private:
+  riscv_rfft_fast_instance_f32 rfft_;
+};
+
+/*!
+ * \brief Real FFT of len samples (even) as a complex FFT of len/2 points: even
+ * samples are the real parts, odd ones are the imaginary parts, the halves
+ * of the spectrum are split afterwards.
+ */
+class FFTHalfComplex : public IFFT {
+public:
+  explicit FFTHalfComplex(int len);
+  void Forward(float *in, float *out) override final;
+
+protected:
+  /*!
+   * \brief In place complex FFT of len/2 interleaved points, natural order
+   * output.
+   * \param data len values.
+   */
+  virtual void ComplexForward(float *data) = 0;
+  /*! \brief cos and sin of 2 * pi * k / len, k < len/2. */
+  std::vector<float> twiddle_;
+};
+
+/*! \brief Radix-2 FFT in plain C++. */
+class FFTPortable final : public FFTHalfComplex {
+public:
+  explicit FFTPortable(int len);
+  const char *Name() const override { return "portable"; }
+
+protected:
+  void ComplexForward(float *data) override;
+
+private:
+  /*! \brief Index pairs swapped by the bit reversal. */
+  std::vector<uint16_t> bitrev_;
+};
+
+/*!
+ * \brief Mixed-radix FFT for lengths other than powers of 2, e.g. 640 of
+ * 40 ms windows at 16 kHz. len/2 is factored into radices 4, 2, 3 and 5.
+ */
+class FFTMixedRadix final : public FFTHalfComplex {
+public:
+  explicit FFTMixedRadix(int len);
+  const char *Name() const override { return "mixed-radix"; }
+  /*!
+   * \brief Check the length is even and len/2 has no prime factors over 5.
+   * \param len Number of samples.
+   */
+  static bool Supported(int len);
+
+  struct cpx_t {
+    float r, i;
+  };
+
+protected:
+  void ComplexForward(float *data) override;
+
+private:
+  void Work(cpx_t *out, const cpx_t *in, int stride, const int *factors);
+  void Butterfly2(cpx_t *out, int stride, int m);
+  void Butterfly4(cpx_t *out, int stride, int m);
+  void Butterfly5(cpx_t *out, int stride, int m);
+  void ButterflyGeneric(cpx_t *out, int stride, int m, int p);
+
+  const int points_;
+  /*! \brief Pairs of radix and the remaining length. */
+  std::vector<int> factors_;
+  /*! \brief exp(-2 * pi * j * k / points_). */
+  std::vector<cpx_t> cpx_twiddle_;
+  std::vector<cpx_t> scratch_;
+};
+
+/*!
+ * \brief esp-dsp dsps_fft2r_fc32, assembly optimized on ESP32 and ESP32-S3.
+ * Not available in the host builds.
+ */
+class FFTEspDsp final : public FFTHalfComplex {
+public:
+  explicit FFTEspDsp(int len);
+  ~FFTEspDsp() override;
+  const char *Name() const override { return "esp-dsp"; }
+  /*!
+   * \brief Initialize esp-dsp tables, reference counted with the instances.
+   * \param len Number of samples.
+   * \return Result.
+   */
+  static int Init(int len);
+
+protected:
+  void ComplexForward(float *data) override;
+};
+
+/*!
+ * \brief Time the backends available in the build at the given lengths and
+ * log time per transform and the difference to FFTNmsis.
+ * \param lens FFT lengths.
+ * \param lens_num Number of lengths.
+ * \param iterations Transforms per length and backend.
+ */
+void fft_benchmark(const int *lens, size_t lens_num, size_t iterations);
+
+#endif // _FFT_H_
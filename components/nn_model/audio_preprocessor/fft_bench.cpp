@@ -0,0 +1,62 @@
+#include <math.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "fft.h"
+
+static const char *TAG = "fft_bench";
+
+static void bench(IFFT *fft, const std::vector<float> &signal,
+                  const std::vector<float> &ref, size_t iterations) {
+  const int len = fft->Len();
+  std::vector<float> in(len);
+  std::vector<float> out(len);
+
+  // the input is overwritten, the copy is timed too as AudioPreprocessor
+  // copies the frame the same way
+  const int64_t t1 = esp_timer_get_time();
+  for (size_t i = 0; i < iterations; i++) {
+    memcpy(in.data(), signal.data(), len * sizeof(float));
+    fft->Forward(in.data(), out.data());
+  }
+  const int64_t us = esp_timer_get_time() - t1;
+
+  float err = 0, peak = 0;
+  for (int i = 0; i < len; i++) {
+    err = fmaxf(err, fabsf(out[i] - ref[i]));
+    peak = fmaxf(peak, fabsf(ref[i]));
+  }
+  ESP_LOGI(TAG, "%5d %-8s %8.1f us, max error %.1e", len, fft->Name(),
+           double(us) / iterations, double(err / peak));
+}
+
+void fft_benchmark(const int *lens, size_t lens_num, size_t iterations) {
+  for (size_t l = 0; l < lens_num; l++) {
+    const int len = lens[l];
+    // tone and pseudo random noise
+    std::vector<float> signal(len);
+    uint32_t seed = 1;
+    for (int i = 0; i < len; i++) {
+      seed = seed * 1664525 + 1013904223;
+      signal[i] = 0.5f * sinf(0.3f * i) + float(seed >> 8) / (1 << 24) - 0.5f;
+    }
+
+    FFTNmsis nmsis(len);
+    std::vector<float> in(signal);
+    std::vector<float> ref(len);
+    nmsis.Forward(in.data(), ref.data());
+
+    bench(&nmsis, signal, ref, iterations);
+    FFTPortable portable(len);
+    bench(&portable, signal, ref, iterations);
+#if !CONFIG_IDF_TARGET_LINUX
+    if (FFTEspDsp::Init(len) == 0) {
+      FFTEspDsp esp_dsp(len);
+      bench(&esp_dsp, signal, ref, iterations);
+    }
+#endif
+  }
+}
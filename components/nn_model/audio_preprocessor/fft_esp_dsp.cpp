@@ -0,0 +1,39 @@
+#include "dsps_fft2r.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include "fft.h"
+
+static const char *TAG = "fft";
+
+/*! \brief Instances using the esp-dsp table, it is freed by the last one. */
+static size_t s_ref_count = 0;
+
+int FFTEspDsp::Init(int len) {
+  if (len / 2 > CONFIG_DSP_MAX_FFT_SIZE) {
+    ESP_LOGE(TAG, "FFT of %d exceeds CONFIG_DSP_MAX_FFT_SIZE", len);
+    return -1;
+  }
+  if (s_ref_count == 0) {
+    const esp_err_t ret = dsps_fft2r_init_fc32(NULL, CONFIG_DSP_MAX_FFT_SIZE);
+    if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "dsps_fft2r_init_fc32 error %d", ret);
+      return -1;
+    }
+  }
+  s_ref_count++;
+  return 0;
+}
+
+FFTEspDsp::FFTEspDsp(int len) : FFTHalfComplex(len) {}
+
+FFTEspDsp::~FFTEspDsp() {
+  if (s_ref_count && --s_ref_count == 0) {
+    dsps_fft2r_deinit_fc32();
+  }
+}
+
+void FFTEspDsp::ComplexForward(float *data) {
+  dsps_fft2r_fc32(data, len_ / 2);
+  dsps_bit_rev_fc32(data, len_ / 2);
+}
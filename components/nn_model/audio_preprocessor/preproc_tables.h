@@ -0,0 +1,32 @@
+#ifndef _PREPROC_TABLES_H_
+#define _PREPROC_TABLES_H_
+
+#include <stdint.h>
+
+/*!
+ * \brief Window, mel filterbank and DCT of one AudioPreprocessor
+ * configuration, generated at build time by tools/gen_preproc_tables.py so
+ * they stay in flash. The fields before the tables are the configuration.
+ */
+struct preproc_tables_t {
+  int samp_freq;
+  int frame_len;
+  /*! \brief FFT length, frame_len rounded up to a power of 2 or frame_len. */
+  int fft_len;
+  int num_fbank_bins;
+  /*! \brief DCT coefficients, 0 - no DCT matrix. */
+  int num_mfcc;
+  int mel_low_freq;
+  int mel_high_freq;
+  /*! \brief Hann window, frame_len values. */
+  const float *window;
+  /*! \brief First and last FFT bin of every filter, num_fbank_bins values. */
+  const int32_t *fbank_first;
+  const int32_t *fbank_last;
+  /*! \brief Filter weights, last - first + 1 values per filter. */
+  const float *fbank_weights;
+  /*! \brief num_fbank_bins x num_mfcc, transposed DCT matrix. */
+  const float *dct_matrix;
+};
+
+#endif // _PREPROC_TABLES_H_
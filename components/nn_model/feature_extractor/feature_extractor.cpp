@@ -0,0 +1,156 @@
+#include <math.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "feature_extractor.h"
+
+static const char *TAG = "feature_extractor";
+
+// log energy of silence in the training pipeline
+#define SILENCE_LOG_ENERGY (-27.631021f) // logf(1e-12f)
+/*! \brief PCEN smoothing time constant, s. */
+#define PCEN_TIME_CONSTANT 0.4f
+/*!
+ * \brief PCEN input scale, int16 samples to the int32 range as librosa
+ * expects of the mel magnitudes.
+ */
+#define PCEN_INPUT_SCALE 65536.f
+
+static size_t frame_len(const nn_model_preproc_t &preproc, int sample_rate) {
+  return sample_rate / 1000 * preproc.win_ms;
+}
+
+static size_t frame_shift(const nn_model_preproc_t &preproc,
+                          int sample_rate) {
+  return sample_rate / 1000 * preproc.stride_ms;
+}
+
+static size_t frame_num(const nn_model_preproc_t &preproc) {
+  return (preproc.duration_ms - preproc.win_ms) / preproc.stride_ms + 1;
+}
+
+static size_t num_coeffs(const nn_model_preproc_t &preproc) {
+  return preproc.features == NN_MODEL_FEATURES_MFCC ? preproc.num_mfcc
+                                                    : preproc.num_fbank_bins;
+}
+
+int FeatureExtractor::Validate(const nn_model_desc_t *desc, int sample_rate) {
+  const nn_model_preproc_t &preproc = desc->preproc;
+  if (preproc.win_ms == 0 || preproc.stride_ms == 0 ||
+      preproc.stride_ms > preproc.win_ms ||
+      preproc.duration_ms < preproc.win_ms || preproc.num_fbank_bins == 0 ||
+      preproc.features > NN_MODEL_FEATURES_PCEN ||
+      preproc.norm > NN_MODEL_NORM_FULL_SCALE ||
+      preproc.fft_len > NN_MODEL_FFT_LEN_WINDOW ||
+      (preproc.features == NN_MODEL_FEATURES_MFCC &&
+       (preproc.num_mfcc == 0 ||
+        preproc.num_mfcc > preproc.num_fbank_bins)) ||
+      desc->mel_high_freq > size_t(sample_rate / 2)) {
+    ESP_LOGE(TAG, "unsupported preprocessing config");
+    return -1;
+  }
+  if (preproc.fft_len == NN_MODEL_FFT_LEN_WINDOW &&
+      !FFTMixedRadix::Supported(frame_len(preproc, sample_rate))) {
+    ESP_LOGE(TAG, "no FFT of %u samples",
+             unsigned(frame_len(preproc, sample_rate)));
+    return -1;
+  }
+  return 0;
+}
+
+FeatureExtractor::FeatureExtractor(const nn_model_desc_t *desc,
+                                   int sample_rate,
+                                   const preproc_tables_t *tables)
+  : preproc(desc->preproc), frameLen(frame_len(preproc, sample_rate)),
+    frameShift(frame_shift(preproc, sample_rate)),
+    frameNum(frame_num(preproc)), numCoeffs(num_coeffs(preproc)),
+    featuresLen(frameNum * numCoeffs),
+    pp(sample_rate,
+       preproc.features == NN_MODEL_FEATURES_MFCC ? preproc.num_mfcc : 0,
+       frameLen, preproc.num_fbank_bins, desc->mel_low_freq,
+       desc->mel_high_freq, preproc.fft_len == NN_MODEL_FFT_LEN_POW2, tables),
+    logMel(preproc.num_fbank_bins), silence(numCoeffs, 0.f) {
+  if (preproc.features == NN_MODEL_FEATURES_PCEN) {
+    // PCEN of silence is 0
+    pp.PcenInit(AudioPreprocessor::PcenSmoothing(
+                  PCEN_TIME_CONSTANT, float(sample_rate) / frameShift),
+                PCEN_INPUT_SCALE);
+  } else if (preproc.features == NN_MODEL_FEATURES_MFCC) {
+    // DCT of a constant log-mel row has only the first coefficient
+    silence[0] = sqrtf(2.f * preproc.num_fbank_bins) * SILENCE_LOG_ENERGY;
+  } else {
+    for (auto &v : silence) {
+      v = SILENCE_LOG_ENERGY;
+    }
+  }
+}
+
+void FeatureExtractor::Compute(const int16_t *samples, float norm,
+                               float *out) {
+  ComputeBatch(samples, frameLen, norm, out, 1);
+}
+
+size_t FeatureExtractor::ComputeBatch(const int16_t *pcm, size_t samples,
+                                      float norm, float *out,
+                                      size_t max_frames) {
+  if (preproc.features == NN_MODEL_FEATURES_MFCC) {
+    return pp.MfccBatch(pcm, samples, frameShift, 1.f / norm, out,
+                        max_frames);
+  } else if (preproc.features == NN_MODEL_FEATURES_PCEN) {
+    return pp.PcenBatch(pcm, samples, frameShift, 1.f, out, max_frames);
+  }
+  return pp.LogMelBatch(pcm, samples, frameShift, 1.f / norm, out,
+                        max_frames);
+}
+
+void FeatureExtractor::Spectrum(const int16_t *samples, float *power) {
+  pp.PowerSpectrum(samples, 1.f, power);
+}
+
+void FeatureExtractor::SpectrumFeatures(const float *power, float *out) {
+  if (preproc.features == NN_MODEL_FEATURES_MFCC) {
+    pp.PowerToLogMel(power, logMel.data());
+    pp.LogMelToMfcc(logMel.data(), out, 1);
+  } else if (preproc.features == NN_MODEL_FEATURES_PCEN) {
+    // PCEN of the segment rows in Normalize()
+    pp.PowerToMel(power, out);
+  } else {
+    pp.PowerToLogMel(power, out);
+  }
+}
+
+void FeatureExtractor::Normalize(float *features, size_t frames,
+                                 float norm) {
+  if (preproc.features == NN_MODEL_FEATURES_PCEN) {
+    for (size_t f = 0; f < frames; f++) {
+      pp.MelToPcen(&features[f * numCoeffs], &features[f * numCoeffs]);
+    }
+    return;
+  }
+  const float offset = -logf(norm);
+  for (size_t f = 0; f < frames; f++) {
+    float *row = &features[f * numCoeffs];
+    if (preproc.features == NN_MODEL_FEATURES_MFCC) {
+      // DCT of a constant log-mel row has only the first coefficient
+      row[0] += sqrtf(2.f * preproc.num_fbank_bins) * offset;
+    } else {
+      for (size_t i = 0; i < numCoeffs; i++) {
+        row[i] += offset;
+      }
+    }
+  }
+}
+
+float FeatureExtractor::Norm(size_t max_abs) const {
+  if (preproc.norm == NN_MODEL_NORM_PEAK) {
+    return max_abs ? float(max_abs) : 1.f;
+  }
+  return float(1 << 15);
+}
+
+void FeatureExtractor::Reset() { pp.PcenReset(); }
+
+void FeatureExtractor::Silence(float *out) const {
+  memcpy(out, silence.data(), numCoeffs * sizeof(float));
+}
@@ -0,0 +1,113 @@
+#ifndef _FEATURE_EXTRACTOR_H_
+#define _FEATURE_EXTRACTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "audio_preprocessor.h"
+#include "nn_model.h"
+
+/*!
+ * \brief Feature pipeline configured from the model description, frames of
+ * int16 samples to MFCC, log-mel or PCEN rows. PCEN rows depend on the
+ * previous frames, they are computed in order from Reset().
+ */
+class FeatureExtractor {
+public:
+  /*!
+   * \brief Constructor.
+   * \param desc Model description.
+   * \param sample_rate Input sample rate.
+   * \param tables Generated tables, used if they match the configuration.
+   */
+  FeatureExtractor(const nn_model_desc_t *desc, int sample_rate,
+                   const preproc_tables_t *tables = NULL);
+  ~FeatureExtractor() = default;
+
+  /*!
+   * \brief Check the description has a usable preprocessing config.
+   * \param desc Model description.
+   * \param sample_rate Input sample rate.
+   * \return Result.
+   */
+  static int Validate(const nn_model_desc_t *desc, int sample_rate);
+
+  /*!
+   * \brief Compute features of a frame.
+   * \param samples frameLen samples.
+   * \param norm Divisor of samples, see Norm(), PCEN ignores it.
+   * \param out numCoeffs features.
+   */
+  void Compute(const int16_t *samples, float norm, float *out);
+  /*!
+   * \brief Compute features of consecutive frames, frame f starts at sample
+   * f * frameShift, samples past the end are zeros.
+   * \param pcm Samples.
+   * \param samples Number of samples.
+   * \param norm Divisor of samples, see Norm().
+   * \param out Rows of numCoeffs features.
+   * \param max_frames Rows of out.
+   * \return Number of frames, the ones starting before the end of the
+   * samples up to max_frames.
+   */
+  size_t ComputeBatch(const int16_t *pcm, size_t samples, float norm,
+                      float *out, size_t max_frames);
+  /*! \brief Values of Spectrum(). */
+  size_t SpectrumLen() const { return pp.SpectrumLen(); }
+  /*!
+   * \brief Power spectrum of a frame, samples are not normalized.
+   * \param samples frameLen samples.
+   * \param power SpectrumLen() values.
+   */
+  void Spectrum(const int16_t *samples, float *power);
+  /*!
+   * \brief Features of a power spectrum of Spectrum(), for spectral
+   * processing between the two, e.g. noise suppression.
+   * \param power SpectrumLen() values.
+   * \param out numCoeffs features, not normalized, see Normalize(). Mel
+   * energies for PCEN.
+   */
+  void SpectrumFeatures(const float *power, float *out);
+  /*!
+   * \brief Normalize features of samples that are not normalized, the
+   * samples scale is a constant offset of the log-mel energies. PCEN is
+   * applied to the mel energies of the rows in order, from Reset() at the
+   * start of a segment.
+   * \param features Rows of numCoeffs features.
+   * \param frames Number of rows.
+   * \param norm Divisor of samples, see Norm().
+   */
+  void Normalize(float *features, size_t frames, float norm);
+  /*!
+   * \brief Divisor of samples as the model is trained with.
+   * \param max_abs Peak of the segment.
+   * \return Divisor.
+   */
+  float Norm(size_t max_abs) const;
+  /*!
+   * \brief Features of a silent frame, used to pad short segments.
+   * \param out numCoeffs features.
+   */
+  void Silence(float *out) const;
+  /*!
+   * \brief Start PCEN smoothing from the next frame, e.g. at a new segment.
+   */
+  void Reset();
+
+  const nn_model_preproc_t preproc;
+  /*! \brief Samples per frame and between frames. */
+  const size_t frameLen;
+  const size_t frameShift;
+  /*! \brief Frames per model input and features per frame. */
+  const size_t frameNum;
+  const size_t numCoeffs;
+  const size_t featuresLen;
+
+private:
+  AudioPreprocessor pp;
+  std::vector<float> logMel;
+  std::vector<float> silence;
+};
+
+#endif // _FEATURE_EXTRACTOR_H_
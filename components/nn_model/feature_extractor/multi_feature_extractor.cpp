@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "multi_feature_extractor.h"
+
+static const char *TAG = "multi_feature_extractor";
+
+static size_t frame_len(const nn_model_desc_t *desc, int sample_rate) {
+  return sample_rate / 1000 * desc->preproc.win_ms;
+}
+
+static size_t frame_shift(const nn_model_desc_t *desc, int sample_rate) {
+  return sample_rate / 1000 * desc->preproc.stride_ms;
+}
+
+int MultiFeatureExtractor::Validate(const nn_model_desc_t *const *descs,
+                                    size_t num, int sample_rate) {
+  if (num == 0) {
+    ESP_LOGE(TAG, "no heads");
+    return -1;
+  }
+  for (size_t i = 0; i < num; i++) {
+    if (FeatureExtractor::Validate(descs[i], sample_rate) < 0) {
+      return -1;
+    }
+    // the window depends on the frame length only
+    if (frame_len(descs[i], sample_rate) !=
+          frame_len(descs[0], sample_rate) ||
+        frame_shift(descs[i], sample_rate) !=
+          frame_shift(descs[0], sample_rate) ||
+        descs[i]->preproc.fft_len != descs[0]->preproc.fft_len) {
+      ESP_LOGE(TAG, "head %u frames differ from head 0 ones", unsigned(i));
+      return -1;
+    }
+  }
+  return 0;
+}
+
+MultiFeatureExtractor *
+MultiFeatureExtractor::Create(const nn_model_desc_t *const *descs, size_t num,
+                              int sample_rate,
+                              const preproc_tables_t *const *tables) {
+  if (Validate(descs, num, sample_rate) < 0) {
+    return NULL;
+  }
+  return new MultiFeatureExtractor(descs, num, sample_rate, tables);
+}
+
+MultiFeatureExtractor::MultiFeatureExtractor(
+  const nn_model_desc_t *const *descs, size_t num, int sample_rate,
+  const preproc_tables_t *const *tables)
+  : frameLen(frame_len(descs[0], sample_rate)),
+    frameShift(frame_shift(descs[0], sample_rate)), tail(frameLen) {
+  for (size_t i = 0; i < num; i++) {
+    heads.emplace_back(new FeatureExtractor(descs[i], sample_rate,
+                                            tables ? tables[i] : NULL));
+  }
+  power.resize(heads[0]->SpectrumLen());
+}
+
+void MultiFeatureExtractor::Compute(const int16_t *samples,
+                                    const float *norms, float *const *out) {
+  ComputeBatch(samples, frameLen, norms, out, 1);
+}
+
+size_t MultiFeatureExtractor::ComputeBatch(const int16_t *pcm,
+                                           size_t samples,
+                                           const float *norms,
+                                           float *const *out,
+                                           size_t max_frames) {
+  const size_t frames =
+    std::min((samples + frameShift - 1) / frameShift, max_frames);
+  for (size_t f = 0; f < frames; f++) {
+    const size_t start = f * frameShift;
+    const int16_t *frame = &pcm[start];
+    if (start + frameLen > samples) {
+      const size_t count = samples - start;
+      memcpy(tail.data(), frame, count * sizeof(int16_t));
+      memset(&tail[count], 0, (frameLen - count) * sizeof(int16_t));
+      frame = tail.data();
+    }
+    // one FFT, the heads share it
+    heads[0]->Spectrum(frame, power.data());
+    for (size_t i = 0; i < heads.size(); i++) {
+      heads[i]->SpectrumFeatures(power.data(),
+                                 &out[i][f * heads[i]->numCoeffs]);
+    }
+  }
+  for (size_t i = 0; i < heads.size(); i++) {
+    heads[i]->Normalize(out[i], frames, norms[i]);
+  }
+  return frames;
+}
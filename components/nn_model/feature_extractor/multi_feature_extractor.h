@@ -0,0 +1,84 @@
+#ifndef _MULTI_FEATURE_EXTRACTOR_H_
+#define _MULTI_FEATURE_EXTRACTOR_H_
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "feature_extractor.h"
+
+/*!
+ * \brief Features of several models with the same framing from one windowed
+ * FFT per frame, e.g. KWS MFCC and SED log-mel of 40 ms frames every 20 ms.
+ * Each model (head) applies its own filterbank, DCT and normalization to the
+ * shared power spectrum.
+ */
+class MultiFeatureExtractor {
+public:
+  /*!
+   * \brief Create the extractor, the descriptions are checked with
+   * Validate().
+   * \param descs Model descriptions, one per head.
+   * \param num Number of heads.
+   * \param sample_rate Input sample rate.
+   * \param tables Generated tables per head, NULL - none.
+   * \return Extractor, NULL if the descriptions are not valid.
+   */
+  static MultiFeatureExtractor *
+  Create(const nn_model_desc_t *const *descs, size_t num, int sample_rate,
+         const preproc_tables_t *const *tables = NULL);
+  ~MultiFeatureExtractor() = default;
+
+  /*!
+   * \brief Check every description is usable and the frames and FFT length
+   * are the same.
+   * \param descs Model descriptions.
+   * \param num Number of heads.
+   * \param sample_rate Input sample rate.
+   * \return Result.
+   */
+  static int Validate(const nn_model_desc_t *const *descs, size_t num,
+                      int sample_rate);
+
+  /*! \brief Number of heads. */
+  size_t Heads() const { return heads.size(); }
+  /*! \brief Feature extractor of a head, for its sizes, Norm(), Silence(). */
+  FeatureExtractor &Head(size_t i) { return *heads[i]; }
+
+  /*!
+   * \brief Compute features of a frame for every head.
+   * \param samples frameLen samples.
+   * \param norms Divisor of samples per head, see FeatureExtractor::Norm().
+   * \param out numCoeffs features of the head per head.
+   */
+  void Compute(const int16_t *samples, const float *norms, float *const *out);
+  /*!
+   * \brief Compute features of consecutive frames for every head, frame f
+   * starts at sample f * frameShift, samples past the end are zeros.
+   * \param pcm Samples.
+   * \param samples Number of samples.
+   * \param norms Divisor of samples per head, see FeatureExtractor::Norm().
+   * \param out Rows of numCoeffs features of the head per head.
+   * \param max_frames Rows of every out.
+   * \return Number of frames, the ones starting before the end of the
+   * samples up to max_frames.
+   */
+  size_t ComputeBatch(const int16_t *pcm, size_t samples, const float *norms,
+                      float *const *out, size_t max_frames);
+
+  /*! \brief Samples per frame and between frames of every head. */
+  const size_t frameLen;
+  const size_t frameShift;
+
+private:
+  MultiFeatureExtractor(const nn_model_desc_t *const *descs, size_t num,
+                        int sample_rate, const preproc_tables_t *const *tables);
+
+  std::vector<std::unique_ptr<FeatureExtractor>> heads;
+  std::vector<float> power;
+  /*! \brief Last frame padded with zeros. */
+  std::vector<int16_t> tail;
+};
+
+#endif // _MULTI_FEATURE_EXTRACTOR_H_
@@ -1,18 +1,27 @@
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "sdkconfig.h"
 
 #include "string.h"
+#include <stddef.h>
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
 
 #include "nn_model.h"
+#include "nn_model_profiler.h"
 #include "tensor_arena.h"
-#include "tflite_op_resolver.h"
 
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
 struct __nn_model_t {
   tflite::MicroInterpreter *interpreter;
+  NNModelProfiler *profiler;
   nn_model_config_t cfg;
+  /*! \brief Elements of input 0. */
+  size_t input_len;
 };
 
 typedef __nn_model_t *__nn_model_handle_t;
@@ -20,12 +29,13 @@ typedef __nn_model_t *__nn_model_handle_t;
 static void set_input(const float *src, TfLiteTensor *tensor, size_t len,
                       bool is_qnn) {
   if (is_qnn) {
-    for (int i = 0; i < len; i++) {
-      tensor->data.int8[i] =
-        (int8_t)(src[i] / tensor->params.scale + tensor->params.zero_point);
+    for (size_t i = 0; i < len; i++) {
+      const long q =
+        lroundf(src[i] / tensor->params.scale) + tensor->params.zero_point;
+      tensor->data.int8[i] = int8_t(std::clamp(q, -128l, 127l));
     }
   } else {
-    for (int i = 0; i < len; i++) {
+    for (size_t i = 0; i < len; i++) {
       tflite::GetTensorData<float>(tensor)[i] = src[i];
     }
   }
@@ -34,17 +44,78 @@ static void set_input(const float *src, TfLiteTensor *tensor, size_t len,
 static void get_output(const TfLiteTensor *tensor, float *dst, size_t len,
                        bool is_qnn) {
   if (is_qnn) {
-    for (int i = 0; i < len; i++) {
+    for (size_t i = 0; i < len; i++) {
       dst[i] = (tensor->data.int8[i] - tensor->params.zero_point) *
                tensor->params.scale;
     }
   } else {
-    for (int i = 0; i < len; i++) {
+    for (size_t i = 0; i < len; i++) {
       dst[i] = tflite::GetTensorData<float>(tensor)[i];
     }
   }
 }
 
+// elements of a tensor of the type set_input() and get_output() expect
+static int tensor_len(const TfLiteTensor *tensor, bool is_qnn, size_t *len) {
+  if (tensor->type != (is_qnn ? kTfLiteInt8 : kTfLiteFloat32)) {
+    return -1;
+  }
+  *len = tensor->bytes / (is_qnn ? sizeof(int8_t) : sizeof(float));
+  return 0;
+}
+
+static int invoke(__nn_model_handle_t __nn_model_handle, float *scores) {
+  NNModelProfiler *profiler = __nn_model_handle->profiler;
+  if (profiler) {
+    profiler->BeginInvoke();
+  }
+  TfLiteStatus invoke_status = __nn_model_handle->interpreter->Invoke();
+  if (profiler) {
+    profiler->EndInvoke();
+#if CONFIG_NN_MODEL_PROFILER_DUMP_PERIOD > 0
+    if (profiler->invokeCount() % CONFIG_NN_MODEL_PROFILER_DUMP_PERIOD == 0) {
+      nn_model_dump_profile(__nn_model_handle);
+    }
+#endif
+  }
+  if (invoke_status != kTfLiteOk) {
+    ESP_LOGE(__FUNCTION__, "Invoke failed");
+    return -1;
+  }
+
+  const nn_model_desc_t *desc = __nn_model_handle->cfg.model_desc;
+  get_output(__nn_model_handle->interpreter->output(0), scores,
+             desc->labels_num, desc->is_quantized);
+  return 0;
+}
+
+static const tflite::SubGraph *main_subgraph(const nn_model_desc_t *desc) {
+  const tflite::Model *model = tflite::GetModel(desc->model_ptr);
+  if (!model->subgraphs() || model->subgraphs()->size() == 0) {
+    return NULL;
+  }
+  return model->subgraphs()->Get(0);
+}
+
+static size_t tensor_type_size(tflite::TensorType type) {
+  switch (type) {
+  case tflite::TensorType_FLOAT32:
+  case tflite::TensorType_INT32:
+  case tflite::TensorType_UINT32:
+    return 4;
+  case tflite::TensorType_INT64:
+  case tflite::TensorType_FLOAT64:
+  case tflite::TensorType_COMPLEX64:
+    return 8;
+  case tflite::TensorType_FLOAT16:
+  case tflite::TensorType_INT16:
+  case tflite::TensorType_UINT16:
+    return 2;
+  default:
+    return 1;
+  }
+}
+
 static size_t argmax(float *array, size_t len) {
   size_t idx = 0;
   for (size_t i = 0; i < len; i++) {
@@ -55,6 +126,14 @@ static size_t argmax(float *array, size_t len) {
 }
 
 int nn_model_init(nn_model_handle_t *model_handle, nn_model_config_t cfg) {
+  if (!cfg.model_desc) {
+    ESP_LOGE(__FUNCTION__, "model is not set");
+    return -1;
+  }
+  if (!cfg.op_resolver) {
+    ESP_LOGE(__FUNCTION__, "op resolver is not set");
+    return -1;
+  }
   __nn_model_handle_t __nn_model_handle =
     static_cast<__nn_model_handle_t>(malloc(sizeof(__nn_model_t)));
   if (!__nn_model_handle) {
@@ -67,27 +146,58 @@ int nn_model_init(nn_model_handle_t *model_handle, nn_model_config_t cfg) {
     ESP_LOGE(
       __FUNCTION__,
       "Model provided is schema version %ld not equal to supported version %d",
-      model->version(), TFLITE_SCHEMA_VERSION);
+      long(model->version()), TFLITE_SCHEMA_VERSION);
     free(__nn_model_handle);
     return -1;
   }
 
-  uint8_t *tensor_arena = TensorArena::getBuffer();
+  uint8_t *tensor_arena = cfg.tensor_arena;
+  size_t tensor_arena_size = cfg.tensor_arena_size;
+  if (!tensor_arena) {
+    tensor_arena = TensorArena::getBuffer();
+    tensor_arena_size = TensorArena::getSize();
+  }
   if (!tensor_arena) {
     ESP_LOGE(__FUNCTION__, "unable to get tensor arena");
     free(__nn_model_handle);
     return -1;
   }
+#if CONFIG_NN_MODEL_PROFILER
+  cfg.profile = true;
+#endif
+  __nn_model_handle->profiler = NULL;
+  if (cfg.profile) {
+    const tflite::SubGraph *subgraph = main_subgraph(cfg.model_desc);
+    __nn_model_handle->profiler = new NNModelProfiler(
+      subgraph && subgraph->operators() ? subgraph->operators()->size() : 0);
+  }
   // Build an interpreter to run the model with.
-  __nn_model_handle->interpreter =
-    new tflite::MicroInterpreter(model, TFLiteOpResolver::getInstance(),
-                                 tensor_arena, TensorArena::getSize());
+  __nn_model_handle->interpreter = new tflite::MicroInterpreter(
+    model, *cfg.op_resolver, tensor_arena, tensor_arena_size, nullptr,
+    __nn_model_handle->profiler);
 
   // Allocate memory from the tensor_arena for the model's tensors.
   TfLiteStatus allocate_status =
     __nn_model_handle->interpreter->AllocateTensors();
+  const bool is_qnn = cfg.model_desc->is_quantized;
+  size_t output_len = 0;
   if (allocate_status != kTfLiteOk) {
     ESP_LOGE(__FUNCTION__, "AllocateTensors() failed");
+  } else if (tensor_len(__nn_model_handle->interpreter->input(0), is_qnn,
+                        &__nn_model_handle->input_len) < 0 ||
+             tensor_len(__nn_model_handle->interpreter->output(0), is_qnn,
+                        &output_len) < 0 ||
+             output_len != cfg.model_desc->labels_num) {
+    ESP_LOGE(__FUNCTION__, "model tensors do not match %s %u labels",
+             is_qnn ? "int8" : "float", unsigned(cfg.model_desc->labels_num));
+    allocate_status = kTfLiteError;
+  }
+  if (allocate_status != kTfLiteOk) {
+    delete __nn_model_handle->interpreter;
+    delete __nn_model_handle->profiler;
+    if (!cfg.tensor_arena) {
+      TensorArena::releaseBuffer();
+    }
     free(__nn_model_handle);
     return -1;
   }
@@ -99,15 +209,266 @@ int nn_model_init(nn_model_handle_t *model_handle, nn_model_config_t cfg) {
 
 int nn_model_release(nn_model_handle_t model_handle) {
   if (model_handle) {
-    TensorArena::releaseBuffer();
     __nn_model_handle_t __nn_model_handle =
       static_cast<__nn_model_handle_t>(model_handle);
+    if (!__nn_model_handle->cfg.tensor_arena) {
+      TensorArena::releaseBuffer();
+    }
     delete __nn_model_handle->interpreter;
+    delete __nn_model_handle->profiler;
     free(__nn_model_handle);
   }
   return 0;
 }
 
+int nn_model_read_preproc(const unsigned char *model_ptr,
+                          nn_model_desc_t *desc) {
+  const tflite::Model *model = tflite::GetModel(model_ptr);
+  if (!model->metadata() || !model->buffers()) {
+    return -1;
+  }
+  for (const auto *metadata : *model->metadata()) {
+    if (!metadata->name() ||
+        strcmp(metadata->name()->c_str(), NN_MODEL_PREPROC_METADATA) != 0 ||
+        metadata->buffer() >= model->buffers()->size()) {
+      continue;
+    }
+    const auto *data = model->buffers()->Get(metadata->buffer())->data();
+    nn_model_preproc_metadata_t preproc = {};
+    // version 1: version, preproc without fft_len, mel range
+    const size_t v1_preproc_size = offsetof(nn_model_preproc_t, fft_len);
+    const size_t v1_size = sizeof(preproc.version) + v1_preproc_size +
+                           sizeof(preproc.mel_low_freq) +
+                           sizeof(preproc.mel_high_freq);
+    if (data && data->size() == sizeof(preproc)) {
+      memcpy(&preproc, data->data(), sizeof(preproc));
+    } else if (data && data->size() == v1_size) {
+      const uint8_t *p = data->data();
+      memcpy(&preproc.version, p, sizeof(preproc.version));
+      p += sizeof(preproc.version);
+      memcpy(&preproc.preproc, p, v1_preproc_size);
+      p += v1_preproc_size;
+      memcpy(&preproc.mel_low_freq, p, sizeof(preproc.mel_low_freq));
+      p += sizeof(preproc.mel_low_freq);
+      memcpy(&preproc.mel_high_freq, p, sizeof(preproc.mel_high_freq));
+    } else {
+      ESP_LOGE(__FUNCTION__, "wrong %s size", NN_MODEL_PREPROC_METADATA);
+      return -1;
+    }
+    const uint32_t version =
+      data->size() == v1_size ? 1 : NN_MODEL_PREPROC_METADATA_VERSION;
+    if (preproc.version != version) {
+      ESP_LOGE(__FUNCTION__, "unsupported %s version %ld",
+               NN_MODEL_PREPROC_METADATA, long(preproc.version));
+      return -1;
+    }
+    desc->preproc = preproc.preproc;
+    desc->mel_low_freq = preproc.mel_low_freq;
+    desc->mel_high_freq = preproc.mel_high_freq;
+    return 0;
+  }
+  return -1;
+}
+
+int nn_model_get_op_profile(nn_model_handle_t model_handle,
+                            nn_model_op_profile_t *ops, size_t *len,
+                            int64_t *invoke_us) {
+  if (!model_handle) {
+    ESP_LOGE(__FUNCTION__, "nn model is not initialized");
+    return -1;
+  }
+  __nn_model_handle_t __nn_model_handle =
+    static_cast<__nn_model_handle_t>(model_handle);
+  const NNModelProfiler *profiler = __nn_model_handle->profiler;
+  if (!profiler) {
+    ESP_LOGE(__FUNCTION__, "nn model is initialized without profiling");
+    return -1;
+  }
+  const auto &profile = profiler->ops();
+  if (ops) {
+    memcpy(ops, profile.data(),
+           std::min(*len, profile.size()) * sizeof(nn_model_op_profile_t));
+  }
+  *len = profile.size();
+  if (invoke_us) {
+    *invoke_us = profiler->invokeTotalUs();
+  }
+  return 0;
+}
+
+int nn_model_reset_op_profile(nn_model_handle_t model_handle) {
+  if (!model_handle) {
+    ESP_LOGE(__FUNCTION__, "nn model is not initialized");
+    return -1;
+  }
+  __nn_model_handle_t __nn_model_handle =
+    static_cast<__nn_model_handle_t>(model_handle);
+  if (!__nn_model_handle->profiler) {
+    return -1;
+  }
+  __nn_model_handle->profiler->Reset();
+  return 0;
+}
+
+int nn_model_get_tensor_usage(nn_model_handle_t model_handle,
+                              nn_model_tensor_usage_t *tensors, size_t *len,
+                              size_t *arena_used) {
+  if (!model_handle) {
+    ESP_LOGE(__FUNCTION__, "nn model is not initialized");
+    return -1;
+  }
+  __nn_model_handle_t __nn_model_handle =
+    static_cast<__nn_model_handle_t>(model_handle);
+  const nn_model_desc_t *desc = __nn_model_handle->cfg.model_desc;
+  const tflite::Model *model = tflite::GetModel(desc->model_ptr);
+  const tflite::SubGraph *subgraph = main_subgraph(desc);
+  if (!subgraph || !subgraph->tensors() || !subgraph->operators()) {
+    ESP_LOGE(__FUNCTION__, "model has no subgraph");
+    return -1;
+  }
+  const auto *model_tensors = subgraph->tensors();
+  const auto *operators = subgraph->operators();
+  const int last_op = int(operators->size()) - 1;
+
+  // live range of a tensor: from the producing op to the last consumer
+  std::vector<nn_model_tensor_usage_t> usage(model_tensors->size());
+  for (size_t i = 0; i < usage.size(); i++) {
+    usage[i] = nn_model_tensor_usage_t{.index = int(i),
+                                       .first_op = last_op + 1,
+                                       .last_op = -1};
+  }
+  auto use = [&](const flatbuffers::Vector<int32_t> *indices, int op) {
+    for (size_t i = 0; indices && i < indices->size(); i++) {
+      const int32_t idx = indices->Get(i);
+      if (idx >= 0 && size_t(idx) < usage.size()) {
+        usage[idx].first_op = std::min(usage[idx].first_op, op);
+        usage[idx].last_op = std::max(usage[idx].last_op, op);
+      }
+    }
+  };
+  use(subgraph->inputs(), -1);
+  use(subgraph->outputs(), last_op);
+  for (int op = 0; op <= last_op; op++) {
+    use(operators->Get(op)->inputs(), op);
+    use(operators->Get(op)->outputs(), op);
+  }
+
+  size_t num = 0;
+  for (size_t i = 0; i < usage.size(); i++) {
+    const tflite::Tensor *tensor = model_tensors->Get(i);
+    const tflite::Buffer *buffer =
+      model->buffers() && tensor->buffer() < model->buffers()->size()
+        ? model->buffers()->Get(tensor->buffer())
+        : NULL;
+    if (buffer && buffer->data() && buffer->data()->size()) {
+      continue;
+    }
+    if (tensor->is_variable()) {
+      usage[i].first_op = -1;
+      usage[i].last_op = last_op;
+    }
+    if (usage[i].last_op < usage[i].first_op) {
+      continue;
+    }
+    size_t bytes = tensor_type_size(tensor->type());
+    for (size_t d = 0; tensor->shape() && d < tensor->shape()->size(); d++) {
+      bytes *= tensor->shape()->Get(d);
+    }
+    usage[i].name = tensor->name() ? tensor->name()->c_str() : "";
+    usage[i].bytes = bytes;
+    if (tensors && num < *len) {
+      tensors[num] = usage[i];
+    }
+    num++;
+  }
+  *len = num;
+  if (arena_used) {
+    *arena_used = __nn_model_handle->interpreter->arena_used_bytes();
+  }
+  return 0;
+}
+
+int nn_model_dump_profile(nn_model_handle_t model_handle) {
+  size_t op_num = 0;
+  int64_t invoke_us = 0;
+  if (nn_model_get_op_profile(model_handle, NULL, &op_num, &invoke_us) != 0) {
+    return -1;
+  }
+  std::vector<nn_model_op_profile_t> ops(op_num);
+  nn_model_get_op_profile(model_handle, ops.data(), &op_num, &invoke_us);
+
+  const uint32_t invoke_num = ops.empty() ? 0 : ops[0].count;
+  if (invoke_num == 0) {
+    ESP_LOGI(__FUNCTION__, "no invocations");
+    return 0;
+  }
+  ESP_LOGI(__FUNCTION__, "%lu invocations, %lld us avg",
+           (unsigned long)invoke_num, (long long)(invoke_us / invoke_num));
+  for (size_t i = 0; i < ops.size(); i++) {
+    if (!ops[i].count) {
+      continue;
+    }
+    ESP_LOGI(__FUNCTION__, "%3d %-24s %8lld us avg %8lld us max", int(i),
+             ops[i].tag, (long long)(ops[i].total_us / ops[i].count),
+             (long long)ops[i].max_us);
+  }
+
+  // time per op type, ordered by first occurrence
+  std::vector<nn_model_op_profile_t> types;
+  for (const auto &op : ops) {
+    if (!op.count) {
+      continue;
+    }
+    auto it = std::find_if(types.begin(), types.end(), [&](const auto &t) {
+      return strcmp(t.tag, op.tag) == 0;
+    });
+    if (it == types.end()) {
+      types.push_back(nn_model_op_profile_t{.tag = op.tag});
+      it = types.end() - 1;
+    }
+    it->count++;
+    it->total_us += op.total_us;
+  }
+  for (const auto &t : types) {
+    ESP_LOGI(__FUNCTION__, "%-24s x%-3lu %8lld us avg %3d%%", t.tag,
+             (unsigned long)t.count, (long long)(t.total_us / invoke_num),
+             invoke_us ? int(t.total_us * 100 / invoke_us) : 0);
+  }
+
+  size_t tensor_num = 0;
+  size_t arena_used = 0;
+  if (nn_model_get_tensor_usage(model_handle, NULL, &tensor_num,
+                                &arena_used) != 0) {
+    return -1;
+  }
+  std::vector<nn_model_tensor_usage_t> tensors(tensor_num);
+  nn_model_get_tensor_usage(model_handle, tensors.data(), &tensor_num, NULL);
+  // live bytes at every op, the arena holds at least the peak
+  size_t peak = 0;
+  int peak_op = 0;
+  for (int op = 0; op < int(ops.size()); op++) {
+    size_t live = 0;
+    for (const auto &t : tensors) {
+      if (t.first_op <= op && op <= t.last_op) {
+        live += t.bytes;
+      }
+    }
+    if (live > peak) {
+      peak = live;
+      peak_op = op;
+    }
+  }
+  ESP_LOGI(__FUNCTION__, "arena used %u bytes, tensors peak %u bytes at op %d",
+           unsigned(arena_used), unsigned(peak), peak_op);
+  for (const auto &t : tensors) {
+    if (t.first_op <= peak_op && peak_op <= t.last_op) {
+      ESP_LOGI(__FUNCTION__, "  %-32s %6u bytes, ops %d..%d", t.name,
+               unsigned(t.bytes), t.first_op, t.last_op);
+    }
+  }
+  return 0;
+}
+
 int nn_model_get_label(nn_model_handle_t model_handle, int category,
                        char *buffer, size_t len) {
   if (!model_handle) {
@@ -120,15 +481,16 @@ int nn_model_get_label(nn_model_handle_t model_handle, int category,
   if (cfg.model_desc->labels) {
     if (category < 0) {
       strncpy(buffer, cfg.model_desc->labels[1], len);
-    } else if (category < cfg.model_desc->labels_num) {
+    } else if (unsigned(category) < cfg.model_desc->labels_num) {
       strncpy(buffer, cfg.model_desc->labels[category], len);
     }
   }
   return 0;
 }
 
-int nn_model_inference(nn_model_handle_t model_handle, const float *input_data,
-                       size_t len, int *category) {
+int nn_model_inference_scores(nn_model_handle_t model_handle,
+                              const float *input_data, size_t len,
+                              float *scores, size_t scores_len) {
   if (!model_handle) {
     ESP_LOGE(__FUNCTION__, "nn model is not initialized");
     return -1;
@@ -136,31 +498,100 @@ int nn_model_inference(nn_model_handle_t model_handle, const float *input_data,
   __nn_model_handle_t __nn_model_handle =
     static_cast<__nn_model_handle_t>(model_handle);
   nn_model_config_t &cfg = __nn_model_handle->cfg;
+  if (len > __nn_model_handle->input_len) {
+    ESP_LOGE(__FUNCTION__, "input does not match the model");
+    return -1;
+  }
+  if (scores_len < cfg.model_desc->labels_num) {
+    ESP_LOGE(__FUNCTION__, "scores buffer is too small");
+    return -1;
+  }
 
-  const int64_t t1 = esp_timer_get_time();
   set_input(input_data, __nn_model_handle->interpreter->input(0), len,
             cfg.model_desc->is_quantized);
 
-  TfLiteStatus invoke_status = __nn_model_handle->interpreter->Invoke();
-  if (invoke_status != kTfLiteOk) {
-    ESP_LOGE(__FUNCTION__, "Invoke failed");
+  return invoke(__nn_model_handle, scores);
+}
+
+int nn_model_get_input_quant(nn_model_handle_t model_handle, float *scale,
+                             int *zero_point) {
+  if (!model_handle) {
+    ESP_LOGE(__FUNCTION__, "nn model is not initialized");
+    return -1;
+  }
+  __nn_model_handle_t __nn_model_handle =
+    static_cast<__nn_model_handle_t>(model_handle);
+  if (!__nn_model_handle->cfg.model_desc->is_quantized) {
+    return -1;
+  }
+  const TfLiteTensor *tensor = __nn_model_handle->interpreter->input(0);
+  *scale = tensor->params.scale;
+  *zero_point = tensor->params.zero_point;
+  return 0;
+}
+
+int nn_model_get_input_len(nn_model_handle_t model_handle, size_t *len) {
+  if (!model_handle) {
+    ESP_LOGE(__FUNCTION__, "nn model is not initialized");
+    return -1;
+  }
+  *len = static_cast<__nn_model_handle_t>(model_handle)->input_len;
+  return 0;
+}
+
+int nn_model_inference_quantized(nn_model_handle_t model_handle,
+                                 const int8_t *input_data, size_t len,
+                                 float *scores, size_t scores_len) {
+  if (!model_handle) {
+    ESP_LOGE(__FUNCTION__, "nn model is not initialized");
+    return -1;
+  }
+  __nn_model_handle_t __nn_model_handle =
+    static_cast<__nn_model_handle_t>(model_handle);
+  nn_model_config_t &cfg = __nn_model_handle->cfg;
+  TfLiteTensor *tensor = __nn_model_handle->interpreter->input(0);
+  if (!cfg.model_desc->is_quantized || len > tensor->bytes) {
+    ESP_LOGE(__FUNCTION__, "input does not match the model");
     return -1;
   }
+  if (scores_len < cfg.model_desc->labels_num) {
+    ESP_LOGE(__FUNCTION__, "scores buffer is too small");
+    return -1;
+  }
+
+  memcpy(tensor->data.int8, input_data, len);
 
+  return invoke(__nn_model_handle, scores);
+}
+
+int nn_model_inference(nn_model_handle_t model_handle, const float *input_data,
+                       size_t len, int *category) {
+  if (!model_handle) {
+    ESP_LOGE(__FUNCTION__, "nn model is not initialized");
+    return -1;
+  }
+  __nn_model_handle_t __nn_model_handle =
+    static_cast<__nn_model_handle_t>(model_handle);
+  nn_model_config_t &cfg = __nn_model_handle->cfg;
+
+  const int64_t t1 = esp_timer_get_time();
   float *out_buffer = new float[cfg.model_desc->labels_num];
   if (!out_buffer) {
     ESP_LOGE(__FUNCTION__, "unable to allocate out buffer");
     return -1;
   }
-  get_output(__nn_model_handle->interpreter->output(0), out_buffer,
-             cfg.model_desc->labels_num, cfg.model_desc->is_quantized);
+  if (nn_model_inference_scores(model_handle, input_data, len, out_buffer,
+                                cfg.model_desc->labels_num) < 0) {
+    delete[] out_buffer;
+    return -1;
+  }
 
   const size_t idx = argmax(out_buffer, cfg.model_desc->labels_num);
   char result[32];
   nn_model_get_label(model_handle, idx, result, sizeof(result));
 
   ESP_LOGI(__FUNCTION__, "%f, %s, %lld", out_buffer[idx], result,
-           esp_timer_get_time() - t1);
+           (long long)(esp_timer_get_time() - t1));
   *category = -1;
   if (out_buffer[idx] > cfg.inference_threshold) {
     *category = idx;
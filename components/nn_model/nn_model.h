@@ -2,11 +2,69 @@
 #define _NN_MODEL_H_
 
 #include <cstring>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+namespace tflite {
+class MicroOpResolver;
+}
+
 typedef void *nn_model_handle_t;
 
+enum nn_model_features_t : uint8_t {
+  NN_MODEL_FEATURES_MFCC = 0,
+  NN_MODEL_FEATURES_LOG_MEL = 1,
+  /*!
+   * \brief Per-channel energy normalized mel energies, the normalization
+   * adapts to the level, the samples are not normalized and the capture path
+   * skips AGC and noise suppression.
+   */
+  NN_MODEL_FEATURES_PCEN = 2,
+};
+
+enum nn_model_norm_t : uint8_t {
+  /*! \brief Samples are divided by the peak of the segment. */
+  NN_MODEL_NORM_PEAK = 0,
+  /*! \brief Samples are divided by 1 << 15. */
+  NN_MODEL_NORM_FULL_SCALE = 1,
+};
+
+enum nn_model_fft_len_t : uint8_t {
+  /*! \brief Window zero padded to a power of 2. */
+  NN_MODEL_FFT_LEN_POW2 = 0,
+  /*! \brief FFT of the window length, see FFTMixedRadix. */
+  NN_MODEL_FFT_LEN_WINDOW = 1,
+};
+
+/*! \brief Feature extraction the model is trained with. */
+struct nn_model_preproc_t {
+  uint8_t features;
+  uint8_t norm;
+  uint16_t win_ms;
+  uint16_t stride_ms;
+  uint16_t duration_ms;
+  uint16_t num_fbank_bins;
+  uint16_t num_mfcc;
+  uint8_t fft_len;
+  uint8_t reserved;
+};
+
+#define NN_MODEL_PREPROC_METADATA         "grc_preproc"
+#define NN_MODEL_PREPROC_METADATA_VERSION 2
+
+/*!
+ * \brief TFLite metadata buffer NN_MODEL_PREPROC_METADATA, little endian.
+ * Version 1 has no fft_len and reserved fields, its FFT length is
+ * NN_MODEL_FFT_LEN_POW2.
+ */
+struct nn_model_preproc_metadata_t {
+  uint32_t version;
+  nn_model_preproc_t preproc;
+  uint16_t mel_low_freq;
+  uint16_t mel_high_freq;
+};
+
 struct nn_model_desc_t {
   const unsigned char *model_ptr;
   unsigned int model_size;
@@ -15,15 +73,46 @@ struct nn_model_desc_t {
   bool is_quantized;
   size_t mel_low_freq;
   size_t mel_high_freq;
+  nn_model_preproc_t preproc;
 };
 
 struct nn_model_config_t {
   const nn_model_desc_t *model_desc;
   float inference_threshold;
+  /*!
+   * \brief Ops used by the model, required, see model_op_resolver_get() of
+   * tools/gen_op_resolver.py.
+   */
+  const tflite::MicroOpResolver *op_resolver;
+  /*! \brief Own tensor arena, NULL - shared TensorArena buffer. */
+  uint8_t *tensor_arena;
+  size_t tensor_arena_size;
+  /*! \brief Collect per-op timing, always on with CONFIG_NN_MODEL_PROFILER. */
+  bool profile;
+};
+
+/*! \brief Timing of an op over the profiled invocations. */
+struct nn_model_op_profile_t {
+  /*! \brief Op name, e.g. DEPTHWISE_CONV_2D. */
+  const char *tag;
+  uint32_t count;
+  int64_t total_us;
+  int64_t max_us;
+};
+
+/*! \brief Non-constant tensor, it takes arena space while it is live. */
+struct nn_model_tensor_usage_t {
+  int index;
+  const char *name;
+  size_t bytes;
+  /*! \brief Ops producing and last consuming the tensor, -1 for input. */
+  int first_op;
+  int last_op;
 };
 
 /*!
- * \brief Initialize NN model.
+ * \brief Initialize NN model. Fails if the input and output types are not
+ * int8 or float as set by is_quantized or the output is not labels_num values.
  * \param model_handle NN model handle.
  * \param cfg NN model config.
  * \return Result.
@@ -45,6 +134,91 @@ int nn_model_release(nn_model_handle_t model_handle);
  */
 int nn_model_inference(nn_model_handle_t model_handle, const float *input_data,
                        size_t len, int *category);
+/*!
+ * \brief Model inference, scores of all categories.
+ * \param model_handle NN model handle.
+ * \param input_data input data.
+ * \param len input data len.
+ * \param scores Buffer for labels_num scores.
+ * \param scores_len Buffer len.
+ * \return Result.
+ */
+int nn_model_inference_scores(nn_model_handle_t model_handle,
+                              const float *input_data, size_t len,
+                              float *scores, size_t scores_len);
+/*!
+ * \brief Input quantization of a quantized model.
+ * \param model_handle NN model handle.
+ * \param scale Input scale.
+ * \param zero_point Input zero point.
+ * \return Result, -1 for a float model.
+ */
+int nn_model_get_input_quant(nn_model_handle_t model_handle, float *scale,
+                             int *zero_point);
+/*!
+ * \brief Number of input values of the model.
+ * \param model_handle NN model handle.
+ * \param len Elements of the input tensor.
+ * \return Result.
+ */
+int nn_model_get_input_len(nn_model_handle_t model_handle, size_t *len);
+/*!
+ * \brief Model inference on already quantized input, scores of all
+ * categories.
+ * \param model_handle NN model handle.
+ * \param input_data input data quantized with the model input params.
+ * \param len input data len.
+ * \param scores Buffer for labels_num scores.
+ * \param scores_len Buffer len.
+ * \return Result.
+ */
+int nn_model_inference_quantized(nn_model_handle_t model_handle,
+                                 const int8_t *input_data, size_t len,
+                                 float *scores, size_t scores_len);
+/*!
+ * \brief Read preprocessing config from the model metadata.
+ * \param model_ptr TFLite model.
+ * \param desc Description to update: preproc and mel range.
+ * \return Result, -1 if the model has no such metadata.
+ */
+int nn_model_read_preproc(const unsigned char *model_ptr,
+                          nn_model_desc_t *desc);
+/*!
+ * \brief Per-op timing in execution order, the model must be initialized with
+ * profiling.
+ * \param model_handle NN model handle.
+ * \param ops Buffer for op statistics, NULL to get the number of ops.
+ * \param len Buffer len, set to the number of ops.
+ * \param invoke_us Total time of the profiled invocations, may be NULL.
+ * \return Result.
+ */
+int nn_model_get_op_profile(nn_model_handle_t model_handle,
+                            nn_model_op_profile_t *ops, size_t *len,
+                            int64_t *invoke_us);
+/*!
+ * \brief Reset collected op timing.
+ * \param model_handle NN model handle.
+ * \return Result.
+ */
+int nn_model_reset_op_profile(nn_model_handle_t model_handle);
+/*!
+ * \brief Tensors planned in the tensor arena, constant ones are not listed.
+ * \param model_handle NN model handle.
+ * \param tensors Buffer for tensors, NULL to get the number of tensors.
+ * \param len Buffer len, set to the number of tensors.
+ * \param arena_used Arena bytes used by the model, tensors and interpreter
+ * data, may be NULL.
+ * \return Result.
+ */
+int nn_model_get_tensor_usage(nn_model_handle_t model_handle,
+                              nn_model_tensor_usage_t *tensors, size_t *len,
+                              size_t *arena_used);
+/*!
+ * \brief Log op timing, time per op type and arena usage.
+ * \param model_handle NN model handle.
+ * \return Result.
+ */
+int nn_model_dump_profile(nn_model_handle_t model_handle);
 /*!
  * \brief Get label string.
  * \param model_handle NN model handle.
@@ -0,0 +1,161 @@
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include <string.h>
+
+#include "nn_model_partition.h"
+
+#if CONFIG_NN_MODEL_PARTITION
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#define NN_MODEL_PARTITION_MAX_MODELS 16
+
+static const char *TAG = "nn_model_partition";
+
+struct {
+  bool checked;
+  const uint8_t *base;
+  size_t size;
+  esp_partition_mmap_handle_t mmap_handle;
+  const nn_model_partition_entry_t *entries[NN_MODEL_PARTITION_MAX_MODELS];
+  nn_model_desc_t descs[NN_MODEL_PARTITION_MAX_MODELS];
+  size_t desc_num;
+} static s_partition;
+
+static int partition_map() {
+  if (s_partition.checked) {
+    return s_partition.base ? 0 : -1;
+  }
+  s_partition.checked = true;
+
+  const esp_partition_t *partition =
+    esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                             CONFIG_NN_MODEL_PARTITION_LABEL);
+  if (!partition) {
+    ESP_LOGW(TAG, "no %s partition", CONFIG_NN_MODEL_PARTITION_LABEL);
+    return -1;
+  }
+  const void *ptr = NULL;
+  esp_err_t err =
+    esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA,
+                       &ptr, &s_partition.mmap_handle);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "unable to map partition: %s", esp_err_to_name(err));
+    return -1;
+  }
+
+  const nn_model_partition_header_t *header =
+    static_cast<const nn_model_partition_header_t *>(ptr);
+  if (header->magic != NN_MODEL_PARTITION_MAGIC ||
+      header->version != NN_MODEL_PARTITION_VERSION ||
+      sizeof(*header) + header->entry_num * sizeof(nn_model_partition_entry_t) >
+        partition->size) {
+    ESP_LOGW(TAG, "no models in %s partition", partition->label);
+    esp_partition_munmap(s_partition.mmap_handle);
+    return -1;
+  }
+  s_partition.base = static_cast<const uint8_t *>(ptr);
+  s_partition.size = partition->size;
+  ESP_LOGI(TAG, "%d models in %s partition", header->entry_num,
+           partition->label);
+  return 0;
+}
+
+static const nn_model_partition_entry_t *find_entry(const char *name) {
+  const nn_model_partition_header_t *header =
+    reinterpret_cast<const nn_model_partition_header_t *>(s_partition.base);
+  const nn_model_partition_entry_t *entries =
+    reinterpret_cast<const nn_model_partition_entry_t *>(header + 1);
+  for (size_t i = 0; i < header->entry_num; i++) {
+    if (strncmp(entries[i].name, name, NN_MODEL_NAME_LEN) == 0) {
+      return &entries[i];
+    }
+  }
+  return NULL;
+}
+
+static int load_desc(const nn_model_partition_entry_t *entry,
+                     nn_model_desc_t *desc) {
+  const size_t size = s_partition.size;
+  if (entry->model_offset + size_t(entry->model_size) > size ||
+      entry->labels_offset >= size) {
+    ESP_LOGE(TAG, "%.*s: broken entry", NN_MODEL_NAME_LEN, entry->name);
+    return -1;
+  }
+  const uint8_t *model = s_partition.base + entry->model_offset;
+  if (esp_rom_crc32_le(0, model, entry->model_size) != entry->crc32) {
+    ESP_LOGE(TAG, "%.*s: CRC mismatch", NN_MODEL_NAME_LEN, entry->name);
+    return -1;
+  }
+
+  const char **labels = new const char *[entry->labels_num];
+  const char *label =
+    reinterpret_cast<const char *>(s_partition.base + entry->labels_offset);
+  const char *end = reinterpret_cast<const char *>(s_partition.base + size);
+  for (size_t i = 0; i < entry->labels_num; i++) {
+    const char *nul =
+      static_cast<const char *>(memchr(label, 0, end - label));
+    if (!nul) {
+      ESP_LOGE(TAG, "%.*s: broken labels", NN_MODEL_NAME_LEN, entry->name);
+      delete[] labels;
+      return -1;
+    }
+    labels[i] = label;
+    label = nul + 1;
+  }
+
+  *desc = nn_model_desc_t{
+    .model_ptr = model,
+    .model_size = entry->model_size,
+    .labels = labels,
+    .labels_num = entry->labels_num,
+    .is_quantized = entry->is_quantized != 0,
+    .mel_low_freq = entry->mel_low_freq,
+    .mel_high_freq = entry->mel_high_freq,
+    .preproc = entry->preproc,
+  };
+  nn_model_read_preproc(model, desc);
+  return 0;
+}
+
+static const nn_model_desc_t *partition_get(const char *name) {
+  if (partition_map() != 0) {
+    return NULL;
+  }
+  const nn_model_partition_entry_t *entry = find_entry(name);
+  if (!entry) {
+    return NULL;
+  }
+  for (size_t i = 0; i < s_partition.desc_num; i++) {
+    if (s_partition.entries[i] == entry) {
+      return &s_partition.descs[i];
+    }
+  }
+  if (s_partition.desc_num == NN_MODEL_PARTITION_MAX_MODELS) {
+    ESP_LOGE(TAG, "too many models");
+    return NULL;
+  }
+  nn_model_desc_t *desc = &s_partition.descs[s_partition.desc_num];
+  if (load_desc(entry, desc) != 0) {
+    return NULL;
+  }
+  s_partition.entries[s_partition.desc_num++] = entry;
+  ESP_LOGI(TAG, "%s: %d bytes from partition", name, desc->model_size);
+  return desc;
+}
+#endif
+
+const nn_model_desc_t *nn_model_desc_get(const char *name,
+                                         const nn_model_desc_t *builtin) {
+#if CONFIG_NN_MODEL_PARTITION
+  const nn_model_desc_t *desc = partition_get(name);
+  if (desc) {
+    return desc;
+  }
+#endif
+  if (!builtin) {
+    ESP_LOGE(__FUNCTION__, "model %s is not found", name);
+  }
+  return builtin;
+}
@@ -0,0 +1,51 @@
+#ifndef _NN_MODEL_PARTITION_H_
+#define _NN_MODEL_PARTITION_H_
+
+#include "nn_model.h"
+
+/*!
+ * Models partition layout, little endian, written by tools/pack_models.py:
+ * - nn_model_partition_header_t;
+ * - entry_num nn_model_partition_entry_t;
+ * - model data 16 byte aligned, labels as labels_num NUL terminated strings.
+ * Offsets are from the partition start.
+ */
+#define NN_MODEL_PARTITION_MAGIC   0x4C444D47 // "GMDL"
+#define NN_MODEL_PARTITION_VERSION 3
+#define NN_MODEL_NAME_LEN          24
+
+struct nn_model_partition_header_t {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t entry_num;
+};
+
+struct nn_model_partition_entry_t {
+  char name[NN_MODEL_NAME_LEN];
+  uint32_t model_offset;
+  uint32_t model_size;
+  uint32_t labels_offset;
+  uint16_t labels_num;
+  uint8_t is_quantized;
+  uint8_t reserved;
+  uint16_t mel_low_freq;
+  uint16_t mel_high_freq;
+  /*! \brief Overridden by the model metadata if it has one. */
+  nn_model_preproc_t preproc;
+  uint16_t padding;
+  /*! \brief CRC32 of model data. */
+  uint32_t crc32;
+};
+
+/*!
+ * \brief Get model description, the models partition overrides the model
+ * linked into the app. Descriptions from the partition stay valid until
+ * reboot.
+ * \param name Model name in the partition.
+ * \param builtin Model linked into the app, NULL if there is none.
+ * \return Model description or NULL.
+ */
+const nn_model_desc_t *nn_model_desc_get(const char *name,
+                                         const nn_model_desc_t *builtin);
+
+#endif // _NN_MODEL_PARTITION_H_
@@ -0,0 +1,55 @@
+#include "esp_timer.h"
+
+#include "nn_model_profiler.h"
+
+#define NO_EVENT UINT32_MAX
+
+NNModelProfiler::NNModelProfiler(size_t op_num)
+  : ops_(op_num), start_us_(op_num), event_idx_(0), active_(false),
+    invoke_start_us_(0), invoke_count_(0), invoke_total_us_(0) {
+  Reset();
+}
+
+uint32_t NNModelProfiler::BeginEvent(const char *tag) {
+  if (!active_ || event_idx_ >= ops_.size()) {
+    return NO_EVENT;
+  }
+  const size_t idx = event_idx_++;
+  // tags are static op names, the first invocation sets them
+  ops_[idx].tag = tag;
+  start_us_[idx] = esp_timer_get_time();
+  return idx;
+}
+
+void NNModelProfiler::EndEvent(uint32_t event_handle) {
+  if (event_handle == NO_EVENT) {
+    return;
+  }
+  nn_model_op_profile_t &op = ops_[event_handle];
+  const int64_t us = esp_timer_get_time() - start_us_[event_handle];
+  op.count++;
+  op.total_us += us;
+  if (us > op.max_us) {
+    op.max_us = us;
+  }
+}
+
+void NNModelProfiler::BeginInvoke() {
+  event_idx_ = 0;
+  active_ = true;
+  invoke_start_us_ = esp_timer_get_time();
+}
+
+void NNModelProfiler::EndInvoke() {
+  active_ = false;
+  invoke_count_++;
+  invoke_total_us_ += esp_timer_get_time() - invoke_start_us_;
+}
+
+void NNModelProfiler::Reset() {
+  for (auto &op : ops_) {
+    op = nn_model_op_profile_t{.tag = op.tag};
+  }
+  invoke_count_ = 0;
+  invoke_total_us_ = 0;
+}
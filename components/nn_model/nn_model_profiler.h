@@ -0,0 +1,48 @@
+#ifndef _NN_MODEL_PROFILER_H_
+#define _NN_MODEL_PROFILER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "nn_model.h"
+
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+/*!
+ * \brief Per-op timing of the interpreter. Ops are identified by their order
+ * in Invoke(), events outside of BeginInvoke()/EndInvoke() (init, prepare) are
+ * ignored. Timing uses esp_timer, so it works in the host builds too.
+ */
+class NNModelProfiler : public tflite::MicroProfilerInterface {
+public:
+  /*!
+   * \brief Constructor.
+   * \param op_num Ops per invocation, further events are not recorded.
+   */
+  explicit NNModelProfiler(size_t op_num);
+  ~NNModelProfiler() override = default;
+
+  uint32_t BeginEvent(const char *tag) override;
+  void EndEvent(uint32_t event_handle) override;
+
+  void BeginInvoke();
+  void EndInvoke();
+  void Reset();
+
+  /*! \brief Per-op statistics in execution order. */
+  const std::vector<nn_model_op_profile_t> &ops() const { return ops_; }
+  uint32_t invokeCount() const { return invoke_count_; }
+  int64_t invokeTotalUs() const { return invoke_total_us_; }
+
+private:
+  std::vector<nn_model_op_profile_t> ops_;
+  std::vector<int64_t> start_us_;
+  size_t event_idx_;
+  bool active_;
+  int64_t invoke_start_us_;
+  uint32_t invoke_count_;
+  int64_t invoke_total_us_;
+};
+
+#endif // _NN_MODEL_PROFILER_H_
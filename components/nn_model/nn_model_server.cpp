@@ -0,0 +1,342 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#include "nn_model_server.h"
+
+#include <algorithm>
+#include <string.h>
+
+static const char *TAG = "nn_model_server";
+
+struct job_t {
+  nn_model_request_t req;
+  int64_t submit_us;
+};
+
+struct {
+  size_t ref_count;
+  TaskHandle_t task;
+  QueueHandle_t queues[NN_MODEL_PRIORITY_NUM];
+  SemaphoreHandle_t pending_sema;
+  /*!
+   * \brief Guards the models, the queues order, serving and stats, not held
+   * during inference.
+   */
+  SemaphoreHandle_t serve_mutex;
+  /*! \brief Given when the job being served is done and a waiter is set. */
+  SemaphoreHandle_t served_sema;
+  /*! \brief Model of the job being served, NULL - none. */
+  nn_model_handle_t serving;
+  bool serving_waited;
+  nn_model_handle_t models[NN_MODEL_SERVER_MAX_MODELS];
+  nn_model_server_stats_t stats[NN_MODEL_PRIORITY_NUM];
+} static s_server;
+
+static bool is_attached(nn_model_handle_t model_handle) {
+  for (size_t i = 0; i < NN_MODEL_SERVER_MAX_MODELS; i++) {
+    if (model_handle && s_server.models[i] == model_handle) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void complete(const job_t &job, const nn_model_result_t &res) {
+  if (job.req.cb) {
+    job.req.cb(&res, job.req.arg);
+  }
+}
+
+static void serve(const job_t &job) {
+  const nn_model_request_t &req = job.req;
+  nn_model_result_t res = {.result = -1, .category = -1};
+  const int64_t t1 = esp_timer_get_time();
+  res.queue_us = t1 - job.submit_us;
+  res.result = nn_model_inference(req.model_handle, req.input, req.len,
+                                  &res.category);
+  res.compute_us = esp_timer_get_time() - t1;
+  ESP_LOGD(TAG, "prio %u: queue %lld us, compute %lld us", req.priority,
+           res.queue_us, res.compute_us);
+  complete(job, res);
+
+  xSemaphoreTake(s_server.serve_mutex, portMAX_DELAY);
+  nn_model_server_stats_t &stats = s_server.stats[req.priority];
+  stats.requests++;
+  stats.queue_us += res.queue_us;
+  stats.queue_max_us = std::max(stats.queue_max_us, res.queue_us);
+  stats.compute_us += res.compute_us;
+  stats.compute_max_us = std::max(stats.compute_max_us, res.compute_us);
+  s_server.serving = NULL;
+  if (s_server.serving_waited) {
+    s_server.serving_waited = false;
+    xSemaphoreGive(s_server.served_sema);
+  }
+  xSemaphoreGive(s_server.serve_mutex);
+}
+
+/*!
+ * \brief Wait with serve_mutex held until no job of model_handle (NULL - of
+ * any model) is served.
+ */
+static void wait_served(nn_model_handle_t model_handle) {
+  while (s_server.serving &&
+         (model_handle == NULL || s_server.serving == model_handle)) {
+    s_server.serving_waited = true;
+    xSemaphoreGive(s_server.serve_mutex);
+    xSemaphoreTake(s_server.served_sema, portMAX_DELAY);
+    xSemaphoreTake(s_server.serve_mutex, portMAX_DELAY);
+  }
+}
+
+static void server_task(void *pv) {
+  job_t job;
+
+  for (;;) {
+    xSemaphoreTake(s_server.pending_sema, portMAX_DELAY);
+    // the mutex is held for the dequeue only, a submit does not wait for the
+    // inference
+    xSemaphoreTake(s_server.serve_mutex, portMAX_DELAY);
+    size_t prio = 0;
+    for (; prio < NN_MODEL_PRIORITY_NUM; prio++) {
+      if (xQueueReceive(s_server.queues[prio], &job, 0) == pdPASS) {
+        break;
+      }
+    }
+    // the jobs of a detached model are completed by
+    // nn_model_server_detach(), none are queued after it
+    const bool attached =
+      prio < NN_MODEL_PRIORITY_NUM && is_attached(job.req.model_handle);
+    if (attached) {
+      s_server.serving = job.req.model_handle;
+    }
+    xSemaphoreGive(s_server.serve_mutex);
+    if (attached) {
+      serve(job);
+    }
+  }
+}
+
+static void log_stats() {
+  for (size_t prio = 0; prio < NN_MODEL_PRIORITY_NUM; prio++) {
+    const nn_model_server_stats_t &stats = s_server.stats[prio];
+    if (stats.requests) {
+      ESP_LOGI(TAG,
+               "prio %u: %lu requests, queue %lld/%lld us, compute %lld/%lld "
+               "us (avg/max)",
+               prio, (unsigned long)stats.requests,
+               stats.queue_us / stats.requests, stats.queue_max_us,
+               stats.compute_us / stats.requests, stats.compute_max_us);
+    }
+  }
+}
+
+int nn_model_server_init() {
+  if (s_server.ref_count++) {
+    return 0;
+  }
+  s_server.serve_mutex = xSemaphoreCreateMutex();
+  s_server.served_sema = xSemaphoreCreateBinary();
+  s_server.pending_sema = xSemaphoreCreateCounting(
+    NN_MODEL_SERVER_QUEUE_LEN * NN_MODEL_PRIORITY_NUM, 0);
+  bool errors = s_server.serve_mutex == NULL ||
+                s_server.served_sema == NULL || s_server.pending_sema == NULL;
+  for (size_t i = 0; i < NN_MODEL_PRIORITY_NUM; i++) {
+    s_server.queues[i] = xQueueCreate(NN_MODEL_SERVER_QUEUE_LEN, sizeof(job_t));
+    errors |= s_server.queues[i] == NULL;
+  }
+  if (errors) {
+    ESP_LOGE(TAG, "Error creating server queues");
+    nn_model_server_release();
+    return -1;
+  }
+
+#ifdef CONFIG_NN_MODEL_SERVER_CORE
+  auto xReturned = xTaskCreatePinnedToCore(
+    server_task, "nn_model_server", configMINIMAL_STACK_SIZE + 1024 * 6, NULL,
+    CONFIG_NN_MODEL_SERVER_PRIORITY, &s_server.task,
+    CONFIG_NN_MODEL_SERVER_CORE);
+#else
+  auto xReturned =
+    xTaskCreate(server_task, "nn_model_server",
+                configMINIMAL_STACK_SIZE + 1024 * 6, NULL,
+                CONFIG_NN_MODEL_SERVER_PRIORITY, &s_server.task);
+#endif
+  if (xReturned != pdPASS) {
+    ESP_LOGE(TAG, "Error creating nn_model_server task");
+    s_server.task = NULL;
+    nn_model_server_release();
+    return -1;
+  }
+  return 0;
+}
+
+void nn_model_server_release() {
+  if (s_server.ref_count == 0 || --s_server.ref_count) {
+    return;
+  }
+  if (s_server.task) {
+    // wait for the job being served, the task then waits for a job or for
+    // the mutex
+    xSemaphoreTake(s_server.serve_mutex, portMAX_DELAY);
+    wait_served(NULL);
+    vTaskDelete(s_server.task);
+    s_server.task = NULL;
+    log_stats();
+  }
+  for (size_t i = 0; i < NN_MODEL_PRIORITY_NUM; i++) {
+    if (s_server.queues[i]) {
+      vQueueDelete(s_server.queues[i]);
+      s_server.queues[i] = NULL;
+    }
+  }
+  if (s_server.pending_sema) {
+    vSemaphoreDelete(s_server.pending_sema);
+    s_server.pending_sema = NULL;
+  }
+  if (s_server.serve_mutex) {
+    vSemaphoreDelete(s_server.serve_mutex);
+    s_server.serve_mutex = NULL;
+  }
+  if (s_server.served_sema) {
+    vSemaphoreDelete(s_server.served_sema);
+    s_server.served_sema = NULL;
+  }
+  s_server.serving = NULL;
+  s_server.serving_waited = false;
+  memset(s_server.models, 0, sizeof(s_server.models));
+  memset(s_server.stats, 0, sizeof(s_server.stats));
+}
+
+int nn_model_server_attach(nn_model_handle_t model_handle) {
+  if (!s_server.task || !model_handle) {
+    ESP_LOGE(TAG, "server is not initialized");
+    return -1;
+  }
+  int ret = -1;
+  xSemaphoreTake(s_server.serve_mutex, portMAX_DELAY);
+  for (size_t i = 0; i < NN_MODEL_SERVER_MAX_MODELS; i++) {
+    if (s_server.models[i] == NULL) {
+      s_server.models[i] = model_handle;
+      ret = 0;
+      break;
+    }
+  }
+  xSemaphoreGive(s_server.serve_mutex);
+  if (ret < 0) {
+    ESP_LOGE(TAG, "too many models");
+  }
+  return ret;
+}
+
+void nn_model_server_detach(nn_model_handle_t model_handle) {
+  if (!s_server.task) {
+    return;
+  }
+  xSemaphoreTake(s_server.serve_mutex, portMAX_DELAY);
+  if (!is_attached(model_handle)) {
+    xSemaphoreGive(s_server.serve_mutex);
+    return;
+  }
+  for (size_t i = 0; i < NN_MODEL_SERVER_MAX_MODELS; i++) {
+    if (s_server.models[i] == model_handle) {
+      s_server.models[i] = NULL;
+    }
+  }
+  // complete own pending jobs, keep the order of the others
+  const nn_model_result_t dropped = {.result = -1, .category = -1};
+  job_t job;
+  for (size_t prio = 0; prio < NN_MODEL_PRIORITY_NUM; prio++) {
+    for (auto n = uxQueueMessagesWaiting(s_server.queues[prio]); n > 0; n--) {
+      if (xQueueReceive(s_server.queues[prio], &job, 0) != pdPASS) {
+        break;
+      }
+      if (job.req.model_handle == model_handle) {
+        complete(job, dropped);
+      } else {
+        xQueueSend(s_server.queues[prio], &job, 0);
+      }
+    }
+  }
+  // the job being served uses the model till its callback returns
+  wait_served(model_handle);
+  xSemaphoreGive(s_server.serve_mutex);
+}
+
+int nn_model_server_submit(const nn_model_request_t &req) {
+  if (!s_server.task || req.priority >= NN_MODEL_PRIORITY_NUM) {
+    ESP_LOGE(TAG, "server is not initialized");
+    return -1;
+  }
+  const job_t job = {.req = req, .submit_us = esp_timer_get_time()};
+  // attached check and enqueue are one step for nn_model_server_detach(), it
+  // completes the queued jobs of the model
+  for (;;) {
+    xSemaphoreTake(s_server.serve_mutex, portMAX_DELAY);
+    if (!is_attached(req.model_handle)) {
+      xSemaphoreGive(s_server.serve_mutex);
+      ESP_LOGE(TAG, "model is not attached");
+      return -1;
+    }
+    const bool queued =
+      xQueueSend(s_server.queues[req.priority], &job, 0) == pdPASS;
+    xSemaphoreGive(s_server.serve_mutex);
+    if (queued) {
+      break;
+    }
+    // the queue is full, server_task takes a job meanwhile
+    vTaskDelay(1);
+  }
+  xSemaphoreGive(s_server.pending_sema);
+  return 0;
+}
+
+int nn_model_server_inference(nn_model_handle_t model_handle,
+                              const float *input_data, size_t len,
+                              nn_model_priority_t priority, int *category) {
+  struct sync_ctx_t {
+    SemaphoreHandle_t sema;
+    nn_model_result_t res;
+  };
+  auto done_cb = [](const nn_model_result_t *res, void *arg) {
+    auto *ctx = static_cast<sync_ctx_t *>(arg);
+    ctx->res = *res;
+    xSemaphoreGive(ctx->sema);
+  };
+
+  StaticSemaphore_t sema_buf;
+  sync_ctx_t ctx = {
+    .sema = xSemaphoreCreateBinaryStatic(&sema_buf),
+    .res = {.result = -1, .category = -1},
+  };
+  const int queued = nn_model_server_submit(nn_model_request_t{
+    .model_handle = model_handle,
+    .input = input_data,
+    .len = len,
+    .priority = priority,
+    .cb = done_cb,
+    .arg = &ctx,
+  });
+  if (queued == 0) {
+    xSemaphoreTake(ctx.sema, portMAX_DELAY);
+  }
+  vSemaphoreDelete(ctx.sema);
+  *category = ctx.res.category;
+  return queued == 0 ? ctx.res.result : -1;
+}
+
+int nn_model_server_get_stats(nn_model_priority_t priority,
+                              nn_model_server_stats_t *stats) {
+  if (!s_server.task || priority >= NN_MODEL_PRIORITY_NUM) {
+    return -1;
+  }
+  xSemaphoreTake(s_server.serve_mutex, portMAX_DELAY);
+  *stats = s_server.stats[priority];
+  xSemaphoreGive(s_server.serve_mutex);
+  return 0;
+}
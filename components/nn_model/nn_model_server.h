@@ -0,0 +1,111 @@
+#ifndef _NN_MODEL_SERVER_H_
+#define _NN_MODEL_SERVER_H_
+
+#include "nn_model.h"
+
+/*!
+ * Inference server: one task, pinned to CONFIG_NN_MODEL_SERVER_CORE, runs all
+ * inference of the attached models, so heavy Invoke() calls do not compete
+ * with capture and preprocessing tasks. Requests are served by priority, FIFO
+ * within a priority.
+ */
+
+#define NN_MODEL_SERVER_MAX_MODELS 4
+#define NN_MODEL_SERVER_QUEUE_LEN  4
+
+enum nn_model_priority_t : unsigned {
+  /*! \brief Interactive requests, e.g. KWS. */
+  NN_MODEL_PRIORITY_HIGH = 0,
+  /*! \brief Background requests, e.g. SED. */
+  NN_MODEL_PRIORITY_LOW,
+  NN_MODEL_PRIORITY_NUM,
+};
+
+struct nn_model_result_t {
+  /*! \brief Result of nn_model_inference, -1 for dropped request. */
+  int result;
+  int category;
+  /*! \brief Time from submit to the start of inference. */
+  int64_t queue_us;
+  int64_t compute_us;
+};
+
+/*!
+ * \brief Request completion callback, called from the server task or from
+ * nn_model_server_detach() for dropped requests.
+ * \param res Inference result.
+ * \param arg User argument.
+ */
+typedef void (*nn_model_done_cb_t)(const nn_model_result_t *res, void *arg);
+
+struct nn_model_request_t {
+  nn_model_handle_t model_handle;
+  /*! \brief Input features, read when the request is served. */
+  const float *input;
+  size_t len;
+  nn_model_priority_t priority;
+  nn_model_done_cb_t cb;
+  void *arg;
+};
+
+struct nn_model_server_stats_t {
+  uint32_t requests;
+  int64_t queue_us;
+  int64_t queue_max_us;
+  int64_t compute_us;
+  int64_t compute_max_us;
+};
+
+/*!
+ * \brief Initialize server, reference counted: the task is created by the
+ * first call.
+ * \return Result.
+ */
+int nn_model_server_init();
+/*!
+ * \brief Release server, the task is deleted by the last call.
+ */
+void nn_model_server_release();
+/*!
+ * \brief Serve the model, requests for other models are rejected.
+ * \param model_handle NN model handle.
+ * \return Result.
+ */
+int nn_model_server_attach(nn_model_handle_t model_handle);
+/*!
+ * \brief Stop serving the model: pending requests complete with -1, the one
+ * being served is waited for. Call it before the requesting task, the input
+ * buffers or the model are released. Must not be called from a callback.
+ * \param model_handle NN model handle.
+ */
+void nn_model_server_detach(nn_model_handle_t model_handle);
+/*!
+ * \brief Queue request, blocks while the priority queue is full, not while a
+ * job is served. Must not be called from a callback.
+ * \param req Request, copied.
+ * \return Result.
+ */
+int nn_model_server_submit(const nn_model_request_t &req);
+/*!
+ * \brief Model inference by the server, blocks the caller until it is done.
+ * Must not be called from a callback.
+ * \param model_handle NN model handle.
+ * \param input_data input data.
+ * \param len input data len.
+ * \param priority Request priority.
+ * \param category inferred category.
+ * \return Result.
+ */
+int nn_model_server_inference(nn_model_handle_t model_handle,
+                              const float *input_data, size_t len,
+                              nn_model_priority_t priority, int *category);
+/*!
+ * \brief Queueing delay and compute time of served requests.
+ * \param priority Request priority.
+ * \param stats Statistics since the server init.
+ * \return Result.
+ */
+int nn_model_server_get_stats(nn_model_priority_t priority,
+                              nn_model_server_stats_t *stats);
+
+#endif // _NN_MODEL_SERVER_H_
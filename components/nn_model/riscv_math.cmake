@@ -0,0 +1,13 @@
+# NMSIS DSP sources used by AudioPreprocessor, shared with host tools
+set(NMSIS_DIR "${CMAKE_CURRENT_LIST_DIR}/../../3rdparty/NMSIS/NMSIS/")
+set(RISCV_MATH_SRC
+    "${NMSIS_DIR}/DSP/Source/FastMathFunctions/riscv_cos_f32.c"
+    "${NMSIS_DIR}/DSP/Source/CommonTables/riscv_common_tables.c"
+    "${NMSIS_DIR}/DSP/Source/CommonTables/riscv_const_structs.c"
+    "${NMSIS_DIR}/DSP/Source/TransformFunctions/riscv_rfft_fast_f32.c"
+    "${NMSIS_DIR}/DSP/Source/TransformFunctions/riscv_cfft_f32.c"
+    "${NMSIS_DIR}/DSP/Source/TransformFunctions/riscv_cfft_radix8_f32.c"
+    "${NMSIS_DIR}/DSP/Source/TransformFunctions/riscv_bitreversal2.c"
+    "${NMSIS_DIR}/DSP/Source/TransformFunctions/riscv_rfft_fast_init_f32.c"
+    "${NMSIS_DIR}/DSP/Source/TransformFunctions/riscv_cfft_init_f32.c")
+set(RISCV_MATH_INC "${NMSIS_DIR}/Core/Include/" "${NMSIS_DIR}/DSP/Include/")
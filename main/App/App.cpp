@@ -19,7 +19,7 @@ App::App() : current_state_(nullptr) {
   }
   p_led = std::make_unique<Led>();
 
-#if CONFIG_TARGET_GRC_DEVBOARD
+#if CONFIG_TARGET_GRC_DEVBOARD && !CONFIG_IDF_TARGET_LINUX
   p_display = std::make_unique<Lcd>(Lcd::Rotation::PORTRAIT);
 #else
   p_display = std::make_unique<DisplaySTDOUT>();
@@ -1,6 +1,10 @@
 #include "Event.hpp"
 #include "Button.hpp"
 
+#if CONFIG_IDF_TARGET_LINUX
+#include "sim.h"
+#endif
+
 enum eButtonState { DOWN, UP };
 
 #define BUTTON_HOLD_DURATION_MS 2000
@@ -18,6 +22,9 @@ size_t getTimeMS() { return xTaskGetTickCount() * portTICK_PERIOD_MS; }
 void sendEvent(Event_t ev) {
   if (xQueueSend(xEventQueue, &ev, 0) == pdPASS) {
     ESP_LOGD(TAG, "send ev=%s", event_to_str(ev));
+#if CONFIG_IDF_TARGET_LINUX
+    sim_trace("event", ev.id);
+#endif
   } else {
     ESP_LOGD(TAG, "skip ev=%s", event_to_str(ev));
   }
@@ -0,0 +1,90 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "IDisplay.hpp"
+
+/*!
+ * \brief Display frames diff and send rate limiter.
+ */
+class FrameLimiter {
+public:
+  /*!
+   * \brief Constructor.
+   * \param max_fps Max frames per second, 0 - unlimited.
+   */
+  FrameLimiter(unsigned max_fps) : last_hash_(0), last_sent_(0), stats_{} {
+    setMaxFps(max_fps);
+  }
+  /*!
+   * \brief Set max frame rate.
+   * \param max_fps Max frames per second, 0 - unlimited.
+   */
+  void setMaxFps(unsigned max_fps) {
+    min_period_ = max_fps ? pdMS_TO_TICKS(1000 / max_fps) : 0;
+  }
+  /*!
+   * \brief Compute frame hash (FNV-1a).
+   * \param data Frame data.
+   * \param len Frame data len.
+   * \return Hash.
+   */
+  static uint32_t hash(const void *data, size_t len) {
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+      h = (h ^ ptr[i]) * 16777619u;
+    }
+    return h;
+  }
+  /*!
+   * \brief Check frame against the last sent one.
+   * \param hash Frame hash.
+   * \return True if frame has changed.
+   */
+  bool changed(uint32_t hash) const {
+    return stats_.sent == 0 || hash != last_hash_;
+  }
+  /*!
+   * \brief Get time left until next send is allowed.
+   * \return Ticks to wait.
+   */
+  TickType_t delay() const {
+    const TickType_t elapsed = xTaskGetTickCount() - last_sent_;
+    if (stats_.sent == 0 || elapsed >= min_period_) {
+      return 0;
+    }
+    return min_period_ - elapsed;
+  }
+  /*!
+   * \brief Account transferred frame.
+   * \param hash Frame hash.
+   */
+  void onSent(uint32_t hash = 0) {
+    last_hash_ = hash;
+    last_sent_ = xTaskGetTickCount();
+    stats_.sent++;
+  }
+  /*!
+   * \brief Account frame equal to the last one.
+   */
+  void onSkipped() { stats_.skipped++; }
+  /*!
+   * \brief Account frame merged into a later transfer.
+   */
+  void onCoalesced() { stats_.coalesced++; }
+  /*!
+   * \brief Get statistics.
+   * \return Statistics.
+   */
+  IDisplay::FrameStats stats() const { return stats_; }
+
+private:
+  uint32_t last_hash_;
+  TickType_t last_sent_;
+  TickType_t min_period_;
+  IDisplay::FrameStats stats_;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /*!
@@ -25,6 +26,14 @@ public:
     PORTRAIT,
     UPSIDE_DOWN,
   };
+  struct FrameStats {
+    /*! \brief Frames transferred to display. */
+    size_t sent;
+    /*! \brief Frames equal to the displayed one. */
+    size_t skipped;
+    /*! \brief Frames merged into a later transfer by rate limit. */
+    size_t coalesced;
+  };
   virtual ~IDisplay() = default;
   /*!
    * \brief Set font.
@@ -72,4 +81,14 @@ public:
    * \brief Clear display buffer.
    */
   virtual void clear() = 0;
+  /*!
+   * \brief Set max rate of transfers to display.
+   * \param max_fps Max frames per second, 0 - unlimited.
+   */
+  virtual void setMaxFps(unsigned max_fps) = 0;
+  /*!
+   * \brief Get frame transfer statistics.
+   * \return Statistics.
+   */
+  virtual FrameStats getFrameStats() const = 0;
 };
@@ -0,0 +1,142 @@
+#include "DisplaySTDOUT.hpp"
+
+#include "esp_log.h"
+
+static constexpr char TAG[] = "DisplaySTDOUT";
+
+DisplaySTDOUT::DisplaySTDOUT()
+  : IDisplay(), has_pending_(false), limiter_(CONFIG_DISPLAY_MAX_FPS),
+    flush_timer_(NULL), flush_task_(NULL) {
+  mutex_ = xSemaphoreCreateMutex();
+  if (mutex_ == NULL) {
+    ESP_LOGE(TAG, "Unable to create mutex");
+    return;
+  }
+  // timer callbacks must not block, the flush runs in its own task
+  if (xTaskCreate(flush_task, "display_flush", configMINIMAL_STACK_SIZE + 1024,
+                  this, 1, &flush_task_) != pdPASS) {
+    ESP_LOGE(TAG, "Error creating flush task");
+    flush_task_ = NULL;
+    return;
+  }
+  flush_timer_ =
+    xTimerCreate("display_flush", 1, pdFALSE, this, &flush_timer_cb);
+  if (flush_timer_ == NULL) {
+    ESP_LOGE(TAG, "Error creating flush timer");
+  }
+}
+
+DisplaySTDOUT::~DisplaySTDOUT() {
+  if (flush_timer_) {
+    xTimerStop(flush_timer_, 0);
+    xTimerDelete(flush_timer_, 0);
+    flush_timer_ = NULL;
+  }
+  if (flush_task_) {
+    // not while it holds the mutex
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    vTaskDelete(flush_task_);
+    flush_task_ = NULL;
+    xSemaphoreGive(mutex_);
+  }
+  if (mutex_) {
+    vSemaphoreDelete(mutex_);
+    mutex_ = NULL;
+  }
+}
+
+void DisplaySTDOUT::append_line(const char *fmt, va_list argp) {
+  const unsigned buf_size = 64;
+  char buf[buf_size];
+  vsnprintf(buf, buf_size, fmt, argp);
+
+  frame_ += buf;
+  frame_ += '\n';
+}
+
+void DisplaySTDOUT::print_string_ln(const char *fmt, ...) {
+  va_list argp;
+  va_start(argp, fmt);
+  append_line(fmt, argp);
+  va_end(argp);
+}
+
+void DisplaySTDOUT::print_string(unsigned x, unsigned y, const char *fmt,
+                                 ...) {
+  va_list argp;
+  va_start(argp, fmt);
+  append_line(fmt, argp);
+  va_end(argp);
+}
+
+void DisplaySTDOUT::flush() {
+  const uint32_t hash = FrameLimiter::hash(pending_.data(), pending_.size());
+  printf("%s", pending_.c_str());
+  limiter_.onSent(hash);
+  has_pending_ = false;
+}
+
+void DisplaySTDOUT::flush_timer_cb(TimerHandle_t xTimer) {
+  auto *display = static_cast<DisplaySTDOUT *>(pvTimerGetTimerID(xTimer));
+  xTaskNotifyGive(display->flush_task_);
+}
+
+void DisplaySTDOUT::flush_task(void *pv) {
+  auto *display = static_cast<DisplaySTDOUT *>(pv);
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    xSemaphoreTake(display->mutex_, portMAX_DELAY);
+    if (display->has_pending_) {
+      display->flush();
+    }
+    xSemaphoreGive(display->mutex_);
+  }
+}
+
+void DisplaySTDOUT::send() {
+  if (mutex_ == NULL) {
+    printf("%s", frame_.c_str());
+    frame_.clear();
+    return;
+  }
+  const uint32_t hash = FrameLimiter::hash(frame_.data(), frame_.size());
+
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  if (has_pending_) {
+    limiter_.onCoalesced();
+  }
+  if (!limiter_.changed(hash)) {
+    // back to the displayed frame, nothing to send
+    has_pending_ = false;
+    limiter_.onSkipped();
+  } else {
+    pending_.swap(frame_);
+    has_pending_ = true;
+    const TickType_t xTicksToWait = limiter_.delay();
+    if (xTicksToWait == 0 || flush_timer_ == NULL) {
+      flush();
+    } else {
+      xTimerChangePeriod(flush_timer_, xTicksToWait, 0);
+    }
+  }
+  xSemaphoreGive(mutex_);
+  frame_.clear();
+}
+
+void DisplaySTDOUT::setMaxFps(unsigned max_fps) {
+  if (mutex_) {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    limiter_.setMaxFps(max_fps);
+    xSemaphoreGive(mutex_);
+  }
+}
+
+IDisplay::FrameStats DisplaySTDOUT::getFrameStats() const {
+  if (!mutex_) {
+    return {};
+  }
+  xSemaphoreTake(mutex_, portMAX_DELAY);
+  const auto stats = limiter_.stats();
+  xSemaphoreGive(mutex_);
+  return stats;
+}
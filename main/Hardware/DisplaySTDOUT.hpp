@@ -1,33 +1,52 @@
 #pragma once
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+
+#include "FrameLimiter.hpp"
 #include "IDisplay.hpp"
 #include "stdio.h"
 
+#include <string>
+
+/*!
+ * \brief Text display, frame lines are printed on send.
+ */
 class DisplaySTDOUT : public IDisplay {
 public:
+  DisplaySTDOUT();
+  ~DisplaySTDOUT();
+
   void setFont(Font f) override final {}
   void setRotation(Rotation rot) const override final {}
-  void print_string_ln(const char *fmt, ...) override final {
-    va_list argp;
-    va_start(argp, fmt);
-
-    vprintf(fmt, argp);
-    printf("\n");
-
-    va_end(argp);
-  }
+  void print_string_ln(const char *fmt, ...) override final;
   void print_string(unsigned x, unsigned y, const char *fmt,
-                    ...) override final {
-    va_list argp;
-    va_start(argp, fmt);
-
-    vprintf(fmt, argp);
-    printf("\n");
-
-    va_end(argp);
-  }
+                    ...) override final;
   void draw(unsigned x, unsigned y, unsigned w, unsigned h,
             const uint8_t *bitmap) override final {}
-  void send() override final {}
-  void clear() override final {}
+  void get_font_sz(unsigned &w, unsigned &h) override final { w = h = 1; }
+  void send() override final;
+  void clear() override final { frame_.clear(); }
+
+  void setMaxFps(unsigned max_fps) override final;
+  FrameStats getFrameStats() const override final;
+
+private:
+  void append_line(const char *fmt, va_list argp);
+  void flush();
+  static void flush_timer_cb(TimerHandle_t xTimer);
+  static void flush_task(void *pv);
+
+  /*! \brief Frame being drawn. */
+  std::string frame_;
+  /*! \brief Frame waiting for rate limit, guarded by mutex_. */
+  std::string pending_;
+  bool has_pending_;
+  FrameLimiter limiter_;
+  SemaphoreHandle_t mutex_;
+  /*! \brief The timer notifies the task, it prints the pending frame. */
+  TimerHandle_t flush_timer_;
+  TaskHandle_t flush_task_;
 };
@@ -2,7 +2,7 @@
 
 #include "I2C.hpp"
 
-#include <driver/i2c.h>
+#include <driver/i2c_master.h>
 #include <esp_log.h>
 
 #define I2C_MASTER_SDA_IO 3
@@ -10,72 +10,280 @@
 
 I2C g_i2c(I2C_MASTER_SDA_IO, I2C_MASTER_SCL_IO);
 
-#define I2C_MASTER_NUM            I2C_NUM_1
-#define I2C_MASTER_FREQ_HZ        400000
-#define I2C_MASTER_TX_BUF_DISABLE 0
-#define I2C_MASTER_RX_BUF_DISABLE 0
-#define I2C_MASTER_TIMEOUT_MS     1000
+#define I2C_MASTER_NUM        I2C_NUM_1
+#define I2C_MASTER_FREQ_HZ    400000
+#define I2C_MASTER_TIMEOUT_MS 1000
 
 static const char *TAG = "i2c";
 
+I2C::I2C(int sda, int scl)
+  : sda_(sda), scl_(scl), isOpened_(false), bus_(NULL), devices_{},
+    devices_num_(0), devices_mutex_(NULL), queues_{}, pending_sema_(NULL),
+    task_(NULL) {}
+
 bool I2C::open() {
   if (isOpened_)
     return true;
 
-  i2c_port_t i2c_master_port = I2C_MASTER_NUM;
-
-  i2c_config_t conf;
+  i2c_master_bus_config_t conf;
   memset(&conf, '\0', sizeof(conf));
-  conf.mode = I2C_MODE_MASTER;
-  conf.sda_io_num = sda_;
-  conf.scl_io_num = scl_;
-  conf.sda_pullup_en = GPIO_PULLUP_ENABLE;
-  conf.scl_pullup_en = GPIO_PULLUP_ENABLE;
-  conf.master.clk_speed = I2C_MASTER_FREQ_HZ;
-
-  i2c_param_config(i2c_master_port, &conf);
-
-  esp_err_t res =
-    i2c_driver_install(i2c_master_port, conf.mode, I2C_MASTER_RX_BUF_DISABLE,
-                       I2C_MASTER_TX_BUF_DISABLE, 0);
+  conf.i2c_port = I2C_MASTER_NUM;
+  conf.sda_io_num = (gpio_num_t)sda_;
+  conf.scl_io_num = (gpio_num_t)scl_;
+  conf.clk_source = I2C_CLK_SRC_DEFAULT;
+  conf.glitch_ignore_cnt = 7;
+  conf.flags.enable_internal_pullup = true;
+
+  i2c_master_bus_handle_t bus_handle;
+  esp_err_t res = i2c_new_master_bus(&conf, &bus_handle);
   if (res != ESP_OK) {
+    ESP_LOGE(TAG, "Unable to create I2C bus, %s", esp_err_to_name(res));
+    return false;
+  }
+  bus_ = bus_handle;
+
+  devices_mutex_ = xSemaphoreCreateMutex();
+  pending_sema_ =
+    xSemaphoreCreateCounting(I2C_TRANS_QUEUE_LEN * PRIORITY_NUM, 0);
+  bool errors = devices_mutex_ == NULL || pending_sema_ == NULL;
+  for (size_t i = 0; i < PRIORITY_NUM; i++) {
+    queues_[i] = xQueueCreate(I2C_TRANS_QUEUE_LEN, sizeof(trans_t));
+    errors |= queues_[i] == NULL;
+  }
+  if (errors) {
+    ESP_LOGE(TAG, "Error creating I2C queues");
+    close();
     return false;
-  } else {
-    ESP_LOGD(TAG, "I2C initialized successfully");
-    isOpened_ = true;
-    return true;
   }
+
+  auto xReturned = xTaskCreate(i2c_task, "i2c_task",
+                               configMINIMAL_STACK_SIZE + 1024 +
+                                 sizeof(trans_t),
+                               this, 3, &task_);
+  if (xReturned != pdPASS) {
+    ESP_LOGE(TAG, "Error creating i2c_task");
+    task_ = NULL;
+    close();
+    return false;
+  }
+
+  ESP_LOGD(TAG, "I2C initialized successfully");
+  isOpened_ = true;
+  return true;
 }
 
 bool I2C::close() {
-  if (!isOpened_)
-    return true;
+  if (task_) {
+    vTaskDelete(task_);
+    task_ = NULL;
+  }
+  for (size_t i = 0; i < PRIORITY_NUM; i++) {
+    if (queues_[i]) {
+      vQueueDelete(queues_[i]);
+      queues_[i] = NULL;
+    }
+  }
+  if (pending_sema_) {
+    vSemaphoreDelete(pending_sema_);
+    pending_sema_ = NULL;
+  }
+  if (devices_mutex_) {
+    vSemaphoreDelete(devices_mutex_);
+    devices_mutex_ = NULL;
+  }
+  for (size_t i = 0; i < devices_num_; i++) {
+    i2c_master_bus_rm_device(
+      static_cast<i2c_master_dev_handle_t>(devices_[i].handle));
+  }
+  devices_num_ = 0;
 
-  esp_err_t res = i2c_driver_delete(I2C_MASTER_NUM);
+  esp_err_t res = ESP_OK;
+  if (bus_) {
+    res = i2c_del_master_bus(static_cast<i2c_master_bus_handle_t>(bus_));
+    bus_ = NULL;
+  }
   if (res == ESP_OK) {
     ESP_LOGD(TAG, "I2C de-initialized successfully");
-    isOpened_ = false;
   }
+  isOpened_ = false;
   return res == ESP_OK;
 }
 
-bool I2C::write(uint8_t dev_adr, const uint8_t *buf, size_t size) {
+bool I2C::add_device(uint8_t dev_adr, Priority prio) {
   if (!isOpened_)
     return false;
 
-  esp_err_t ret =
-    i2c_master_write_to_device(I2C_MASTER_NUM, dev_adr, buf, size,
-                               I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
+  const int idx = get_device(dev_adr);
+  if (idx < 0) {
+    return false;
+  }
+  xSemaphoreTake(devices_mutex_, portMAX_DELAY);
+  devices_[idx].prio = prio;
+  xSemaphoreGive(devices_mutex_);
+  return true;
+}
+
+int I2C::get_device(uint8_t dev_adr, device_t *dev) {
+  int idx = -1;
+  xSemaphoreTake(devices_mutex_, portMAX_DELAY);
+  for (size_t i = 0; i < devices_num_; i++) {
+    if (devices_[i].adr == dev_adr) {
+      idx = i;
+      break;
+    }
+  }
+  if (idx < 0 && devices_num_ < I2C_MAX_DEVICES) {
+    i2c_device_config_t dev_cfg;
+    memset(&dev_cfg, '\0', sizeof(dev_cfg));
+    dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    dev_cfg.device_address = dev_adr;
+    dev_cfg.scl_speed_hz = I2C_MASTER_FREQ_HZ;
+
+    i2c_master_dev_handle_t dev_handle;
+    esp_err_t res = i2c_master_bus_add_device(
+      static_cast<i2c_master_bus_handle_t>(bus_), &dev_cfg, &dev_handle);
+    if (res == ESP_OK) {
+      idx = devices_num_++;
+      devices_[idx] = {.adr = dev_adr, .prio = NORMAL, .handle = dev_handle};
+      ESP_LOGD(TAG, "added device 0x%02x", dev_adr);
+    } else {
+      ESP_LOGE(TAG, "Unable to add device 0x%02x, %s", dev_adr,
+               esp_err_to_name(res));
+    }
+  } else if (idx < 0) {
+    ESP_LOGE(TAG, "Too many devices");
+  }
+  if (dev && idx >= 0) {
+    *dev = devices_[idx];
+  }
+  xSemaphoreGive(devices_mutex_);
+  return idx;
+}
+
+void I2C::i2c_task(void *pv) {
+  I2C *i2c = static_cast<I2C *>(pv);
+  trans_t trans;
+
+  for (;;) {
+    xSemaphoreTake(i2c->pending_sema_, portMAX_DELAY);
+    size_t prio = 0;
+    for (; prio < PRIORITY_NUM; prio++) {
+      if (xQueueReceive(i2c->queues_[prio], &trans, 0) == pdPASS) {
+        break;
+      }
+    }
+    if (prio == PRIORITY_NUM) {
+      continue;
+    }
+    const bool ok = i2c->execute(trans);
+    if (trans.cb) {
+      trans.cb(ok, trans.arg);
+    }
+  }
+}
+
+bool I2C::execute(const trans_t &trans) {
+  auto dev_handle = static_cast<i2c_master_dev_handle_t>(trans.dev.handle);
+  const uint8_t *wbuf = trans.wptr ? trans.wptr : trans.wbuf;
+
+  esp_err_t ret;
+  if (trans.rsize == 0) {
+    ret = i2c_master_transmit(dev_handle, wbuf, trans.wsize,
+                              I2C_MASTER_TIMEOUT_MS);
+  } else if (trans.wsize == 0) {
+    ret = i2c_master_receive(dev_handle, trans.rbuf, trans.rsize,
+                             I2C_MASTER_TIMEOUT_MS);
+  } else {
+    ret = i2c_master_transmit_receive(dev_handle, wbuf, trans.wsize,
+                                      trans.rbuf, trans.rsize,
+                                      I2C_MASTER_TIMEOUT_MS);
+  }
+  if (ret != ESP_OK) {
+    ESP_LOGW(TAG, "transaction 0x%02x failed, %s",
+             trans.dev.adr, esp_err_to_name(ret));
+  }
   return ret == ESP_OK;
 }
 
-bool I2C::write_read(uint8_t dev_adr, const uint8_t *wbuf, size_t wsize,
-                     uint8_t *rbuf, size_t rsize) {
+bool I2C::submit(trans_t &trans, uint8_t dev_adr) {
   if (!isOpened_)
     return false;
 
-  esp_err_t ret = i2c_master_write_read_device(
-    I2C_MASTER_NUM, dev_adr, wbuf, wsize, rbuf, rsize,
-    I2C_MASTER_TIMEOUT_MS / portTICK_PERIOD_MS);
-  return ret == ESP_OK;
+  // priority of the copy taken under the mutex, add_device() may change it
+  if (get_device(dev_adr, &trans.dev) < 0) {
+    return false;
+  }
+  if (xQueueSend(queues_[trans.dev.prio], &trans, portMAX_DELAY) !=
+      pdPASS) {
+    return false;
+  }
+  xSemaphoreGive(pending_sema_);
+  return true;
+}
+
+bool I2C::transfer(uint8_t dev_adr, const uint8_t *wbuf, size_t wsize,
+                   uint8_t *rbuf, size_t rsize) {
+  struct sync_ctx_t {
+    SemaphoreHandle_t sema;
+    bool ok;
+  };
+  auto done_cb = [](bool ok, void *arg) {
+    auto *ctx = static_cast<sync_ctx_t *>(arg);
+    ctx->ok = ok;
+    xSemaphoreGive(ctx->sema);
+  };
+
+  StaticSemaphore_t sema_buf;
+  sync_ctx_t ctx = {
+    .sema = xSemaphoreCreateBinaryStatic(&sema_buf),
+    .ok = false,
+  };
+
+  trans_t trans;
+  trans.wptr = wbuf;
+  trans.wsize = wsize;
+  trans.rbuf = rbuf;
+  trans.rsize = rsize;
+  trans.cb = done_cb;
+  trans.arg = &ctx;
+  const bool queued = submit(trans, dev_adr);
+
+  if (queued) {
+    // completion is bounded by I2C_MASTER_TIMEOUT_MS of the driver
+    xSemaphoreTake(ctx.sema, portMAX_DELAY);
+  }
+  vSemaphoreDelete(ctx.sema);
+  return queued && ctx.ok;
+}
+
+bool I2C::write(uint8_t dev_adr, const uint8_t *buf, size_t size) {
+  return transfer(dev_adr, buf, size, NULL, 0);
+}
+
+bool I2C::write_read(uint8_t dev_adr, const uint8_t *wbuf, size_t wsize,
+                     uint8_t *rbuf, size_t rsize) {
+  return transfer(dev_adr, wbuf, wsize, rbuf, rsize);
+}
+
+bool I2C::write_async(uint8_t dev_adr, const uint8_t *buf, size_t size,
+                      done_cb_t cb, void *arg) {
+  return write_read_async(dev_adr, buf, size, NULL, 0, cb, arg);
+}
+
+bool I2C::write_read_async(uint8_t dev_adr, const uint8_t *wbuf,
+                           size_t wsize, uint8_t *rbuf, size_t rsize,
+                           done_cb_t cb, void *arg) {
+  if (wsize > I2C_TRANS_MAX_WRITE) {
+    ESP_LOGE(TAG, "write size %u exceeds %u", wsize, I2C_TRANS_MAX_WRITE);
+    return false;
+  }
+  trans_t trans;
+  trans.wptr = NULL;
+  memcpy(trans.wbuf, wbuf, wsize);
+  trans.wsize = wsize;
+  trans.rbuf = rbuf;
+  trans.rsize = rsize;
+  trans.cb = cb;
+  trans.arg = arg;
+  return submit(trans, dev_adr);
 }
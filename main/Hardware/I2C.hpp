@@ -1,21 +1,111 @@
 #pragma once
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
 #include <stddef.h>
 #include <stdint.h>
 
-class I2C {
-private:
-  const int sda_, scl_;
-  bool isOpened_;
+#define I2C_MAX_DEVICES     4
+#define I2C_TRANS_MAX_WRITE 100
+#define I2C_TRANS_QUEUE_LEN 8
 
+/*!
+ * \brief Queued I2C master, transactions are executed by i2c_task in order
+ * of device priority.
+ */
+class I2C {
 public:
-  I2C(int sda, int scl) : sda_(sda), scl_(scl) { isOpened_ = false; }
+  enum Priority : unsigned { HIGH = 0, NORMAL, LOW, PRIORITY_NUM };
+  /*!
+   * \brief Transaction completion callback, called from i2c_task.
+   * \param ok Transaction result.
+   * \param arg User argument.
+   */
+  typedef void (*done_cb_t)(bool ok, void *arg);
+
+  I2C(int sda, int scl);
   bool open();
   bool close();
+  /*!
+   * \brief Register device, unknown devices get NORMAL priority on first use.
+   * \param dev_adr 7-bit device address.
+   * \param prio Priority of device transactions.
+   * \return Result.
+   */
+  bool add_device(uint8_t dev_adr, Priority prio);
 
+  /*!
+   * \brief Blocking write, must not be called from completion callback.
+   */
   bool write(uint8_t dev_adr, const uint8_t *buf, size_t size);
+  /*!
+   * \brief Blocking write and read, must not be called from completion
+   * callback.
+   */
   bool write_read(uint8_t dev_adr, const uint8_t *wbuf, size_t wsize,
                   uint8_t *rbuf, size_t rsize);
+  /*!
+   * \brief Queue write, buf is copied, waits only for free queue slot.
+   * \param dev_adr 7-bit device address.
+   * \param buf Data, up to I2C_TRANS_MAX_WRITE bytes.
+   * \param size Data size.
+   * \param cb Completion callback.
+   * \param arg Callback argument.
+   * \return Result of queueing.
+   */
+  bool write_async(uint8_t dev_adr, const uint8_t *buf, size_t size,
+                   done_cb_t cb = nullptr, void *arg = nullptr);
+  /*!
+   * \brief Queue write and read, rbuf must stay valid until completion.
+   * \param dev_adr 7-bit device address.
+   * \param wbuf Data to write, up to I2C_TRANS_MAX_WRITE bytes.
+   * \param wsize Data to write size.
+   * \param rbuf Buffer to read.
+   * \param rsize Buffer to read size.
+   * \param cb Completion callback.
+   * \param arg Callback argument.
+   * \return Result of queueing.
+   */
+  bool write_read_async(uint8_t dev_adr, const uint8_t *wbuf, size_t wsize,
+                        uint8_t *rbuf, size_t rsize, done_cb_t cb,
+                        void *arg = nullptr);
+
+private:
+  struct device_t {
+    uint8_t adr;
+    Priority prio;
+    void *handle;
+  };
+  struct trans_t {
+    device_t dev; // copied under devices_mutex_ by submit()
+    const uint8_t *wptr; // nullptr - data is in wbuf
+    uint8_t wbuf[I2C_TRANS_MAX_WRITE];
+    size_t wsize;
+    uint8_t *rbuf;
+    size_t rsize;
+    done_cb_t cb;
+    void *arg;
+  };
+
+  static void i2c_task(void *pv);
+  int get_device(uint8_t dev_adr, device_t *dev = nullptr);
+  bool submit(trans_t &trans, uint8_t dev_adr);
+  bool execute(const trans_t &trans);
+  bool transfer(uint8_t dev_adr, const uint8_t *wbuf, size_t wsize,
+                uint8_t *rbuf, size_t rsize);
+
+  const int sda_, scl_;
+  bool isOpened_;
+  void *bus_;
+  device_t devices_[I2C_MAX_DEVICES];
+  size_t devices_num_;
+  SemaphoreHandle_t devices_mutex_;
+  QueueHandle_t queues_[PRIORITY_NUM];
+  SemaphoreHandle_t pending_sema_;
+  TaskHandle_t task_;
 };
 
-extern I2C g_i2c;
\ No newline at end of file
+extern I2C g_i2c;
@@ -1,4 +1,5 @@
 #include "Lcd.hpp"
+#include "FrameLimiter.hpp"
 #include "I2C.hpp"
 #include "utils.h"
 
@@ -6,14 +7,31 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
 #include "U8g2lib.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "u8g2.h"
 
 static constexpr char TAG[] = "Lcd";
 
 #define STRING_LINE_COEF 1.2
 
+#define LCD_I2C_ADR 0x3c
+
+#define LCD_TILE_ROWS (DISPLAY_HEIGHT / 8)
+#define LCD_TILE_COLS (DISPLAY_WIDTH / 8)
+#define LCD_ROW_SZ    (LCD_TILE_COLS * 8)
+#define LCD_BUF_SZ    (LCD_ROW_SZ * LCD_TILE_ROWS)
+/*! \brief Delay before sending the rows of a failed transfer again. */
+#define LCD_RETRY_MS 100
+
+/*! \brief A transfer failed to queue, reset by its sender. */
+static bool s_tx_failed = false;
+
 extern "C" uint8_t u8x8_byte_hw_i2c_cb(U8X8_UNUSED u8x8_t *u8x8,
                                        U8X8_UNUSED uint8_t msg,
                                        U8X8_UNUSED uint8_t arg_int,
@@ -28,18 +46,19 @@ extern "C" uint8_t u8x8_byte_hw_i2c_cb(U8X8_UNUSED u8x8_t *u8x8,
     break;
 
   case U8X8_MSG_BYTE_SEND: {
-    unsigned rest =
+    const unsigned rest =
       std::min((unsigned)arg_int, sizeof(s_buf) / sizeof(s_buf[0]) - s_cnt);
-    uint8_t *ptr = (uint8_t *)arg_ptr;
-    while (rest--)
-      s_buf[s_cnt++] = *ptr++;
+    memcpy(&s_buf[s_cnt], arg_ptr, rest);
+    s_cnt += rest;
   } break;
 
   case U8X8_MSG_BYTE_START_TRANSFER:
     break;
   case U8X8_MSG_BYTE_END_TRANSFER: {
-    bool ret = g_i2c.write(u8x8_GetI2CAddress(u8x8) >> 1, s_buf, s_cnt);
-    (void)ret;
+    // s_buf is copied into the queued transaction
+    if (!g_i2c.write_async(u8x8_GetI2CAddress(u8x8) >> 1, s_buf, s_cnt)) {
+      s_tx_failed = true;
+    }
     s_cnt = 0;
   } break;
   default:
@@ -69,13 +88,110 @@ public:
 
 static U8G2_SSD1306_128X64_CUSTOM u8g2(U8G2_R0, U8X8_PIN_NONE);
 
+static TaskHandle_t xTaskHandle = NULL;
+static SemaphoreHandle_t xMutex = NULL;
+/*! \brief Last frame submitted by send(), guarded by xMutex. */
+static uint8_t s_pending_buf[LCD_BUF_SZ] = {0};
+/*! \brief Tile rows of s_pending_buf not yet sent to display. */
+static uint32_t s_dirty_rows = 0;
+/*! \brief Copy of dirty rows owned by lcd_task during transfer. */
+static uint8_t s_tx_buf[LCD_BUF_SZ] = {0};
+/*! \brief Transfers rate limiter, guarded by xMutex. */
+static FrameLimiter s_limiter(CONFIG_DISPLAY_MAX_FPS);
+
+static void lcd_task(void *pv) {
+  u8x8_t *u8x8 = u8g2.getU8x8();
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    // Frames submitted meanwhile are merged into this transfer.
+    xSemaphoreTake(xMutex, portMAX_DELAY);
+    const TickType_t xTicksToWait = s_limiter.delay();
+    xSemaphoreGive(xMutex);
+    vTaskDelay(xTicksToWait);
+
+    xSemaphoreTake(xMutex, portMAX_DELAY);
+    const uint32_t dirty_rows = s_dirty_rows;
+    s_dirty_rows = 0;
+    for (size_t row = 0; row < LCD_TILE_ROWS; row++) {
+      if (dirty_rows & (1u << row)) {
+        memcpy(&s_tx_buf[row * LCD_ROW_SZ], &s_pending_buf[row * LCD_ROW_SZ],
+               LCD_ROW_SZ);
+      }
+    }
+    xSemaphoreGive(xMutex);
+
+    s_tx_failed = false;
+    const int64_t t1 = esp_timer_get_time();
+    // Same transfer as u8g2_UpdateDisplayArea(), but from s_tx_buf, so that
+    // callers may keep drawing into the u8g2 buffer meanwhile.
+    for (size_t row = 0; row < LCD_TILE_ROWS; row++) {
+      if (dirty_rows & (1u << row)) {
+        u8x8_DrawTile(u8x8, 0, row, LCD_TILE_COLS,
+                      &s_tx_buf[row * LCD_ROW_SZ]);
+      }
+    }
+    u8x8_RefreshDisplay(u8x8);
+    ESP_LOGV(TAG, "sent rows=0x%02lx, %lld us", dirty_rows,
+             esp_timer_get_time() - t1);
+
+    const bool failed = s_tx_failed;
+    xSemaphoreTake(xMutex, portMAX_DELAY);
+    if (failed) {
+      // the rows go with the next frame or the retry
+      s_dirty_rows |= dirty_rows;
+    } else {
+      s_limiter.onSent();
+    }
+    xSemaphoreGive(xMutex);
+    if (failed) {
+      ESP_LOGE(TAG, "Failed to send rows=0x%02lx, retrying", dirty_rows);
+      vTaskDelay(pdMS_TO_TICKS(LCD_RETRY_MS));
+      xTaskNotifyGive(xTaskHandle);
+    }
+  }
+}
+
 Lcd::Lcd(Rotation rot) : IDisplay(), y_offset_(0) {
   if (!g_i2c.open()) {
     ESP_LOGE(TAG, "Failed to open I2C");
   }
+  // display updates yield the bus to sensors
+  g_i2c.add_device(LCD_I2C_ADR, I2C::LOW);
   u8g2.begin();
   setRotation(rot);
   setFont(IDisplay::Font::COURB24);
+
+  // u8g2.begin() has cleared the display, so it matches s_pending_buf, else
+  // all rows are sent with the first frame.
+  if (s_tx_failed) {
+    ESP_LOGE(TAG, "Failed to initialize display");
+    s_dirty_rows = (1u << LCD_TILE_ROWS) - 1;
+  }
+  xMutex = xSemaphoreCreateMutex();
+  if (xMutex == NULL) {
+    ESP_LOGE(TAG, "Unable to create mutex");
+    return;
+  }
+  auto xReturned =
+    xTaskCreate(lcd_task, "lcd_task", configMINIMAL_STACK_SIZE + 1024, NULL, 1,
+                &xTaskHandle);
+  if (xReturned != pdPASS) {
+    ESP_LOGE(TAG, "Error creating lcd_task");
+    xTaskHandle = NULL;
+  }
+}
+
+Lcd::~Lcd() {
+  if (xTaskHandle) {
+    vTaskDelete(xTaskHandle);
+    xTaskHandle = NULL;
+  }
+  if (xMutex) {
+    vSemaphoreDelete(xMutex);
+    xMutex = NULL;
+  }
 }
 
 void Lcd::setRotation(Rotation rot) const {
@@ -172,7 +288,30 @@ void Lcd::get_font_sz(unsigned &w, unsigned &h) {
 }
 
 void Lcd::send() {
-  u8g2.sendBuffer();
+  if (xTaskHandle == NULL) {
+    u8g2.sendBuffer();
+  } else {
+    const uint8_t *buf = u8g2.getBufferPtr();
+    uint32_t dirty_rows = 0;
+    xSemaphoreTake(xMutex, portMAX_DELAY);
+    for (size_t row = 0; row < LCD_TILE_ROWS; row++) {
+      const size_t offset = row * LCD_ROW_SZ;
+      if (memcmp(&s_pending_buf[offset], &buf[offset], LCD_ROW_SZ) != 0) {
+        memcpy(&s_pending_buf[offset], &buf[offset], LCD_ROW_SZ);
+        dirty_rows |= 1u << row;
+      }
+    }
+    if (!dirty_rows) {
+      s_limiter.onSkipped();
+    } else if (s_dirty_rows) {
+      s_limiter.onCoalesced();
+    }
+    s_dirty_rows |= dirty_rows;
+    xSemaphoreGive(xMutex);
+    if (dirty_rows) {
+      xTaskNotifyGive(xTaskHandle);
+    }
+  }
   u8g2.clearBuffer();
   y_offset_ = float(u8g2.getMaxCharHeight()) * STRING_LINE_COEF;
 }
@@ -181,3 +320,21 @@ void Lcd::clear() {
   u8g2.clearBuffer();
   y_offset_ = float(u8g2.getMaxCharHeight()) * STRING_LINE_COEF;
 }
+
+void Lcd::setMaxFps(unsigned max_fps) {
+  if (xMutex) {
+    xSemaphoreTake(xMutex, portMAX_DELAY);
+    s_limiter.setMaxFps(max_fps);
+    xSemaphoreGive(xMutex);
+  }
+}
+
+IDisplay::FrameStats Lcd::getFrameStats() const {
+  if (!xMutex) {
+    return {};
+  }
+  xSemaphoreTake(xMutex, portMAX_DELAY);
+  const auto stats = s_limiter.stats();
+  xSemaphoreGive(xMutex);
+  return stats;
+}
@@ -8,6 +8,7 @@
 class Lcd : public IDisplay {
 public:
   Lcd(Rotation rot = Rotation::UPSIDE_DOWN);
+  ~Lcd();
 
   void setFont(Font f) override final;
   void setRotation(Rotation rot) const override final;
@@ -22,6 +23,9 @@ public:
   void send() override final;
   void clear() override final;
 
+  void setMaxFps(unsigned max_fps) override final;
+  FrameStats getFrameStats() const override final;
+
 private:
   void draw_string(unsigned x, unsigned y, const char *fmt, va_list argp);
   unsigned y_offset_;
@@ -0,0 +1,19 @@
+#include "I2sTx.hpp"
+
+#include "esp_log.h"
+#include "sim.h"
+
+static const char *TAG = "I2sTx";
+
+void i2s_init(void) {
+  if (sim_tx_open(I2S_TX_SAMPLE_RATE) < 0) {
+    ESP_LOGE(TAG, "Unable to open sim tx");
+  }
+}
+
+void i2s_play_wav(const void *data, size_t bytes) {
+  sim_tx_write(data, bytes);
+  ESP_LOGV(TAG, "wrote bytes=%u", bytes);
+}
+
+void i2s_release(void) { sim_tx_close(); }
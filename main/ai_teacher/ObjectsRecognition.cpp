@@ -312,10 +312,10 @@ void switchSubScenario(App *app) {
   ESP_LOGD(TAG, "random_object_idx=%u, object_idx=%u, sub_scenario_idx=%u",
            random_object_idx, object_idx, sub_scenario_idx);
 
-  const nn_model_desc_t *model_desc =
-    s_int_state.sub_scenario_descs[sub_scenario_idx]
-      .object_info_table[object_idx]
-      .recognizer.model_desc;
+  const auto &recognizer = s_int_state.sub_scenario_descs[sub_scenario_idx]
+                             .object_info_table[object_idx]
+                             .recognizer;
+  const nn_model_desc_t *model_desc = recognizer.model_desc;
   int errors =
     nn_model_init(
       &s_int_state.model_handle,
@@ -323,6 +323,7 @@ void switchSubScenario(App *app) {
         .model_desc = model_desc,
         .inference_threshold =
           s_int_state.sub_scenario_descs[sub_scenario_idx].inference_threshold,
+        .op_resolver = recognizer.op_resolver,
       }) < 0;
   errors += kws_task_init(kws_task_conf_t{
               .model_handle = s_int_state.model_handle,
@@ -28,6 +28,7 @@ struct object_info_t {
 
   struct {
     const nn_model_desc_t *model_desc = nullptr;
+    const tflite::MicroOpResolver *op_resolver = nullptr;
     int label_idx = -1;
   } recognizer;
 
@@ -3979,4 +3979,14 @@ const nn_model_desc_t numbers_model = {
   .is_quantized = true,
   .mel_low_freq = 20,
   .mel_high_freq = 4000,
+  .preproc =
+    {
+      .features = NN_MODEL_FEATURES_MFCC,
+      .norm = NN_MODEL_NORM_PEAK,
+      .win_ms = 40,
+      .stride_ms = 20,
+      .duration_ms = 1000,
+      .num_fbank_bins = 40,
+      .num_mfcc = 10,
+    },
 };
@@ -3,6 +3,7 @@
 #include "ObjectsRecognition.h"
 #include "bitmaps.h"
 #include "eng_samples.h"
+#include "model_op_resolver.h"
 #include "models.h"
 
 #include "esp_log.h"
@@ -10,9 +11,12 @@
 
 static constexpr char TAG[] = "objects_table";
 
-static const nn_model_desc_t *nn_model_descs[] = {
-  &numbers_model,
-  &objects_model,
+struct {
+  const char *name;
+  const nn_model_desc_t *builtin;
+} static const nn_model_descs[] = {
+  {"numbers", &numbers_model},
+  {"objects", &objects_model},
 };
 
 static const samples_table_t *ref_samples[] = {
@@ -242,13 +246,19 @@ int init_objects_table() {
       bool found = false;
       // find nn model and correct category idx
       for (size_t m = 0; m < _countof(nn_model_descs) && !found; m++) {
-        const nn_model_desc_t *model_desc = nn_model_descs[m];
+        const nn_model_desc_t *model_desc =
+          nn_model_desc_get(nn_model_descs[m].name, nn_model_descs[m].builtin);
+        if (!model_desc) {
+          return -1;
+        }
 
         for (size_t n = EXTRA_LABELS_OFFSET;
              n < model_desc->labels_num && !found; n++) {
           if (strcmp(label, model_desc->labels[n]) == 0) {
             found = true;
             object_info.recognizer.model_desc = model_desc;
+            object_info.recognizer.op_resolver =
+              model_op_resolver_get(nn_model_descs[m].name);
             object_info.recognizer.label_idx = n;
           }
         }
@@ -0,0 +1,123 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include <algorithm>
+
+#include "I2C.hpp"
+#include "imu_task.h"
+#include "mpu9250.h"
+
+static const char *TAG = "mpu9250";
+
+#define FIFO_MAX_SAMPLES (MPU9250_FIFO_SZ / MPU9250_FIFO_SAMPLE_SZ)
+
+static uint8_t s_fifo_buf[FIFO_MAX_SAMPLES * MPU9250_FIFO_SAMPLE_SZ];
+
+static bool write_reg(uint8_t reg, uint8_t val) {
+  const uint8_t buf[] = {reg, val};
+  return g_i2c.write(MPU9250_I2C_ADR, buf, sizeof(buf));
+}
+
+static bool read_regs(uint8_t reg, uint8_t *buf, size_t len) {
+  return g_i2c.write_read(MPU9250_I2C_ADR, &reg, 1, buf, len);
+}
+
+static bool reset_fifo() {
+  return write_reg(MPU9250_USER_CTRL, MPU9250_USER_FIFO_RST) &&
+         write_reg(MPU9250_USER_CTRL, MPU9250_USER_FIFO_EN);
+}
+
+static int mpu9250_open(const imu_task_conf_t &conf) {
+  if (!g_i2c.open()) {
+    ESP_LOGE(TAG, "Failed to open I2C");
+    return -1;
+  }
+  // FIFO holds ~40 ms at 1 kHz, it must not wait for display transfers
+  g_i2c.add_device(MPU9250_I2C_ADR, I2C::HIGH);
+
+  uint8_t who_am_i = 0;
+  if (!read_regs(MPU9250_WHO_AM_I, &who_am_i, 1) ||
+      (who_am_i != MPU9250_WHO_AM_I_9250 &&
+       who_am_i != MPU9250_WHO_AM_I_9255)) {
+    ESP_LOGE(TAG, "Sensor is not found, who_am_i=0x%02x", who_am_i);
+    return -1;
+  }
+
+  write_reg(MPU9250_PWR_MGMT_1, MPU9250_PWR_RESET);
+  vTaskDelay(pdMS_TO_TICKS(100));
+
+  const uint8_t smplrt_div = MPU9250_INTERNAL_RATE_HZ / conf.sample_rate - 1;
+  const struct {
+    uint8_t reg;
+    uint8_t val;
+  } init_seq[] = {
+    {MPU9250_PWR_MGMT_1, MPU9250_PWR_CLK_PLL},
+    {MPU9250_PWR_MGMT_2, 0},
+    // keeps FIFO aligned to samples on overflow
+    {MPU9250_CONFIG, MPU9250_CONFIG_FIFO_MODE | MPU9250_CONFIG_DLPF184},
+    {MPU9250_SMPLRT_DIV, smplrt_div},
+    {MPU9250_GYRO_CONFIG, MPU9250_GYRO_FS_500DPS},
+    {MPU9250_ACCEL_CONFIG, MPU9250_ACCEL_FS_4G},
+    {MPU9250_ACCEL_CONFIG2, MPU9250_ACCEL_DLPF184},
+    {MPU9250_FIFO_EN, 0},
+    {MPU9250_USER_CTRL, MPU9250_USER_FIFO_RST},
+    {MPU9250_USER_CTRL, MPU9250_USER_FIFO_EN},
+    {MPU9250_FIFO_EN, MPU9250_FIFO_EN_GYRO | MPU9250_FIFO_EN_ACCEL},
+  };
+  for (const auto &item : init_seq) {
+    if (!write_reg(item.reg, item.val)) {
+      ESP_LOGE(TAG, "Unable to write reg 0x%02x", item.reg);
+      return -1;
+    }
+  }
+
+  ESP_LOGD(TAG, "who_am_i=0x%02x, smplrt_div=%d", who_am_i, smplrt_div);
+  return 0;
+}
+
+static void mpu9250_close() {
+  write_reg(MPU9250_FIFO_EN, 0);
+  write_reg(MPU9250_USER_CTRL, 0);
+  write_reg(MPU9250_PWR_MGMT_1, MPU9250_PWR_SLEEP);
+}
+
+static int mpu9250_read(imu_sample_t *samples, size_t max_samples) {
+  uint8_t count_buf[2];
+  if (!read_regs(MPU9250_FIFO_COUNTH, count_buf, sizeof(count_buf))) {
+    return -1;
+  }
+  const size_t count = ((count_buf[0] & 0x1f) << 8) | count_buf[1];
+  if (count > MPU9250_FIFO_SZ - MPU9250_FIFO_SAMPLE_SZ) {
+    ESP_LOGW(TAG, "FIFO overflow");
+    reset_fifo();
+    return 0;
+  }
+
+  const size_t num = std::min(
+    {count / MPU9250_FIFO_SAMPLE_SZ, max_samples, size_t(FIFO_MAX_SAMPLES)});
+  if (num == 0) {
+    return 0;
+  }
+  // single burst for all samples
+  if (!read_regs(MPU9250_FIFO_R_W, s_fifo_buf,
+                 num * MPU9250_FIFO_SAMPLE_SZ)) {
+    return -1;
+  }
+
+  for (size_t i = 0; i < num; i++) {
+    const uint8_t *ptr = &s_fifo_buf[i * MPU9250_FIFO_SAMPLE_SZ];
+    for (size_t k = 0; k < 3; k++) {
+      samples[i].accel[k] = int16_t((ptr[2 * k] << 8) | ptr[2 * k + 1]);
+      samples[i].gyro[k] = int16_t((ptr[6 + 2 * k] << 8) | ptr[6 + 2 * k + 1]);
+    }
+  }
+  return num;
+}
+
+const imu_backend_t imu_mpu9250_backend = {
+  .open = mpu9250_open,
+  .close = mpu9250_close,
+  .read = mpu9250_read,
+};
@@ -0,0 +1,57 @@
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+
+#include "imu_task.h"
+
+static const char *TAG = "imu_replay";
+
+static const imu_record_t *s_record = NULL;
+static size_t s_sample_rate = 0;
+static int64_t s_start_time = 0;
+static size_t s_emitted = 0;
+
+static int replay_open(const imu_task_conf_t &conf) {
+  if (!conf.record || !conf.record->data || !conf.record->sample_num) {
+    ESP_LOGE(TAG, "No record to replay");
+    return -1;
+  }
+  s_record = conf.record;
+  s_sample_rate =
+    s_record->sample_rate ? s_record->sample_rate : conf.sample_rate;
+  if (s_sample_rate != conf.sample_rate) {
+    ESP_LOGW(TAG, "record sample_rate=%d, requested=%d", s_sample_rate,
+             conf.sample_rate);
+  }
+  s_start_time = esp_timer_get_time();
+  s_emitted = 0;
+  return 0;
+}
+
+static void replay_close() { s_record = NULL; }
+
+static int replay_read(imu_sample_t *samples, size_t max_samples) {
+  const size_t due =
+    (esp_timer_get_time() - s_start_time) * s_sample_rate / 1000000;
+  const size_t num = std::min(due - s_emitted, max_samples);
+
+  for (size_t i = 0; i < num; i++) {
+    // loop the record
+    const int16_t *ptr =
+      &s_record->data[((s_emitted + i) % s_record->sample_num) * 6];
+    for (size_t k = 0; k < 3; k++) {
+      samples[i].accel[k] = ptr[k];
+      samples[i].gyro[k] = ptr[3 + k];
+    }
+  }
+  // samples late for more than a drain are skipped, as sensor FIFO would
+  s_emitted = due;
+  return num;
+}
+
+const imu_backend_t imu_replay_backend = {
+  .open = replay_open,
+  .close = replay_close,
+  .read = replay_read,
+};
@@ -0,0 +1,125 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+
+#include "imu_task.h"
+
+static const char *TAG = "imu_task";
+
+StreamBufferHandle_t xIMUSamplesBuffer = NULL;
+
+static TaskHandle_t xTaskHandle = NULL;
+static imu_task_conf_t s_conf;
+static size_t s_dropped_samples = 0;
+
+static void imu_task(void *pv) {
+  static imu_sample_t samples[IMU_DRAIN_MAX_SAMPLES];
+  const int64_t period_us = 1000000 / s_conf.sample_rate;
+  TickType_t xLastWakeTime = xTaskGetTickCount();
+
+  for (;;) {
+    vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(IMU_DRAIN_PERIOD_MS));
+
+    const int64_t t1 = esp_timer_get_time();
+    const int num = s_conf.backend->read(samples, IMU_DRAIN_MAX_SAMPLES);
+    if (num < 0) {
+      ESP_LOGW(TAG, "read error");
+      continue;
+    } else if (num == 0) {
+      continue;
+    }
+
+    // the newest sample has just been sampled
+    for (int i = 0; i < num; i++) {
+      samples[i].timestamp_us = t1 - (num - 1 - i) * period_us;
+    }
+
+    const size_t free_samples =
+      xStreamBufferSpacesAvailable(xIMUSamplesBuffer) / sizeof(imu_sample_t);
+    const size_t send_samples = std::min(size_t(num), free_samples);
+    xStreamBufferSend(xIMUSamplesBuffer, samples,
+                      send_samples * sizeof(imu_sample_t), 0);
+    if (send_samples < size_t(num)) {
+      s_dropped_samples += num - send_samples;
+      ESP_LOGV(TAG, "dropped %d samples", num - send_samples);
+    }
+    ESP_LOGV(TAG, "read %d samples, %lld us", num, esp_timer_get_time() - t1);
+  }
+}
+
+int imu_task_init(imu_task_conf_t conf) {
+  if (!conf.backend || conf.sample_rate == 0 ||
+      conf.sample_rate > IMU_MAX_SAMPLE_RATE_HZ) {
+    ESP_LOGE(TAG, "Invalid config, sample_rate=%d", conf.sample_rate);
+    return -1;
+  }
+  s_conf = conf;
+  s_dropped_samples = 0;
+
+  // the buffer takes at least one drain of the sensor FIFO
+  const size_t buf_ms =
+    conf.buf_duration_ms ? conf.buf_duration_ms : IMU_BUF_DURATION_MS;
+  const size_t buf_sample_num = std::max(
+    conf.sample_rate * buf_ms / 1000, size_t(IMU_DRAIN_MAX_SAMPLES));
+  const size_t buf_sz = buf_sample_num * sizeof(imu_sample_t);
+  ESP_LOGD(TAG, "buffer of %u samples, %u bytes", unsigned(buf_sample_num),
+           unsigned(buf_sz));
+
+  xIMUSamplesBuffer = xStreamBufferCreate(buf_sz, sizeof(imu_sample_t));
+  if (xIMUSamplesBuffer == NULL) {
+    ESP_LOGE(TAG, "Error creating IMU samples buffer");
+    return -1;
+  }
+
+  if (s_conf.backend->open(s_conf) < 0) {
+    ESP_LOGE(TAG, "Unable to open IMU");
+    s_conf.backend = NULL;
+    vStreamBufferDelete(xIMUSamplesBuffer);
+    xIMUSamplesBuffer = NULL;
+    return -1;
+  }
+
+  auto xReturned =
+    xTaskCreate(imu_task, "imu_task", configMINIMAL_STACK_SIZE + 1024 * 2,
+                NULL, 3, &xTaskHandle);
+  if (xReturned != pdPASS) {
+    ESP_LOGE(TAG, "Error creating imu_task");
+    xTaskHandle = NULL;
+    s_conf.backend->close();
+    s_conf.backend = NULL;
+    vStreamBufferDelete(xIMUSamplesBuffer);
+    xIMUSamplesBuffer = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+void imu_task_release() {
+  if (xTaskHandle) {
+    vTaskDelete(xTaskHandle);
+    xTaskHandle = NULL;
+  }
+  if (s_conf.backend) {
+    s_conf.backend->close();
+    s_conf.backend = NULL;
+  }
+  if (xIMUSamplesBuffer) {
+    vStreamBufferDelete(xIMUSamplesBuffer);
+    xIMUSamplesBuffer = NULL;
+  }
+}
+
+size_t imu_read_samples(imu_sample_t *samples, size_t max_samples,
+                        TickType_t xTicksToWait) {
+  const size_t xReceivedBytes =
+    xStreamBufferReceive(xIMUSamplesBuffer, samples,
+                         max_samples * sizeof(imu_sample_t), xTicksToWait);
+  return xReceivedBytes / sizeof(imu_sample_t);
+}
+
+size_t imu_dropped_samples() { return s_dropped_samples; }
@@ -0,0 +1,102 @@
+#ifndef _IMU_TASK_H_
+#define _IMU_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define IMU_MAX_SAMPLE_RATE_HZ 1000
+#define IMU_DRAIN_PERIOD_MS    10
+/*! \brief Covers the whole MPU-9250 FIFO. */
+#define IMU_DRAIN_MAX_SAMPLES 48
+
+/*! \brief Default imu_task_conf_t::buf_duration_ms. */
+#define IMU_BUF_DURATION_MS 2000
+
+/*! \brief LSB per g at +-4g range. */
+#define IMU_ACCEL_LSB_PER_G 8192.f
+/*! \brief LSB per deg/s at +-500 deg/s range. */
+#define IMU_GYRO_LSB_PER_DPS 65.5f
+
+struct imu_sample_t {
+  int64_t timestamp_us;
+  int16_t accel[3];
+  int16_t gyro[3];
+};
+
+/*! \brief Recorded samples, 6 values per sample: accel xyz, gyro xyz. */
+struct imu_record_t {
+  const int16_t *data;
+  size_t sample_num;
+  size_t sample_rate;
+};
+
+struct imu_task_conf_t;
+
+struct imu_backend_t {
+  /*!
+   * \brief Open sensor.
+   * \param conf Configuration params.
+   * \return Result.
+   */
+  int (*open)(const imu_task_conf_t &conf);
+  /*!
+   * \brief Close sensor.
+   */
+  void (*close)();
+  /*!
+   * \brief Read all available samples, oldest first.
+   * \param samples Buffer for samples, timestamps are not set.
+   * \param max_samples Buffer len.
+   * \return Number of samples or -1 on error.
+   */
+  int (*read)(imu_sample_t *samples, size_t max_samples);
+};
+
+/*! \brief MPU-9250 FIFO on g_i2c. */
+extern const imu_backend_t imu_mpu9250_backend;
+/*! \brief Playback of imu_task_conf_t::record in real time. */
+extern const imu_backend_t imu_replay_backend;
+
+struct imu_task_conf_t {
+  const imu_backend_t *backend;
+  size_t sample_rate;
+  const imu_record_t *record;
+  /*!
+   * \brief Duration of samples at sample_rate xIMUSamplesBuffer holds, e.g.
+   * the model window, 0 - IMU_BUF_DURATION_MS.
+   */
+  size_t buf_duration_ms;
+};
+
+/*! \brief Global samples buffer, imu_sample_t items. */
+extern StreamBufferHandle_t xIMUSamplesBuffer;
+
+/*!
+ * \brief Initialize IMU task.
+ * \param conf Configuration params.
+ * \return Result.
+ */
+int imu_task_init(imu_task_conf_t conf);
+/*!
+ * \brief Release IMU task.
+ */
+void imu_task_release();
+/*!
+ * \brief Read samples from xIMUSamplesBuffer.
+ * \param samples Buffer for samples.
+ * \param max_samples Buffer len.
+ * \param xTicksToWait Wait timeout.
+ * \return Number of samples.
+ */
+size_t imu_read_samples(imu_sample_t *samples, size_t max_samples,
+                        TickType_t xTicksToWait);
+/*!
+ * \brief Get number of samples dropped due to overflows.
+ * \return Number of samples.
+ */
+size_t imu_dropped_samples();
+
+#endif // _IMU_TASK_H_
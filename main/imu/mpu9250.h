@@ -0,0 +1,43 @@
+#ifndef _MPU9250_H_
+#define _MPU9250_H_
+
+#define MPU9250_I2C_ADR 0x68
+
+#define MPU9250_SMPLRT_DIV    0x19
+#define MPU9250_CONFIG        0x1A
+#define MPU9250_GYRO_CONFIG   0x1B
+#define MPU9250_ACCEL_CONFIG  0x1C
+#define MPU9250_ACCEL_CONFIG2 0x1D
+#define MPU9250_FIFO_EN       0x23
+#define MPU9250_INT_STATUS    0x3A
+#define MPU9250_USER_CTRL     0x6A
+#define MPU9250_PWR_MGMT_1    0x6B
+#define MPU9250_PWR_MGMT_2    0x6C
+#define MPU9250_FIFO_COUNTH   0x72
+#define MPU9250_FIFO_R_W      0x74
+#define MPU9250_WHO_AM_I      0x75
+
+#define MPU9250_WHO_AM_I_9250 0x71
+#define MPU9250_WHO_AM_I_9255 0x73
+
+#define MPU9250_PWR_RESET      0x80
+#define MPU9250_PWR_SLEEP      0x40
+#define MPU9250_PWR_CLK_PLL    0x01
+#define MPU9250_CONFIG_DLPF184 0x01
+/*! \brief Drop new samples when FIFO is full. */
+#define MPU9250_CONFIG_FIFO_MODE 0x40
+#define MPU9250_GYRO_FS_500DPS 0x08
+#define MPU9250_ACCEL_FS_4G    0x08
+#define MPU9250_ACCEL_DLPF184  0x01
+#define MPU9250_FIFO_EN_GYRO   0x70
+#define MPU9250_FIFO_EN_ACCEL  0x08
+#define MPU9250_USER_FIFO_EN   0x40
+#define MPU9250_USER_FIFO_RST  0x04
+#define MPU9250_INT_FIFO_OVF   0x10
+
+#define MPU9250_INTERNAL_RATE_HZ 1000
+#define MPU9250_FIFO_SZ          512
+/*! \brief Accel xyz then gyro xyz, big endian. */
+#define MPU9250_FIFO_SAMPLE_SZ 12
+
+#endif // _MPU9250_H_
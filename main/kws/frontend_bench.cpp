@@ -0,0 +1,91 @@
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "esp_agc.h"
+#include "esp_log.h"
+#include "esp_ns.h"
+#include "esp_timer.h"
+
+#include "feature_extractor.h"
+#include "frontend_bench.h"
+
+static const char *TAG = "frontend_bench";
+
+/*! \brief AGC and NS frame, ms. */
+#define BENCH_FRAME_LEN_MS 10
+
+void kws_frontend_benchmark(const nn_model_desc_t *desc, int sample_rate,
+                            size_t iterations) {
+  nn_model_desc_t pcen_desc = *desc;
+  pcen_desc.preproc.features = NN_MODEL_FEATURES_PCEN;
+  if (FeatureExtractor::Validate(desc, sample_rate) < 0 ||
+      FeatureExtractor::Validate(&pcen_desc, sample_rate) < 0) {
+    return;
+  }
+  FeatureExtractor fe(desc, sample_rate);
+  FeatureExtractor pcen(&pcen_desc, sample_rate);
+
+  void *agc = esp_agc_open(3, sample_rate);
+  ns_handle_t ns = ns_pro_create(BENCH_FRAME_LEN_MS, 2, sample_rate);
+  if (!agc || !ns) {
+    ESP_LOGE(TAG, "Unable to create agc or esp_ns");
+    if (agc) {
+      esp_agc_close(agc);
+    }
+    if (ns) {
+      ns_destroy(ns);
+    }
+    return;
+  }
+  set_agc_config(agc, 30, 1, 0);
+
+  // one second of a tone over pseudo random noise
+  const size_t frame_len = sample_rate / 1000 * BENCH_FRAME_LEN_MS;
+  const size_t len = sample_rate;
+  std::vector<int16_t> signal(len);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < len; i++) {
+    seed = seed * 1664525 + 1013904223;
+    signal[i] = int16_t(2000 * sinf(0.1f * i) + int32_t(seed >> 22) - 512);
+  }
+  std::vector<int16_t> pcm(len);
+  std::vector<float> features(fe.featuresLen);
+  std::vector<float> pcen_features(pcen.featuresLen);
+
+  size_t frames = 0;
+  int64_t cond_us = 0, fe_us = 0, pcen_us = 0;
+  for (size_t i = 0; i < iterations; i++) {
+    memcpy(pcm.data(), signal.data(), len * sizeof(int16_t));
+    int64_t t1 = esp_timer_get_time();
+    for (size_t k = 0; k + frame_len <= len; k += frame_len) {
+      esp_agc_process(agc, &pcm[k], &pcm[k], frame_len, sample_rate);
+      ns_process(ns, &pcm[k], &pcm[k]);
+    }
+    int64_t t2 = esp_timer_get_time();
+    cond_us += t2 - t1;
+
+    frames = fe.ComputeBatch(pcm.data(), len, fe.Norm(32767),
+                             features.data(), fe.frameNum);
+    t1 = esp_timer_get_time();
+    fe_us += t1 - t2;
+
+    // PCEN takes the samples as captured
+    pcen.Reset();
+    pcen.ComputeBatch(signal.data(), len, 1.f, pcen_features.data(),
+                      pcen.frameNum);
+    pcen_us += esp_timer_get_time() - t1;
+  }
+  esp_agc_close(agc);
+  ns_destroy(ns);
+
+  const double cond = double(cond_us) / iterations;
+  const double feat = double(fe_us) / iterations;
+  const double norm = double(pcen_us) / iterations;
+  ESP_LOGI(TAG, "per second of audio, %u frames of %u samples",
+           unsigned(frames), unsigned(fe.frameLen));
+  ESP_LOGI(TAG, "AGC + NS %.0f us + features %.0f us = %.0f us (%.2f%% CPU)",
+           cond, feat, cond + feat, (cond + feat) / 1e4);
+  ESP_LOGI(TAG, "PCEN features %.0f us (%.2f%% CPU), %.2fx", norm, norm / 1e4,
+           (cond + feat) / norm);
+}
@@ -0,0 +1,20 @@
+#ifndef _FRONTEND_BENCH_H_
+#define _FRONTEND_BENCH_H_
+
+#include <stddef.h>
+
+#include "nn_model.h"
+
+/*!
+ * \brief Log time per second of audio of the KWS frontends: esp-sr AGC and
+ * NS of every 10 ms followed by the model features, and PCEN features of the
+ * same framing and filterbank without AGC and NS. The host simulation esp-sr
+ * AGC is a fixed gain and NS a copy, time the target for the real ratio.
+ * \param desc Model description of the features.
+ * \param sample_rate Input sample rate.
+ * \param iterations Seconds of audio timed.
+ */
+void kws_frontend_benchmark(const nn_model_desc_t *desc, int sample_rate,
+                            size_t iterations);
+
+#endif // _FRONTEND_BENCH_H_
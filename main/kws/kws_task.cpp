@@ -1,13 +1,27 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 
-#include "audio_preprocessor.h"
+#include "feature_extractor.h"
 #include "kws_task.h"
+#include "model_preproc_tables.h"
 #include "nn_model.h"
+#include "nn_model_server.h"
 #include "vad_task.h"
 
+#if CONFIG_IDF_TARGET_LINUX
+#include "sim.h"
+#endif
+
+#if CONFIG_KWS_CASCADE
+#include "model_op_resolver.h"
+#include "nn_model_partition.h"
+#endif
+
 static const char *TAG = "kws_task";
 
+/*! \brief Feature frames computed per FeatureExtractor::ComputeBatch() call. */
+#define KWS_FEATURE_BATCH 8
+
 QueueHandle_t xKWSRequestQueue = NULL;
 QueueHandle_t xKWSResultQueue = NULL;
 EventGroupHandle_t xKWSEventGroup = NULL;
@@ -16,29 +30,59 @@ static TaskHandle_t xTaskHandle = NULL;
 
 struct kws_task_param_t {
   nn_model_handle_t model_handle = NULL;
-  AudioPreprocessor *pp = NULL;
+  /*! \brief Cascade first stage, NULL - the keyword model only. */
+  nn_model_handle_t gate_model_handle = NULL;
+  uint8_t *gate_arena = NULL;
+  FeatureExtractor *fe = NULL;
+  audio_t *proc_buf = NULL;
 } static s_kws_task_params;
 
-#define MFCC_BUF_SZ  (KWS_FRAME_NUM * KWS_NUM_MFCC * sizeof(float))
-#define FRAME_RATIO  (KWS_FRAME_SHIFT / DET_FRAME_LEN)
-#define PROC_BUF_SZ  (KWS_FRAME_SHIFT * MIC_ELEM_BYTES)
-#define FBUF_SZ      (KWS_FRAME_LEN * sizeof(float))
-#define HALF_FBUF_SZ (KWS_FRAME_SHIFT * sizeof(float))
-
-static const float silence_mfcc_coeffs[KWS_NUM_MFCC] = {
-  -247.13936,    8.881784e-16,   2.220446e-14,   -1.0658141e-14,
-  8.881784e-16,  -1.5987212e-14, 1.15463195e-14, -4.440892e-15,
-  1.0658141e-14, -4.7961635e-14};
+static kws_task_stats_t s_kws_stats;
+
+/*!
+ * \brief Run the gate model on the word features.
+ * \return false if the gate finds no keyword, the keyword model is skipped.
+ */
+static bool kws_gate(nn_model_handle_t gate_model_handle,
+                     const float *features, size_t len) {
+  int category = -1;
+  if (nn_model_server_inference(gate_model_handle, features, len,
+                                NN_MODEL_PRIORITY_HIGH, &category) < 0) {
+    // let the keyword model decide
+    return true;
+  }
+  if (category < 0) {
+    return false;
+  }
+  char label[32] = {0};
+  nn_model_get_label(gate_model_handle, category, label, sizeof(label));
+  // _silence_, _unknown_
+  return label[0] != '_';
+}
 
 void kws_task(void *pv) {
   kws_task_param_t *params = static_cast<kws_task_param_t *>(pv);
-  AudioPreprocessor *preprocessor = params->pp;
+  FeatureExtractor *fe = params->fe;
   nn_model_handle_t model_handle = params->model_handle;
-  audio_t proc_buf[KWS_FRAME_SHIFT] = {0};
-  float fbuf[KWS_FRAME_LEN] = {0};
-  float *half_fbuf = &fbuf[KWS_FRAME_SHIFT];
-
-  xStreamBufferSetTriggerLevel(xWordFramesBuffer, PROC_BUF_SZ);
+  nn_model_handle_t gate_model_handle = params->gate_model_handle;
+#if CONFIG_KWS_SHARED_STFT
+  // word frames are the feature rows
+  const size_t row_sz = fe->numCoeffs * sizeof(float);
+  const size_t head_rows = (fe->frameLen - fe->frameShift) / fe->frameShift;
+  xStreamBufferSetTriggerLevel(xWordFramesBuffer, row_sz);
+#else
+  // batch: head of frameLen - frameShift samples, then the frameShift new
+  // ones of every frame
+  audio_t *proc_buf = params->proc_buf;
+  const size_t head_len = fe->frameLen - fe->frameShift;
+  audio_t *shift_buf = &proc_buf[head_len];
+  const size_t frame_ratio = fe->frameShift / DET_FRAME_LEN;
+  const size_t shift_sz = fe->frameShift * MIC_ELEM_BYTES;
+  const size_t buf_sz =
+    head_len * MIC_ELEM_BYTES + KWS_FEATURE_BATCH * shift_sz;
+
+  xStreamBufferSetTriggerLevel(xWordFramesBuffer, shift_sz);
+#endif
 
   for (;;) {
     size_t req_words = 0;
@@ -46,7 +90,7 @@ void kws_task(void *pv) {
 
     ESP_LOGD(TAG, "recogninze req_words=%d", req_words);
 
-    float *mfcc_coeffs = new float[KWS_FRAME_NUM * KWS_NUM_MFCC];
+    float *features = new float[fe->featuresLen];
 
     vad_task_start();
     size_t det_words = 0;
@@ -66,59 +110,82 @@ void kws_task(void *pv) {
                  word.max_abs);
       }
 
-      memset(proc_buf, 0, PROC_BUF_SZ);
-      memset(mfcc_coeffs, 0, MFCC_BUF_SZ);
-      memset(fbuf, 0, sizeof(fbuf));
-
       const int64_t t1 = esp_timer_get_time();
-      const size_t mfcc_frames =
-        std::min((word.frame_num + FRAME_RATIO - 1) / FRAME_RATIO,
-                 size_t(KWS_FRAME_NUM));
-      ESP_LOGD(TAG, "mfcc_frames=%d", mfcc_frames);
+#if CONFIG_KWS_SHARED_STFT
+      // a row ends with its frame shift, the first head_rows ones start
+      // before the word: dropped, so row f starts at f * frameShift of the
+      // word as in ComputeBatch()
+      const size_t word_rows = word.frame_num * DET_FRAME_LEN / fe->frameShift;
+      const size_t skip_rows = std::min(word_rows, head_rows);
+      for (size_t i = 0; i < skip_rows; i++) {
+        xStreamBufferReceive(xWordFramesBuffer, features, row_sz, 0);
+      }
+      const size_t feat_frames =
+        std::min(word_rows - skip_rows, fe->frameNum);
+      ESP_LOGD(TAG, "feat_frames=%d", feat_frames);
+      const float norm = fe->Norm(word.max_abs);
+
+      const size_t proc_frames =
+        xStreamBufferReceive(xWordFramesBuffer, features,
+                             feat_frames * row_sz, 0) /
+        row_sz;
+      // PCEN starts from the first frame of the word
+      fe->Reset();
+      fe->Normalize(features, proc_frames, norm);
+#else
+      memset(proc_buf, 0, buf_sz);
+
+      const size_t feat_frames =
+        std::min((word.frame_num + frame_ratio - 1) / frame_ratio,
+                 fe->frameNum);
+      ESP_LOGD(TAG, "feat_frames=%d", feat_frames);
+      const float norm = fe->Norm(word.max_abs);
 
       size_t frame_idx = 0;
+      // PCEN starts from the first frame of the word
+      fe->Reset();
 
-      auto xReceivedBytes =
-        xStreamBufferReceive(xWordFramesBuffer, proc_buf, PROC_BUF_SZ, 0);
+      auto xReceivedBytes = xStreamBufferReceive(
+        xWordFramesBuffer, proc_buf, head_len * MIC_ELEM_BYTES, 0);
       ESP_LOGV(TAG, "recv bytes=%d", xReceivedBytes);
-
-      for (size_t i = 0; i < KWS_FRAME_SHIFT; i++) {
-        fbuf[i] = static_cast<float>(proc_buf[i]) / word.max_abs;
-      }
-      frame_idx += FRAME_RATIO;
+      frame_idx += head_len / DET_FRAME_LEN;
 
       size_t proc_frames = 0;
-      for (; proc_frames < mfcc_frames;) {
-        const auto xReceivedBytes =
-          xStreamBufferReceive(xWordFramesBuffer, proc_buf, PROC_BUF_SZ, 0);
+      for (; proc_frames < feat_frames;) {
+        const size_t batch =
+          std::min(feat_frames - proc_frames, size_t(KWS_FEATURE_BATCH));
+        const auto xReceivedBytes = xStreamBufferReceive(
+          xWordFramesBuffer, shift_buf, batch * shift_sz, 0);
         ESP_LOGV(TAG, "recv bytes=%d", xReceivedBytes);
-
-        for (size_t i = 0; i < KWS_FRAME_SHIFT; i++) {
-          half_fbuf[i] = static_cast<float>(proc_buf[i]) / word.max_abs;
+        if (xReceivedBytes == 0) {
+          break;
         }
 
-        preprocessor->MfccCompute(fbuf,
-                                  &mfcc_coeffs[proc_frames * KWS_NUM_MFCC]);
+        // frames with new samples, the rest of the word is not in the buffer
+        const size_t received = xReceivedBytes / MIC_ELEM_BYTES;
+        const size_t frames = fe->ComputeBatch(
+          proc_buf, head_len + received, norm,
+          &features[proc_frames * fe->numCoeffs],
+          (received + fe->frameShift - 1) / fe->frameShift);
 
-        memmove(fbuf, half_fbuf, HALF_FBUF_SZ);
-        memset(half_fbuf, 0, HALF_FBUF_SZ);
+        memmove(proc_buf, &proc_buf[frames * fe->frameShift],
+                head_len * MIC_ELEM_BYTES);
+        memset(shift_buf, 0, batch * shift_sz);
 
-        if (xReceivedBytes == 0) {
+        frame_idx += frames * frame_ratio;
+        proc_frames += frames;
+        if (xReceivedBytes < batch * shift_sz) {
           break;
-        } else {
-          frame_idx += FRAME_RATIO;
-          proc_frames++;
         }
       }
 
       ESP_LOGD(TAG, "proc %d mic frames", frame_idx);
+#endif
 
-      memset(proc_buf, 0, PROC_BUF_SZ);
-      for (size_t i = mfcc_frames; i < KWS_FRAME_NUM; i++) {
-        memcpy(&mfcc_coeffs[i * KWS_NUM_MFCC], silence_mfcc_coeffs,
-               KWS_NUM_MFCC * sizeof(float));
+      for (size_t i = proc_frames; i < fe->frameNum; i++) {
+        fe->Silence(&features[i * fe->numCoeffs]);
       }
-      ESP_LOGD(TAG, "preproc %d frames[%d]=%lld us", KWS_FRAME_NUM, det_words,
+      ESP_LOGD(TAG, "preproc %d frames[%d]=%lld us", fe->frameNum, det_words,
                esp_timer_get_time() - t1);
 
       if (word.frame_num > DET_WORD_BUF_FRAME_NUM) {
@@ -129,11 +196,23 @@ void kws_task(void *pv) {
 
       char result[32] = {0};
       int category = -1;
-      nn_model_inference(model_handle, mfcc_coeffs, KWS_FEATURES_LEN,
-                         &category);
+      s_kws_stats.words++;
+      const int64_t t2 = esp_timer_get_time();
+      if (gate_model_handle &&
+          !kws_gate(gate_model_handle, features, fe->featuresLen)) {
+        s_kws_stats.gate_rejected++;
+        ESP_LOGD(TAG, "gate rejected word[%d]=%lld us", det_words,
+                 esp_timer_get_time() - t2);
+      } else {
+        nn_model_server_inference(model_handle, features, fe->featuresLen,
+                                  NN_MODEL_PRIORITY_HIGH, &category);
+      }
       nn_model_get_label(model_handle, category, result, sizeof(result));
       ESP_LOGI(TAG, ">> kws[%d]=%s", det_words, result);
       xQueueSend(xKWSResultQueue, &category, 0);
+#if CONFIG_IDF_TARGET_LINUX
+      sim_trace("kws", category);
+#endif
       det_words++;
     }
 
@@ -144,19 +223,76 @@ void kws_task(void *pv) {
     vad_task_stop();
     xQueueReset(xWordQueue);
     xStreamBufferReset(xWordFramesBuffer);
-    delete[] mfcc_coeffs;
+    delete[] features;
     xQueueReceive(xKWSRequestQueue, &req_words, 0);
     xEventGroupSetBits(xKWSEventGroup, KWS_STOPPED_MSK);
   }
 }
 
+#if CONFIG_KWS_CASCADE
+static int kws_gate_init(const nn_model_desc_t *model_desc) {
+  const char *name = CONFIG_KWS_CASCADE_GATE_MODEL;
+  const nn_model_desc_t *gate_desc = nn_model_desc_get(name, NULL);
+  if (!gate_desc) {
+    ESP_LOGW(TAG, "cascade is disabled, no %s model", name);
+    return 0;
+  }
+  const nn_model_preproc_t &a = model_desc->preproc;
+  const nn_model_preproc_t &b = gate_desc->preproc;
+  if (a.features != b.features || a.norm != b.norm || a.win_ms != b.win_ms ||
+      a.stride_ms != b.stride_ms || a.duration_ms != b.duration_ms ||
+      a.num_fbank_bins != b.num_fbank_bins || a.num_mfcc != b.num_mfcc ||
+      a.fft_len != b.fft_len ||
+      model_desc->mel_low_freq != gate_desc->mel_low_freq ||
+      model_desc->mel_high_freq != gate_desc->mel_high_freq) {
+    ESP_LOGE(TAG, "%s features differ from the keyword model ones", name);
+    return -1;
+  }
+
+  const size_t arena_size = CONFIG_KWS_CASCADE_GATE_ARENA_SIZE * 1024;
+  s_kws_task_params.gate_arena = new uint8_t[arena_size];
+  if (nn_model_init(&s_kws_task_params.gate_model_handle,
+                    nn_model_config_t{
+                      .model_desc = gate_desc,
+                      .inference_threshold =
+                        CONFIG_KWS_CASCADE_GATE_THRESHOLD / 100.f,
+                      .op_resolver = model_op_resolver_get(name),
+                      .tensor_arena = s_kws_task_params.gate_arena,
+                      .tensor_arena_size = arena_size,
+                    }) < 0) {
+    s_kws_task_params.gate_model_handle = NULL;
+    return -1;
+  }
+  return nn_model_server_attach(s_kws_task_params.gate_model_handle);
+}
+#endif
+
 int kws_task_init(kws_task_conf_t conf) {
-  ESP_LOGD(TAG, "KWS_FRAME_LEN=%d, KWS_FRAME_SHIFT=%d, KWS_FRAME_NUM=%d",
-           KWS_FRAME_LEN, KWS_FRAME_SHIFT, KWS_FRAME_NUM);
-  ESP_LOGD(TAG, "PROC_BUF_SZ=%d, FBUF_SZ=%d, HALF_FBUF_SZ=%d", PROC_BUF_SZ,
-           FBUF_SZ, HALF_FBUF_SZ);
-  ESP_LOGD(TAG, "FRAME_RATIO=%d, DET_WORD_BUF_FRAME_NUM=%d", FRAME_RATIO,
-           DET_WORD_BUF_FRAME_NUM);
+  if (FeatureExtractor::Validate(conf.model_desc, CONFIG_KWS_SAMPLE_RATE) <
+      0) {
+    return -1;
+  }
+  s_kws_task_params.fe =
+    new FeatureExtractor(conf.model_desc, CONFIG_KWS_SAMPLE_RATE,
+                         model_preproc_tables_get(conf.model_desc,
+                                                  CONFIG_KWS_SAMPLE_RATE));
+  FeatureExtractor *fe = s_kws_task_params.fe;
+  ESP_LOGD(TAG, "frame_len=%d, frame_shift=%d, frame_num=%d", fe->frameLen,
+           fe->frameShift, fe->frameNum);
+  ESP_LOGD(TAG, "DET_WORD_BUF_FRAME_NUM=%d", DET_WORD_BUF_FRAME_NUM);
+  if (fe->frameShift % DET_FRAME_LEN || fe->frameLen % DET_FRAME_LEN) {
+    ESP_LOGE(TAG, "frames are not aligned to VAD frames");
+    return -1;
+  }
+  vad_task_set_conditioning(fe->preproc.features != NN_MODEL_FEATURES_PCEN);
+#if CONFIG_KWS_SHARED_STFT
+  if (vad_task_set_features(fe) < 0) {
+    return -1;
+  }
+#else
+  s_kws_task_params.proc_buf =
+    new audio_t[fe->frameLen + (KWS_FEATURE_BATCH - 1) * fe->frameShift];
+#endif
 
   xKWSResultQueue = xQueueCreate(4, sizeof(int));
   if (xKWSResultQueue == NULL) {
@@ -174,10 +310,17 @@ int kws_task_init(kws_task_conf_t conf) {
     return -1;
   }
 
-  s_kws_task_params.pp = new AudioPreprocessor(
-    CONFIG_KWS_SAMPLE_RATE, KWS_NUM_MFCC, KWS_FRAME_LEN, KWS_NUM_FBANK_BINS,
-    conf.model_desc->mel_low_freq, conf.model_desc->mel_high_freq);
+  if (nn_model_server_init() < 0 ||
+      nn_model_server_attach(conf.model_handle) < 0) {
+    return -1;
+  }
   s_kws_task_params.model_handle = conf.model_handle;
+#if CONFIG_KWS_CASCADE
+  if (kws_gate_init(conf.model_desc) < 0) {
+    return -1;
+  }
+#endif
+  s_kws_stats = kws_task_stats_t{};
   auto xReturned =
     xTaskCreate(kws_task, "kws_task", configMINIMAL_STACK_SIZE + 1024 * 6,
                 &s_kws_task_params, 1, &xTaskHandle);
@@ -194,13 +337,35 @@ void kws_task_release() {
   xEventGroupClearBits(xKWSEventGroup, KWS_RUNNING_MSK);
   kws_req_cancel();
 
+  nn_model_server_detach(s_kws_task_params.model_handle);
+  nn_model_server_detach(s_kws_task_params.gate_model_handle);
   if (xTaskHandle) {
     vTaskDelete(xTaskHandle);
     xTaskHandle = NULL;
   }
-  if (s_kws_task_params.pp) {
-    delete s_kws_task_params.pp;
-    s_kws_task_params.pp = NULL;
+  nn_model_server_release();
+  if (s_kws_task_params.gate_model_handle) {
+    ESP_LOGI(TAG, "cascade: %lu words, %lu rejected by the gate",
+             (unsigned long)s_kws_stats.words,
+             (unsigned long)s_kws_stats.gate_rejected);
+    nn_model_release(s_kws_task_params.gate_model_handle);
+    s_kws_task_params.gate_model_handle = NULL;
+  }
+  if (s_kws_task_params.gate_arena) {
+    delete[] s_kws_task_params.gate_arena;
+    s_kws_task_params.gate_arena = NULL;
+  }
+  if (s_kws_task_params.fe) {
+#if CONFIG_KWS_SHARED_STFT
+    // waits for vad_task to finish the frame using fe
+    vad_task_set_features(NULL);
+#endif
+    delete s_kws_task_params.fe;
+    s_kws_task_params.fe = NULL;
+  }
+  if (s_kws_task_params.proc_buf) {
+    delete[] s_kws_task_params.proc_buf;
+    s_kws_task_params.proc_buf = NULL;
   }
   s_kws_task_params.model_handle = NULL;
 
@@ -236,3 +401,5 @@ void kws_req_cancel() {
                         portMAX_DELAY);
   }
 }
+
+void kws_task_get_stats(kws_task_stats_t *stats) { *stats = s_kws_stats; }
@@ -10,18 +10,6 @@
 
 #include "nn_model.h"
 
-#define KWS_NUM_FBANK_BINS 40
-
-#define KWS_NUM_MFCC    10
-#define KWS_WIN_MS      40
-#define KWS_STRIDE_MS   20
-#define KWS_DURATION_MS 1000
-#define KWS_FRAME_LEN   (CONFIG_KWS_SAMPLE_RATE / 1000 * KWS_WIN_MS)
-#define KWS_FRAME_SHIFT (CONFIG_KWS_SAMPLE_RATE / 1000 * KWS_STRIDE_MS)
-#define KWS_FRAME_NUM   ((KWS_DURATION_MS - KWS_WIN_MS) / KWS_STRIDE_MS + 1)
-
-#define KWS_FEATURES_LEN KWS_FRAME_NUM *KWS_NUM_MFCC
-
 /*! \brief Global KWS word request queue. */
 extern QueueHandle_t xKWSRequestQueue;
 /*! \brief Global KWS output category queue. */
@@ -37,6 +25,14 @@ struct kws_task_conf_t {
   const nn_model_desc_t *model_desc;
 };
 
+struct kws_task_stats_t {
+  /*! \brief Words passed to recognition. */
+  uint32_t words;
+  /*! \brief Words rejected by the cascade gate model, the keyword model is
+   * not run for them. */
+  uint32_t gate_rejected;
+};
+
 /*!
  * \brief Initialize KWS task.
  * \param conf Configuration params.
@@ -57,5 +53,10 @@ void kws_req_word(size_t req_words);
  * \brief Cancel request.
  */
 void kws_req_cancel();
+/*!
+ * \brief Get recognition statistics since the task init.
+ * \param stats Statistics.
+ */
+void kws_task_get_stats(kws_task_stats_t *stats);
 
 #endif // _KWS_TASK_H_
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#include "stft_frontend.h"
+
+/*! \brief VAD band, Hz. */
+#define STFT_VAD_BAND_LOW  300
+#define STFT_VAD_BAND_HIGH 3400
+/*! \brief Band energy to noise energy ratio of speech, 6 dB. */
+#define STFT_VAD_SNR 4.0f
+/*! \brief Spectral flatness of speech is below, 1 for white noise. */
+#define STFT_VAD_FLATNESS 0.45f
+/*! \brief Frames at start taken as noise. */
+#define STFT_NOISE_INIT_FRAMES 10
+/*! \brief Noise estimate smoothing in non-speech and speech frames. */
+#define STFT_NOISE_ADAPT        0.1f
+#define STFT_NOISE_ADAPT_SPEECH 0.005f
+/*! \brief Noise floor, rms of white noise in LSB. */
+#define STFT_NOISE_FLOOR_LSB 2
+/*! \brief Spectral subtraction over-subtraction and spectral floor. */
+#define STFT_NS_OVERSUB 1.5f
+#define STFT_NS_FLOOR   0.05f
+
+STFTFrontend::STFTFrontend(FeatureExtractor *fe, int sample_rate)
+  : fe(fe), frame(fe->frameLen, 0), power(fe->SpectrumLen()),
+    noise(fe->SpectrumLen()), frames(0) {
+  const size_t fft_len = 2 * (fe->SpectrumLen() - 1);
+  bandFirst = size_t(STFT_VAD_BAND_LOW) * fft_len / sample_rate;
+  bandLast = std::min(size_t(STFT_VAD_BAND_HIGH) * fft_len / sample_rate,
+                      fe->SpectrumLen() - 1);
+}
+
+bool STFTFrontend::Process(const audio_t *samples, float *features) {
+  const size_t head_len = fe->frameLen - fe->frameShift;
+  memmove(frame.data(), &frame[fe->frameShift], head_len * sizeof(audio_t));
+  memcpy(&frame[head_len], samples, fe->frameShift * sizeof(audio_t));
+  fe->Spectrum(frame.data(), power.data());
+
+  // white noise of STFT_NOISE_FLOOR_LSB through the Hann window
+  const float noise_floor = 0.375f * fe->frameLen * STFT_NOISE_FLOOR_LSB *
+                            STFT_NOISE_FLOOR_LSB;
+  const size_t band_len = bandLast - bandFirst + 1;
+  float energy = 0, noise_energy = 0, log_sum = 0;
+  for (size_t k = bandFirst; k <= bandLast; k++) {
+    energy += power[k];
+    noise_energy += std::max(noise[k], noise_floor);
+    log_sum += logf(power[k] + 1.f);
+  }
+  const float flatness = expf(log_sum / band_len) / (energy / band_len + 1.f);
+
+  bool is_speech = false;
+  if (frames < STFT_NOISE_INIT_FRAMES) {
+    // running mean of the first frames
+    for (size_t k = 0; k < power.size(); k++) {
+      noise[k] += (power[k] - noise[k]) / (frames + 1);
+    }
+  } else {
+    is_speech =
+      energy > STFT_VAD_SNR * noise_energy && flatness < STFT_VAD_FLATNESS;
+    // fast out of speech and to lower power, slow to higher power in speech
+    for (size_t k = 0; k < power.size(); k++) {
+      const float adapt = !is_speech || power[k] < noise[k]
+                            ? STFT_NOISE_ADAPT
+                            : STFT_NOISE_ADAPT_SPEECH;
+      noise[k] += adapt * (power[k] - noise[k]);
+    }
+  }
+  frames++;
+
+  // spectral subtraction, PCEN features take the noise floor out themselves
+  if (fe->preproc.features != NN_MODEL_FEATURES_PCEN) {
+    for (size_t k = 0; k < power.size(); k++) {
+      power[k] = std::max(power[k] - STFT_NS_OVERSUB * noise[k],
+                          STFT_NS_FLOOR * power[k]);
+    }
+  }
+  fe->SpectrumFeatures(power.data(), features);
+  return is_speech;
+}
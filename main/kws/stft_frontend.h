@@ -0,0 +1,48 @@
+#ifndef _STFT_FRONTEND_H_
+#define _STFT_FRONTEND_H_
+
+#include <stddef.h>
+#include <vector>
+
+#include "def.h"
+#include "feature_extractor.h"
+
+/*!
+ * \brief Shared STFT stage of the capture path: one power spectrum per
+ * feature frame of the keyword model feeds spectral subtraction noise
+ * suppression, an energy and spectral flatness VAD and the model filterbank,
+ * instead of esp-sr NS and VAD with their own transforms and a second FFT in
+ * kws_task. Noise suppression is skipped for PCEN features.
+ */
+class STFTFrontend {
+public:
+  /*!
+   * \brief Constructor.
+   * \param fe Features of the keyword model.
+   * \param sample_rate Input sample rate.
+   */
+  STFTFrontend(FeatureExtractor *fe, int sample_rate);
+
+  /*!
+   * \brief Process the next frame.
+   * \param samples frameShift new samples.
+   * \param features numCoeffs features of the frame ending with the samples,
+   * not normalized, see FeatureExtractor::Normalize().
+   * \return true if the frame is speech.
+   */
+  bool Process(const audio_t *samples, float *features);
+
+private:
+  FeatureExtractor *fe;
+  /*! \brief Last frameLen samples. */
+  std::vector<audio_t> frame;
+  std::vector<float> power;
+  /*! \brief Noise power estimate per bin. */
+  std::vector<float> noise;
+  /*! \brief Bins of the VAD band. */
+  size_t bandFirst;
+  size_t bandLast;
+  size_t frames;
+};
+
+#endif // _STFT_FRONTEND_H_
@@ -5,7 +5,6 @@
 #include <cmath>
 
 #include "esp_agc.h"
-#include "esp_dsp.h"
 #include "esp_log.h"
 #include "esp_ns.h"
 #include "esp_vad.h"
@@ -15,6 +14,14 @@
 #include "mic_reader.h"
 #include "vad_task.h"
 
+#if CONFIG_KWS_SHARED_STFT
+#include "stft_frontend.h"
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+#include "sim.h"
+#endif
+
 static const char *TAG = "vad_task";
 
 #define AGC_FRAME_LEN_MS 10
@@ -24,21 +31,206 @@ static TaskHandle_t xTaskHandle = NULL;
 static ns_handle_t s_ns_handle = NULL;
 static void *s_agc_handle = NULL;
 static vad_handle_t s_vad_handle = NULL;
+static bool s_conditioning = true;
 
 QueueHandle_t xWordQueue = NULL;
 StreamBufferHandle_t xWordFramesBuffer = NULL;
 EventGroupHandle_t xVADEventGroup = NULL;
 
+#if !CONFIG_KWS_SHARED_STFT
 static audio_t current_frames[DET_VOICED_FRAMES_WINDOW * DET_FRAME_LEN] = {0};
-
-static void vad_task(void *pv) {
-  size_t max_abs_arr[DET_VOICED_FRAMES_WINDOW] = {0};
-  uint8_t is_speech_arr[DET_VOICED_FRAMES_WINDOW] = {0};
-  size_t cur_frame = 0;
-  size_t num_voiced = 0;
-  uint8_t trig = 0;
+#endif
+
+/*!
+ * \brief Word segmentation over the last units: a unit is a mic frame, or a
+ * feature row of several mic frames with the shared STFT frontend. Units of a
+ * word go to xWordFramesBuffer, its length is counted in mic frames.
+ */
+struct vad_words_t {
+  uint8_t *ring;
+  size_t unit_sz;
+  /*! \brief Mic frames per unit. */
+  size_t unit_frames;
+  size_t window;
+  size_t voiced_threshold;
+  size_t unvoiced_threshold;
+  size_t max_abs_arr[DET_VOICED_FRAMES_WINDOW];
+  uint8_t is_speech_arr[DET_VOICED_FRAMES_WINDOW];
+  size_t cur;
+  size_t num_voiced;
+  uint8_t trig;
   WordDesc_t word;
+} static s_words;
+
+static void vad_words_init(uint8_t *ring, size_t unit_sz, size_t unit_frames) {
+  s_words = vad_words_t{
+    .ring = ring,
+    .unit_sz = unit_sz,
+    .unit_frames = unit_frames,
+    .window = DET_VOICED_FRAMES_WINDOW / unit_frames,
+    .voiced_threshold = DET_VOICED_FRAMES_THRESHOLD / unit_frames,
+    .unvoiced_threshold = DET_UNVOICED_FRAMES_THRESHOLD / unit_frames,
+  };
+}
+
+/*! \brief Slot of the next unit. */
+static uint8_t *vad_words_unit() {
+  return &s_words.ring[(s_words.cur % s_words.window) * s_words.unit_sz];
+}
+
+static void word_frames_send(const uint8_t *unit) {
+  const auto xBytesSent =
+    xStreamBufferSend(xWordFramesBuffer, unit, s_words.unit_sz, 0);
+  if (xBytesSent < s_words.unit_sz) {
+    ESP_LOGW(TAG, "xWordFramesBuffer: xBytesSent=%d (%d)", xBytesSent,
+             s_words.unit_sz);
+#if CONFIG_IDF_TARGET_LINUX
+    sim_trace("word_buf_overrun", xBytesSent);
+#endif
+  }
+}
+
+/*!
+ * \brief Add the unit written to vad_words_unit().
+ * \param is_speech Voice activity of the unit.
+ * \param max_abs Peak of the unit samples.
+ */
+static void vad_words_push(uint8_t is_speech, size_t max_abs) {
+  vad_words_t &w = s_words;
+  const size_t cur = w.cur % w.window;
+  w.max_abs_arr[cur] = max_abs;
+
+  w.num_voiced += is_speech;
+  w.is_speech_arr[cur] = is_speech;
+
+  if (!w.trig) {
+    if (w.num_voiced >= w.voiced_threshold) {
+      w.word.frame_num = 0;
+      w.word.max_abs = 0;
+      w.trig = 1;
+      ESP_LOGD(TAG, "__start[%d]=%d, max_abs=%d", w.cur - w.window, w.cur,
+               max_abs);
+      for (size_t k = 1; k <= w.window; k++) {
+        const size_t unit_num = (w.cur + k) % w.window;
+        word_frames_send(&w.ring[unit_num * w.unit_sz]);
+        w.word.frame_num += w.unit_frames;
+        w.word.max_abs = std::max(w.word.max_abs, w.max_abs_arr[unit_num]);
+      }
+    }
+  } else {
+    if (w.num_voiced <= w.unvoiced_threshold) {
+      w.trig = 0;
+      ESP_LOGD(TAG, "__end[%d]=%d, max_abs=%d", w.cur - w.window, w.cur,
+               max_abs);
+      xQueueSend(xWordQueue, &w.word, 0);
+#if CONFIG_IDF_TARGET_LINUX
+      sim_trace("vad_word", w.word.frame_num);
+#endif
+    } else {
+      w.word.frame_num += w.unit_frames;
+      w.word.max_abs = std::max(w.word.max_abs, max_abs);
+      word_frames_send(&w.ring[cur * w.unit_sz]);
+    }
+  }
+
+  w.num_voiced -= w.is_speech_arr[(w.cur + 1) % w.window];
+
+  w.cur++;
+}
+
+void vad_task_set_conditioning(bool enable) { s_conditioning = enable; }
+
+#if CONFIG_KWS_SHARED_STFT
+/*! \brief Taken by vad_task per frame and to swap the frontend. */
+static SemaphoreHandle_t s_frontend_mutex = NULL;
+static STFTFrontend *s_frontend = NULL;
+static FeatureExtractor *s_frontend_fe = NULL;
+static float *s_feature_rows = NULL;
+/*! \brief Mic frames of a feature frame shift, the filled ones and peak. */
+static audio_t *s_hop = NULL;
+static size_t s_hop_frames = 0;
+static size_t s_hop_max_abs = 0;
+
+/*! \brief Replace the frontend, vad_task does not run it. */
+static int vad_stft_reset(FeatureExtractor *fe) {
+  delete s_frontend;
+  s_frontend = NULL;
+  delete[] s_feature_rows;
+  s_feature_rows = NULL;
+  delete[] s_hop;
+  s_hop = NULL;
+  s_hop_frames = 0;
+  s_hop_max_abs = 0;
+  s_frontend_fe = fe;
+  if (!fe) {
+    return 0;
+  }
+  const size_t unit_frames = fe->frameShift / DET_FRAME_LEN;
+  // kws_task drops the rows starting before a word, whole shifts
+  if (fe->frameShift % DET_FRAME_LEN ||
+      DET_VOICED_FRAMES_WINDOW % unit_frames ||
+      fe->frameLen % fe->frameShift) {
+    ESP_LOGE(TAG, "frames of %d every %d samples do not fit VAD frames",
+             fe->frameLen, fe->frameShift);
+    s_frontend_fe = NULL;
+    return -1;
+  }
+  s_frontend = new STFTFrontend(fe, CONFIG_KWS_SAMPLE_RATE);
+  const size_t window = DET_VOICED_FRAMES_WINDOW / unit_frames;
+  s_feature_rows = new float[window * fe->numCoeffs];
+  s_hop = new audio_t[fe->frameShift];
+  vad_words_init(reinterpret_cast<uint8_t *>(s_feature_rows),
+                 fe->numCoeffs * sizeof(float), unit_frames);
+  return 0;
+}
+
+int vad_task_set_features(FeatureExtractor *fe) {
+  if (s_frontend_mutex) {
+    xSemaphoreTake(s_frontend_mutex, portMAX_DELAY);
+  }
+  const int ret = vad_stft_reset(fe);
+  if (s_frontend_mutex) {
+    xSemaphoreGive(s_frontend_mutex);
+  }
+  return ret;
+}
+
+/*! \brief Slot of the next mic frame in the feature frame shift. */
+static audio_t *vad_stft_frame() {
+  return &s_hop[s_hop_frames * DET_FRAME_LEN];
+}
+
+/*!
+ * \brief Shared STFT frontend: mic frames are gathered to a feature frame
+ * shift, its spectrum gives voice activity and the word features.
+ */
+static void vad_stft_process(audio_t *proc_frame) {
+  const size_t max_abs = compute_max_abs(proc_frame, DET_FRAME_LEN);
+  s_hop_max_abs = std::max(s_hop_max_abs, max_abs);
+  if (++s_hop_frames * DET_FRAME_LEN < s_frontend_fe->frameShift) {
+    return;
+  }
+  float *row = reinterpret_cast<float *>(vad_words_unit());
+  const uint8_t is_speech = s_frontend->Process(s_hop, row);
+  vad_words_push(is_speech, s_hop_max_abs);
+  s_hop_frames = 0;
+  s_hop_max_abs = 0;
+}
+#endif
 
+/*! \brief Read the next mic frame and apply AGC. */
+static bool vad_read_frame(audio_t *proc_frame) {
+  if (mic_reader_read_frame(proc_frame, MIC_FRAME_LEN_MS) < 0) {
+    return false;
+  }
+  if (s_conditioning) {
+    esp_agc_process(s_agc_handle, proc_frame, proc_frame, AGC_FRAME_LEN,
+                    CONFIG_MIC_SAMPLE_RATE);
+  }
+  return true;
+}
+
+static void vad_task(void *pv) {
   for (;;) {
     const auto xBits =
       xEventGroupWaitBits(xVADEventGroup, VAD_RUNNING_MSK | VAD_STOP_MSK,
@@ -50,70 +242,36 @@ static void vad_task(void *pv) {
       continue;
     }
 
-    audio_t *proc_frame =
-      &current_frames[(cur_frame % DET_VOICED_FRAMES_WINDOW) * DET_FRAME_LEN];
-
-    if (mic_reader_read_frame(proc_frame, MIC_FRAME_LEN_MS) < 0) {
+#if CONFIG_KWS_SHARED_STFT
+    // the frontend is swapped between frames, see vad_task_set_features()
+    xSemaphoreTake(s_frontend_mutex, portMAX_DELAY);
+    const bool idle = !s_frontend;
+    if (!idle) {
+      audio_t *proc_frame = vad_stft_frame();
+      if (vad_read_frame(proc_frame)) {
+        vad_stft_process(proc_frame);
+      }
+    }
+    xSemaphoreGive(s_frontend_mutex);
+    if (idle) {
+      vTaskDelay(pdMS_TO_TICKS(MIC_FRAME_LEN_MS));
+    }
+#else
+    audio_t *proc_frame = reinterpret_cast<audio_t *>(vad_words_unit());
+    if (!vad_read_frame(proc_frame)) {
       continue;
     }
 
-    esp_agc_process(s_agc_handle, proc_frame, proc_frame, AGC_FRAME_LEN,
-                    CONFIG_MIC_SAMPLE_RATE);
-
-    ns_process(s_ns_handle, proc_frame, proc_frame);
+    if (s_conditioning) {
+      ns_process(s_ns_handle, proc_frame, proc_frame);
+    }
 
     const size_t max_abs = compute_max_abs(proc_frame, DET_FRAME_LEN);
 
-    max_abs_arr[cur_frame % DET_VOICED_FRAMES_WINDOW] = max_abs;
-
     const auto vad_res = vad_process(s_vad_handle, proc_frame,
                                      CONFIG_MIC_SAMPLE_RATE, AGC_FRAME_LEN_MS);
-    const uint8_t is_speech = vad_res == VAD_SPEECH;
-
-    num_voiced += is_speech;
-    is_speech_arr[cur_frame % DET_VOICED_FRAMES_WINDOW] = is_speech;
-
-    if (!trig) {
-      if (num_voiced >= DET_VOICED_FRAMES_THRESHOLD) {
-        word.frame_num = 0;
-        word.max_abs = 0;
-        trig = 1;
-        ESP_LOGD(TAG, "__start[%d]=%d, max_abs=%d",
-                 cur_frame - DET_VOICED_FRAMES_WINDOW, cur_frame, max_abs);
-        for (size_t k = 1; k <= DET_VOICED_FRAMES_WINDOW; k++) {
-          const size_t frame_num = (cur_frame + k) % DET_VOICED_FRAMES_WINDOW;
-          audio_t *frame_ptr = &current_frames[frame_num * DET_FRAME_LEN];
-          const auto xBytesSent =
-            xStreamBufferSend(xWordFramesBuffer, frame_ptr, DET_FRAME_SZ, 0);
-          if (xBytesSent < DET_FRAME_SZ) {
-            ESP_LOGW(TAG, "xWordFramesBuffer: xBytesSent=%d (%d)", xBytesSent,
-                     DET_FRAME_SZ);
-          }
-          word.frame_num++;
-          word.max_abs = std::max(word.max_abs, max_abs_arr[frame_num]);
-        }
-      }
-    } else {
-      if (num_voiced <= DET_UNVOICED_FRAMES_THRESHOLD) {
-        trig = 0;
-        ESP_LOGD(TAG, "__end[%d]=%d, max_abs=%d",
-                 cur_frame - DET_VOICED_FRAMES_WINDOW, cur_frame, max_abs);
-        xQueueSend(xWordQueue, &word, 0);
-      } else {
-        word.frame_num++;
-        word.max_abs = std::max(word.max_abs, max_abs);
-        const auto xBytesSent =
-          xStreamBufferSend(xWordFramesBuffer, proc_frame, DET_FRAME_SZ, 0);
-        if (xBytesSent < DET_FRAME_SZ) {
-          ESP_LOGW(TAG, "xWordFramesBuffer: xBytesSent=%d (%d)", xBytesSent,
-                   DET_FRAME_SZ);
-        }
-      }
-    }
-
-    num_voiced -= is_speech_arr[(cur_frame + 1) % DET_VOICED_FRAMES_WINDOW];
-
-    cur_frame++;
+    vad_words_push(vad_res == VAD_SPEECH, max_abs);
+#endif
   }
 
   ESP_LOGD(TAG, "stop vad_task");
@@ -143,6 +301,13 @@ int vad_task_init() {
   }
   set_agc_config(s_agc_handle, CONFIG_MIC_GAIN, 1, 0);
 
+#if CONFIG_KWS_SHARED_STFT
+  s_frontend_mutex = xSemaphoreCreateMutex();
+  if (!s_frontend_mutex) {
+    ESP_LOGE(TAG, "Error creating frontend mutex");
+    return -1;
+  }
+#else
   s_ns_handle = ns_pro_create(MIC_FRAME_LEN_MS, 2, CONFIG_KWS_SAMPLE_RATE);
   if (!s_ns_handle) {
     ESP_LOGE(TAG, "Unable to create esp_ns");
@@ -155,6 +320,10 @@ int vad_task_init() {
     return -1;
   }
 
+  vad_words_init(reinterpret_cast<uint8_t *>(current_frames), DET_FRAME_SZ,
+                 1);
+#endif
+
   xWordQueue = xQueueCreate(DET_MAX_WORDS, sizeof(WordDesc_t));
   if (xWordQueue == NULL) {
     ESP_LOGE(TAG, "Error creating word queue");
@@ -204,6 +373,13 @@ void vad_task_release() {
     vad_destroy(s_vad_handle);
     s_vad_handle = NULL;
   }
+#if CONFIG_KWS_SHARED_STFT
+  vad_task_set_features(NULL);
+  if (s_frontend_mutex) {
+    vSemaphoreDelete(s_frontend_mutex);
+    s_frontend_mutex = NULL;
+  }
+#endif
 
   if (xWordQueue) {
     vQueueDelete(xWordQueue);
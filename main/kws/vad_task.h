@@ -14,6 +14,12 @@
 #define VAD_STOPPED_MSK BIT1
 #define VAD_STOP_MSK    BIT2
 
+// KWS frames are counted in mic frames, see MIC_RESAMPLE for other rates of
+// capture
+#if CONFIG_KWS_SAMPLE_RATE != CONFIG_MIC_SAMPLE_RATE
+#error "KWS_SAMPLE_RATE must be MIC_SAMPLE_RATE"
+#endif
+
 #define DET_FRAME_LEN MIC_FRAME_LEN
 #define DET_FRAME_SZ  (DET_FRAME_LEN * MIC_ELEM_BYTES)
 
@@ -48,6 +54,24 @@ int vad_task_init();
  * \brief Release VAD task.
  */
 void vad_task_release();
+/*!
+ * \brief Enable AGC and noise suppression of the mic frames, enabled by
+ * default. Models of PCEN features are fed the frames as captured.
+ * \param enable Condition the frames.
+ */
+void vad_task_set_conditioning(bool enable);
+#if CONFIG_KWS_SHARED_STFT
+class FeatureExtractor;
+/*!
+ * \brief Set features of the shared STFT frontend, the word frames are then
+ * feature rows of the model not normalized (FeatureExtractor::Normalize()).
+ * Waits for the frame vad_task processes, the previous features are not
+ * used after the call.
+ * \param fe Features of the keyword model, NULL - none, VAD is idle.
+ * \return Result.
+ */
+int vad_task_set_features(FeatureExtractor *fe);
+#endif
 /*!
  * \brief Start VAD task.
  */
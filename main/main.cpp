@@ -1,8 +1,61 @@
 #include "App.hpp"
 #include "git_version.h"
 
+#if CONFIG_NN_MODEL_FFT_BENCHMARK
+#include "fft.h"
+#endif
+#if CONFIG_MIC_CONDITIONER_BENCHMARK
+#include "def.h"
+#include "mic_proc.h"
+#endif
+#if CONFIG_MIC_RESAMPLER_BENCHMARK
+#include "resampler.h"
+#endif
+#if CONFIG_KWS_FRONTEND_BENCHMARK
+#include "frontend_bench.h"
+// model headers of the scenarios share the include guard
+#if CONFIG_APP_VOICE_RELAY
+#include "model.h"
+#else
+#include "models.h"
+#endif
+#endif
+
 extern "C" void app_main(void) {
   printf("VERSION: %s\n", VERSION_STRING);
+#if CONFIG_NN_MODEL_FFT_BENCHMARK
+  // 512: 25-32 ms windows, 1024: 40 ms ones of the current models at 16 kHz
+  static const int fft_lens[] = {256, 512, 1024, 2048};
+  fft_benchmark(fft_lens, sizeof(fft_lens) / sizeof(fft_lens[0]), 200);
+#endif
+#if CONFIG_MIC_CONDITIONER_BENCHMARK
+  // at the capture rate, as mic_reader conditions before resampling
+  mic_conditioner_benchmark(MIC_CAPTURE_SAMPLE_RATE, CONFIG_MIC_GAIN_DB, 200);
+#endif
+#if CONFIG_MIC_RESAMPLER_BENCHMARK
+  // PDM capture rates to the KWS and SED ones
+  static const size_t resampler_rates[][2] = {
+    {32000, 16000}, {48000, 16000}, {48000, 22050}};
+  for (const auto &rates : resampler_rates) {
+    resampler_benchmark(rates[0], rates[1], 200);
+  }
+#endif
+#if CONFIG_KWS_FRONTEND_BENCHMARK
+  // features of the keyword model of the app, the partition one if it is
+  // there
+#if CONFIG_APP_VOICE_RELAY
+  const nn_model_desc_t *kws_desc =
+    nn_model_desc_get("voice_relay", &voice_relay_model);
+#else
+  const nn_model_desc_t *kws_desc =
+    nn_model_desc_get("numbers", &numbers_model);
+#endif
+  if (kws_desc) {
+    kws_frontend_benchmark(kws_desc, CONFIG_KWS_SAMPLE_RATE, 20);
+  } else {
+    printf("no keyword model to benchmark frontends\n");
+  }
+#endif
   App app;
   app.run();
 }
@@ -0,0 +1,101 @@
+#include "App.hpp"
+#include "Lcd.hpp"
+#include "Status.hpp"
+#include "git_version.h"
+#include "imu_task.h"
+#include "model.h"
+#include "motion_task.h"
+#include "utils.h"
+
+#include "model_op_resolver.h"
+
+#define TITLE      "Motion"
+#define HEADER_STR TITLE " " TOSTRING(MAJOR_VERSION) "." TOSTRING(MINOR_VERSION)
+
+/*! \brief Time to show detected gesture. */
+#define SHOW_RESULT_MS 1000
+
+static constexpr char TAG[] = TITLE;
+
+static nn_model_handle_t s_model_handle = NULL;
+
+namespace Motion {
+struct Main : State {
+  State *clone() override final { return new Main(*this); }
+  void handleEvent(App *app, Event_t ev) override final {
+    switch (ev.id) {
+    default:
+      update(app);
+      break;
+    }
+  }
+  void enterAction(App *app) override final { show(app, "-"); }
+  void exitAction(App *app) override final {
+    app->p_display->clear();
+    app->p_display->send();
+  }
+  void show(App *app, const char *label) {
+    unsigned w, h;
+    app->p_display->clear();
+    app->p_display->setFont(IDisplay::Font::CYR_6x12);
+    app->p_display->get_font_sz(w, h);
+    app->p_display->print_string(0, h, "%s", HEADER_STR);
+    app->p_display->setFont(IDisplay::Font::COURB18);
+    app->p_display->get_font_sz(w, h);
+    app->p_display->print_string(0, (DISPLAY_HEIGHT + h) / 2, "%s", label);
+    app->p_display->send();
+  }
+  void update(App *app) {
+    static char label[32];
+    int category;
+    if (xQueueReceive(xMotionResultQueue, &category, 0) == pdPASS) {
+      nn_model_get_label(s_model_handle, category, label, sizeof(label));
+      ESP_LOGI(TAG, "Detected: %s", label);
+      show(app, label);
+      shown_at_ = xTaskGetTickCount();
+    } else if (shown_at_ && xTaskGetTickCount() - shown_at_ >
+                              pdMS_TO_TICKS(SHOW_RESULT_MS)) {
+      shown_at_ = 0;
+      show(app, "-");
+    }
+  }
+
+private:
+  TickType_t shown_at_ = 0;
+};
+} // namespace Motion
+
+void releaseScenario(App *app) {
+  ESP_LOGI(TAG, "Exiting motion scenairo");
+  motion_task_release();
+  imu_task_release();
+  if (s_model_handle) {
+    nn_model_release(s_model_handle);
+    s_model_handle = NULL;
+  }
+}
+
+void initScenario(App *app) {
+  ESP_LOGI(TAG, "Entering motion scenairo");
+  int errors =
+    nn_model_init(&s_model_handle,
+                  nn_model_config_t{
+                    .model_desc = &motion_model,
+                    .inference_threshold = MOTION_INFERENCE_THRESHOLD,
+                    .op_resolver = model_op_resolver_get("motion"),
+                  }) < 0;
+  errors += imu_task_init(imu_task_conf_t{
+              .backend = &imu_mpu9250_backend,
+              .sample_rate = MOTION_SAMPLE_RATE,
+              .buf_duration_ms = MOTION_WIN_MS,
+            }) < 0;
+  errors += motion_task_init(motion_task_conf_t{
+              .model_handle = s_model_handle,
+            }) < 0;
+  if (errors) {
+    ESP_LOGE(TAG, "Motion init errors=%d", errors);
+    app->transition(nullptr);
+  } else {
+    app->transition(new Motion::Main);
+  }
+}
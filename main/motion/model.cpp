@@ -0,0 +1,25 @@
+#include "model.h"
+
+// CONFIG_MOTION_MODEL_PATH, embedded by main/CMakeLists.txt
+extern const unsigned char
+  motion_model_tflite_start[] asm("_binary_motion_model_tflite_start");
+extern const unsigned char
+  motion_model_tflite_end[] asm("_binary_motion_model_tflite_end");
+
+// the model takes MOTION_FEATURES_LEN int8 features and has an output per
+// label, nn_model_init() and motion_task_init() check it
+static const char *labels[] = {
+  "_idle_",
+  "_unknown_",
+  "wave",
+  "shake",
+  "circle",
+};
+const nn_model_desc_t motion_model = {
+  .model_ptr = motion_model_tflite_start,
+  .model_size =
+    unsigned(motion_model_tflite_end - motion_model_tflite_start),
+  .labels = labels,
+  .labels_num = _countof(labels),
+  .is_quantized = true,
+};
@@ -0,0 +1,9 @@
+#ifndef _MODELS_H_
+#define _MODELS_H_
+
+#include "nn_model.h"
+#include "utils.h"
+
+extern const nn_model_desc_t motion_model;
+
+#endif // _MODELS_H_
@@ -0,0 +1,150 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#include "imu_task.h"
+#include "motion_task.h"
+
+static const char *TAG = "motion_task";
+
+#define DEG_TO_RAD (float(M_PI) / 180.f)
+
+/*! \brief Consecutive equal detections to report a gesture. */
+#define MOTION_WINDOW 2
+/*! \brief Categories below are idle and unknown. */
+#define FIRST_EVENT_IDX 2
+
+QueueHandle_t xMotionResultQueue = NULL;
+
+static TaskHandle_t xTaskHandle = NULL;
+
+static float s_window[MOTION_WIN_LEN][MOTION_AXES_NUM];
+
+static void compute_features(float *features) {
+  for (size_t s = 0; s < MOTION_SEGMENT_NUM; s++) {
+    const float(*seg)[MOTION_AXES_NUM] = &s_window[s * MOTION_SEGMENT_LEN];
+    for (size_t a = 0; a < MOTION_AXES_NUM; a++) {
+      float sum = 0, sum_sq = 0;
+      float min_val = seg[0][a], max_val = seg[0][a];
+      for (size_t i = 0; i < MOTION_SEGMENT_LEN; i++) {
+        const float val = seg[i][a];
+        sum += val;
+        sum_sq += val * val;
+        min_val = std::min(min_val, val);
+        max_val = std::max(max_val, val);
+      }
+      const float mean = sum / MOTION_SEGMENT_LEN;
+      const float var = sum_sq / MOTION_SEGMENT_LEN - mean * mean;
+      features[0] = mean;
+      features[1] = sqrtf(std::max(var, 0.f));
+      features[2] = min_val;
+      features[3] = max_val;
+      features += MOTION_STATS_NUM;
+    }
+  }
+}
+
+static void motion_task(void *pv) {
+  nn_model_handle_t model_handle = static_cast<nn_model_handle_t>(pv);
+  static imu_sample_t samples[MOTION_WIN_SHIFT];
+  static float features[MOTION_FEATURES_LEN];
+
+  size_t filled = 0;
+  size_t num_det = 0;
+  int last_category = -1;
+  int trig_category = -1;
+  for (;;) {
+    for (size_t num = 0; num < MOTION_WIN_SHIFT;) {
+      num += imu_read_samples(&samples[num], MOTION_WIN_SHIFT - num,
+                              portMAX_DELAY);
+    }
+
+    memmove(s_window[0], s_window[MOTION_WIN_SHIFT],
+            (MOTION_WIN_LEN - MOTION_WIN_SHIFT) * sizeof(s_window[0]));
+    float(*tail)[MOTION_AXES_NUM] =
+      &s_window[MOTION_WIN_LEN - MOTION_WIN_SHIFT];
+    for (size_t i = 0; i < MOTION_WIN_SHIFT; i++) {
+      for (size_t k = 0; k < 3; k++) {
+        tail[i][k] = samples[i].accel[k] / IMU_ACCEL_LSB_PER_G;
+        tail[i][3 + k] =
+          samples[i].gyro[k] / IMU_GYRO_LSB_PER_DPS * DEG_TO_RAD;
+      }
+    }
+    filled = std::min(filled + MOTION_WIN_SHIFT, size_t(MOTION_WIN_LEN));
+    if (filled < MOTION_WIN_LEN) {
+      continue;
+    }
+
+    const int64_t t1 = esp_timer_get_time();
+    compute_features(features);
+    ESP_LOGV(TAG, "features: %lld us", esp_timer_get_time() - t1);
+
+    int category = -1;
+    if (nn_model_inference(model_handle, features, MOTION_FEATURES_LEN,
+                           &category) < 0) {
+      ESP_LOGE(TAG, "inference error");
+      continue;
+    }
+
+    if (category >= FIRST_EVENT_IDX) {
+      num_det = category == last_category ? num_det + 1 : 1;
+    } else {
+      num_det = 0;
+    }
+    last_category = category;
+
+    if (trig_category >= 0 && category != trig_category) {
+      trig_category = -1;
+    }
+    if (trig_category < 0 && num_det == MOTION_WINDOW) {
+      trig_category = category;
+      xQueueSend(xMotionResultQueue, &category, 0);
+    }
+  }
+}
+
+int motion_task_init(motion_task_conf_t conf) {
+  ESP_LOGD(TAG, "MOTION_WIN_LEN=%d, MOTION_FEATURES_LEN=%d", MOTION_WIN_LEN,
+           MOTION_FEATURES_LEN);
+
+  size_t input_len = 0;
+  if (nn_model_get_input_len(conf.model_handle, &input_len) < 0 ||
+      input_len != MOTION_FEATURES_LEN) {
+    ESP_LOGE(TAG, "model input is %u values, not %d features",
+             unsigned(input_len), MOTION_FEATURES_LEN);
+    return -1;
+  }
+
+  xMotionResultQueue = xQueueCreate(1, sizeof(int));
+  if (xMotionResultQueue == NULL) {
+    ESP_LOGE(TAG, "Error creating motion result queue");
+    return -1;
+  }
+
+  auto xReturned = xTaskCreate(motion_task, "motion_task",
+                               configMINIMAL_STACK_SIZE + 1024 * 4,
+                               conf.model_handle, 1, &xTaskHandle);
+  if (xReturned != pdPASS) {
+    ESP_LOGE(TAG, "Error creating motion_task");
+    return -1;
+  }
+  return 0;
+}
+
+void motion_task_release() {
+  if (xTaskHandle) {
+    vTaskDelete(xTaskHandle);
+    xTaskHandle = NULL;
+  }
+  if (xMotionResultQueue) {
+    vQueueDelete(xMotionResultQueue);
+    xMotionResultQueue = NULL;
+  }
+}
@@ -0,0 +1,55 @@
+#ifndef _MOTION_TASK_H_
+#define _MOTION_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "nn_model.h"
+
+#define MOTION_SAMPLE_RATE CONFIG_MOTION_SAMPLE_RATE
+/*! \brief Accel xyz, gyro xyz. */
+#define MOTION_AXES_NUM 6
+
+#define MOTION_WIN_MS    2000
+#define MOTION_STRIDE_MS 250
+#define MOTION_WIN_LEN   (MOTION_SAMPLE_RATE * MOTION_WIN_MS / 1000)
+#define MOTION_WIN_SHIFT (MOTION_SAMPLE_RATE * MOTION_STRIDE_MS / 1000)
+
+/*! \brief Window is split into segments, each described by mean, std, min,
+ * max of every axis: features[segment][axis][stat]. */
+#define MOTION_SEGMENT_NUM 8
+#define MOTION_SEGMENT_LEN (MOTION_WIN_LEN / MOTION_SEGMENT_NUM)
+#define MOTION_STATS_NUM   4
+
+#define MOTION_FEATURES_LEN                                                    \
+  (MOTION_SEGMENT_NUM * MOTION_AXES_NUM * MOTION_STATS_NUM)
+
+// the MPU-9250 sample rate divider of 1 kHz, whole samples per stride and
+// per segment, none are dropped
+static_assert(1000 % MOTION_SAMPLE_RATE == 0,
+              "MOTION_SAMPLE_RATE must divide 1000");
+static_assert(MOTION_SAMPLE_RATE * MOTION_STRIDE_MS % 1000 == 0,
+              "MOTION_SAMPLE_RATE must give whole samples per stride");
+static_assert(MOTION_SAMPLE_RATE * MOTION_WIN_MS % 1000 == 0 &&
+                MOTION_WIN_LEN % MOTION_SEGMENT_NUM == 0,
+              "MOTION_SAMPLE_RATE must give whole samples per segment");
+
+/*! \brief Global motion result queue. */
+extern QueueHandle_t xMotionResultQueue;
+
+struct motion_task_conf_t {
+  nn_model_handle_t model_handle;
+};
+
+/*!
+ * \brief Initialize motion task, IMU task must be running.
+ * \param conf Configuration params.
+ * \return Result.
+ */
+int motion_task_init(motion_task_conf_t conf);
+/*!
+ * \brief Release motion task.
+ */
+void motion_task_release();
+
+#endif // _MOTION_TASK_H_
@@ -2,6 +2,7 @@
 #include "Lcd.hpp"
 #include "Status.hpp"
 #include "git_version.h"
+#include "model_op_resolver.h"
 #include "models.h"
 #include "sed_task.h"
 #include "utils.h"
@@ -106,13 +107,18 @@ void releaseScenario(App *app) {
 
 void initScenario(App *app) {
   ESP_LOGI(TAG, "Entering SED (%s) scenairo", scenario_desc.name);
+  const nn_model_desc_t *model_desc =
+    nn_model_desc_get(scenario_desc.name, scenario_desc.model_desc);
   int errors = nn_model_init(&s_model_handle,
                              nn_model_config_t{
-                               .model_desc = scenario_desc.model_desc,
+                               .model_desc = model_desc,
                                .inference_threshold = SED_INFERENCE_THRESHOLD,
+                               .op_resolver =
+                                 model_op_resolver_get(scenario_desc.name),
                              }) < 0;
   errors += sed_task_init(sed_task_conf_t{
               .model_handle = s_model_handle,
+              .model_desc = model_desc,
               .mic_gain = scenario_desc.mic_gain,
             }) < 0;
   if (errors) {
@@ -4071,6 +4071,16 @@ const nn_model_desc_t glass_breaking_model = {
   .labels = labels,
   .labels_num = _countof(labels),
   .is_quantized = true,
-  .mel_low_freq = 20,
-  .mel_high_freq = 4000,
+  .mel_low_freq = 0,
+  .mel_high_freq = 8000,
+  .preproc =
+    {
+      .features = NN_MODEL_FEATURES_LOG_MEL,
+      .norm = NN_MODEL_NORM_FULL_SCALE,
+      .win_ms = 40,
+      .stride_ms = 20,
+      .duration_ms = 1000,
+      .num_fbank_bins = 40,
+      .num_mfcc = 0,
+    },
 };
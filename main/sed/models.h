@@ -2,11 +2,13 @@
 #define _MODELS_H_
 
 #include "nn_model.h"
+#include "nn_model_partition.h"
 #include "utils.h"
 
-extern const nn_model_desc_t baby_cry_model;
-extern const nn_model_desc_t glass_breaking_model;
-extern const nn_model_desc_t bark_model;
-extern const nn_model_desc_t coughing_model;
+/*! \brief Linked into the app unless APP_MODELS_PARTITION_ONLY, else NULL. */
+extern const nn_model_desc_t baby_cry_model __attribute__((weak));
+extern const nn_model_desc_t glass_breaking_model __attribute__((weak));
+extern const nn_model_desc_t bark_model __attribute__((weak));
+extern const nn_model_desc_t coughing_model __attribute__((weak));
 
 #endif // _MODELS_H_
@@ -10,22 +10,22 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 
-#include "audio_preprocessor.h"
+#include "feature_extractor.h"
 #include "mic_reader.h"
+#include "model_preproc_tables.h"
+#include "nn_model_server.h"
 #include "sed_task.h"
 
+#if CONFIG_IDF_TARGET_LINUX
+#include "sim.h"
+#endif
+
 static const char *TAG = "sed_task";
 
 #define SED_EVENT_START_MSK BIT0
 #define SED_EVENT_STOP_MSK  BIT1
 #define SED_STATUS_BUSY_MSK BIT2
 
-#define MFCC_DATA_FRAME_SZ  (SED_NUM_FBANK_BINS * sizeof(float))
-#define MFCC_DATA_BUFFER_SZ (MFCC_DATA_FRAME_SZ * SED_FRAME_NUM)
-
-#define SED_FRAME_SZ          (SED_FRAME_LEN * MIC_ELEM_BYTES)
-#define SED_FRAME_SHIFT_BYTES (SED_FRAME_SHIFT * MIC_ELEM_BYTES)
-
 #define AGC_FRAME_LEN_MS 10
 #define AGC_FRAME_LEN    (CONFIG_MIC_SAMPLE_RATE / 1000 * AGC_FRAME_LEN_MS)
 
@@ -40,69 +40,83 @@ static void *s_agc_handle = NULL;
 
 static TaskHandle_t xPPTaskHandle = NULL;
 static TaskHandle_t xSEDTaskHandle = NULL;
-static AudioPreprocessor *pp = NULL;
+
+struct sed_task_param_t {
+  nn_model_handle_t model_handle = NULL;
+  FeatureExtractor *fe = NULL;
+  audio_t *proc_frame = NULL;
+  float *pp_features = NULL;
+  float *features = NULL;
+} static s_sed_task_params;
 
 static void pp_task(void *pv) {
-  AudioPreprocessor *preprocessor = static_cast<AudioPreprocessor *>(pv);
-  static audio_t proc_frame[SED_FRAME_LEN] = {0};
-  static float fbuffer[SED_FRAME_LEN] = {0};
-  static float mfcc_buffer[SED_FEATURES_LEN] = {0};
+  sed_task_param_t *params = static_cast<sed_task_param_t *>(pv);
+  FeatureExtractor *fe = params->fe;
+  audio_t *proc_frame = params->proc_frame;
+  float *features = params->pp_features;
+  const size_t head_len = fe->frameLen - fe->frameShift;
+  const size_t frame_sz = fe->numCoeffs * sizeof(float);
+  const float norm = fe->Norm(0);
+  // PCEN normalizes the level itself
+  const bool agc = fe->preproc.features != NN_MODEL_FEATURES_PCEN;
 
   audio_t *proc_buf = &proc_frame[0];
-  audio_t *half_proc_buf = &proc_frame[SED_FRAME_SHIFT];
+  audio_t *shift_buf = &proc_frame[head_len];
 
-  for (size_t i = 0; i < SED_FRAME_SHIFT / AGC_FRAME_LEN; i++) {
+  for (size_t i = 0; i < head_len / AGC_FRAME_LEN; i++) {
     audio_t *ptr = &proc_buf[i * AGC_FRAME_LEN];
     if (mic_reader_read_frame(ptr, MIC_FRAME_LEN_MS * 2) < 0) {
       continue;
     }
-    esp_agc_process(s_agc_handle, ptr, ptr, AGC_FRAME_LEN,
-                    CONFIG_MIC_SAMPLE_RATE);
+    if (agc) {
+      esp_agc_process(s_agc_handle, ptr, ptr, AGC_FRAME_LEN,
+                      CONFIG_MIC_SAMPLE_RATE);
+    }
   }
 
   size_t frame_counter = 0;
   for (;;) {
-    for (size_t i = 0; i < SED_FRAME_SHIFT / AGC_FRAME_LEN; i++) {
-      audio_t *ptr = &half_proc_buf[i * AGC_FRAME_LEN];
+    for (size_t i = 0; i < fe->frameShift / AGC_FRAME_LEN; i++) {
+      audio_t *ptr = &shift_buf[i * AGC_FRAME_LEN];
       if (mic_reader_read_frame(ptr, MIC_FRAME_LEN_MS * 2) < 0) {
         continue;
       }
-      esp_agc_process(s_agc_handle, ptr, ptr, AGC_FRAME_LEN,
-                      CONFIG_MIC_SAMPLE_RATE);
+      if (agc) {
+        esp_agc_process(s_agc_handle, ptr, ptr, AGC_FRAME_LEN,
+                        CONFIG_MIC_SAMPLE_RATE);
+      }
     }
 
     const int64_t t1 = esp_timer_get_time();
 
-    const size_t current_frame = frame_counter % SED_FRAME_NUM;
+    const size_t current_frame = frame_counter % fe->frameNum;
 
-    for (size_t i = 0; i < SED_FRAME_LEN; i++) {
-      fbuffer[i] = float(proc_frame[i]) / (1 << 15);
-    }
+    fe->Compute(proc_frame, norm, &features[current_frame * fe->numCoeffs]);
 
-    preprocessor->LogMelCompute(
-      fbuffer, &mfcc_buffer[current_frame * SED_NUM_FBANK_BINS]);
-
-    memmove(proc_frame, half_proc_buf, SED_FRAME_SHIFT_BYTES);
-    memset(half_proc_buf, 0, SED_FRAME_SHIFT_BYTES);
+    memmove(proc_frame, &proc_frame[fe->frameShift],
+            head_len * MIC_ELEM_BYTES);
+    memset(shift_buf, 0, fe->frameShift * MIC_ELEM_BYTES);
 
     ESP_LOGV(TAG, "pp_frame: %d(%d), %lld us", current_frame, frame_counter,
              esp_timer_get_time() - t1);
 
-    if ((frame_counter + 1) >= SED_FRAME_NUM) {
+    if ((frame_counter + 1) >= fe->frameNum) {
       if (!(xEventGroupGetBits(xSEDEventGroup) & SED_STATUS_BUSY_MSK)) {
-        for (size_t k = 1; k <= SED_FRAME_NUM; k++) {
-          const size_t frame_num = (frame_counter + k) % SED_FRAME_NUM;
-          void *frame_ptr =
-            (void *)&mfcc_buffer[frame_num * SED_NUM_FBANK_BINS];
-
-          const auto xBytesSent = xStreamBufferSend(xSEDFramesBuffer, frame_ptr,
-                                                    MFCC_DATA_FRAME_SZ, 0);
-          if (xBytesSent < MFCC_DATA_FRAME_SZ) {
+        for (size_t k = 1; k <= fe->frameNum; k++) {
+          const size_t frame_num = (frame_counter + k) % fe->frameNum;
+          void *frame_ptr = (void *)&features[frame_num * fe->numCoeffs];
+
+          const auto xBytesSent =
+            xStreamBufferSend(xSEDFramesBuffer, frame_ptr, frame_sz, 0);
+          if (xBytesSent < frame_sz) {
             ESP_LOGW(TAG, "xSEDFramesBuffer: xBytesSent=%d (%d)", xBytesSent,
-                     MFCC_DATA_FRAME_SZ);
+                     frame_sz);
+#if CONFIG_IDF_TARGET_LINUX
+            sim_trace("sed_buf_overrun", xBytesSent);
+#endif
           }
         }
-        ESP_LOGV(TAG, "sent frames: [%d; %d]", frame_counter - SED_FRAME_NUM,
+        ESP_LOGV(TAG, "sent frames: [%d; %d]", frame_counter - fe->frameNum,
                  frame_counter);
       }
       ESP_LOGV(TAG, "skipped frame: %d", frame_counter);
@@ -113,22 +127,29 @@ static void pp_task(void *pv) {
 }
 
 void sed_task(void *pv) {
-  nn_model_handle_t model_handle = static_cast<nn_model_handle_t>(pv);
-  float mfcc_buffer[SED_FEATURES_LEN] = {0};
+  sed_task_param_t *params = static_cast<sed_task_param_t *>(pv);
+  nn_model_handle_t model_handle = params->model_handle;
+  float *features = params->features;
+  const size_t features_len = params->fe->featuresLen;
 
   int cats_buffer[SED_WINDOW] = {-1};
   size_t num_det = 0;
   uint8_t trig = 0;
   for (size_t counter = 0;; counter++) {
-    const auto xReceivedBytes = xStreamBufferReceive(
-      xSEDFramesBuffer, mfcc_buffer, MFCC_DATA_BUFFER_SZ, portMAX_DELAY);
+    const auto xReceivedBytes =
+      xStreamBufferReceive(xSEDFramesBuffer, features,
+                           features_len * sizeof(float), portMAX_DELAY);
     ESP_LOGV(TAG, "recv bytes=%d", xReceivedBytes);
 
     xEventGroupSetBits(xSEDEventGroup, SED_STATUS_BUSY_MSK);
     int category = -1;
-    if (nn_model_inference(model_handle, mfcc_buffer, SED_FEATURES_LEN,
-                           &category) < 0) {
+    if (nn_model_server_inference(model_handle, features, features_len,
+                                  NN_MODEL_PRIORITY_LOW, &category) < 0) {
       ESP_LOGE(TAG, "inference error");
+      // no event in the failed window, pp_task waits for the busy bit
+      cats_buffer[counter % SED_WINDOW] = -1;
+      num_det -= cats_buffer[(counter + 1) % SED_WINDOW] == REQ_CAT_IDX;
+      xEventGroupClearBits(xSEDEventGroup, SED_STATUS_BUSY_MSK);
       continue;
     }
     num_det += category == REQ_CAT_IDX;
@@ -138,6 +159,9 @@ void sed_task(void *pv) {
       if (num_det == SED_WINDOW) {
         trig = 1;
         xQueueSend(xSEDResultQueue, &category, 0);
+#if CONFIG_IDF_TARGET_LINUX
+        sim_trace("sed", category);
+#endif
       }
     } else {
       if (num_det == 0) {
@@ -151,9 +175,35 @@ void sed_task(void *pv) {
 }
 
 int sed_task_init(sed_task_conf_t conf) {
-  ESP_LOGD(TAG,
-           "MFCC_DATA_FRAME_SZ=%d, MFCC_DATA_BUFFER_SZ=%d, SED_FEATURES_LEN=%d",
-           MFCC_DATA_FRAME_SZ, MFCC_DATA_BUFFER_SZ, SED_FEATURES_LEN);
+  if (FeatureExtractor::Validate(conf.model_desc, CONFIG_MIC_SAMPLE_RATE) <
+      0) {
+    return -1;
+  }
+  FeatureExtractor *fe =
+    new FeatureExtractor(conf.model_desc, CONFIG_MIC_SAMPLE_RATE,
+                         model_preproc_tables_get(conf.model_desc,
+                                                  CONFIG_MIC_SAMPLE_RATE));
+  s_sed_task_params.fe = fe;
+  ESP_LOGD(TAG, "frame_len=%d, frame_shift=%d, features_len=%d", fe->frameLen,
+           fe->frameShift, fe->featuresLen);
+  if (fe->preproc.norm != NN_MODEL_NORM_FULL_SCALE &&
+      fe->preproc.features != NN_MODEL_FEATURES_PCEN) {
+    ESP_LOGE(TAG, "stream features need full scale normalization");
+    return -1;
+  }
+  if (fe->frameShift % AGC_FRAME_LEN || fe->frameLen % AGC_FRAME_LEN) {
+    ESP_LOGE(TAG, "frames are not aligned to AGC frames");
+    return -1;
+  }
+  if (nn_model_server_init() < 0 ||
+      nn_model_server_attach(conf.model_handle) < 0) {
+    return -1;
+  }
+  const size_t features_sz = fe->featuresLen * sizeof(float);
+  s_sed_task_params.model_handle = conf.model_handle;
+  s_sed_task_params.proc_frame = new audio_t[fe->frameLen]();
+  s_sed_task_params.pp_features = new float[fe->featuresLen]();
+  s_sed_task_params.features = new float[fe->featuresLen]();
 
   s_agc_handle = esp_agc_open(3, CONFIG_MIC_SAMPLE_RATE);
   if (!s_agc_handle) {
@@ -162,8 +212,7 @@ int sed_task_init(sed_task_conf_t conf) {
   }
   set_agc_config(s_agc_handle, conf.mic_gain, 1, 0);
 
-  xSEDFramesBuffer =
-    xStreamBufferCreate(MFCC_DATA_BUFFER_SZ, MFCC_DATA_BUFFER_SZ);
+  xSEDFramesBuffer = xStreamBufferCreate(features_sz, features_sz);
   if (xSEDFramesBuffer == NULL) {
     ESP_LOGE(TAG, "Error creating sed frames buffer");
     return -1;
@@ -180,19 +229,16 @@ int sed_task_init(sed_task_conf_t conf) {
     return -1;
   }
 
-  pp = new AudioPreprocessor(CONFIG_MIC_SAMPLE_RATE, 10, SED_FRAME_LEN,
-                             SED_NUM_FBANK_BINS, SED_MEL_LOW_FREQ,
-                             SED_MEL_HIGH_FREQ);
   auto xReturned =
-    xTaskCreate(pp_task, "pp_task", configMINIMAL_STACK_SIZE + 1024 * 10, pp, 1,
-                &xPPTaskHandle);
+    xTaskCreate(pp_task, "pp_task", configMINIMAL_STACK_SIZE + 1024 * 10,
+                &s_sed_task_params, 1, &xPPTaskHandle);
   if (xReturned != pdPASS) {
     ESP_LOGE(TAG, "Error creating pp_task");
     return -1;
   }
   xReturned =
     xTaskCreate(sed_task, "sed_task", configMINIMAL_STACK_SIZE + 1024 * 10,
-                conf.model_handle, 1, &xSEDTaskHandle);
+                &s_sed_task_params, 1, &xSEDTaskHandle);
   if (xReturned != pdPASS) {
     ESP_LOGE(TAG, "Error creating sed_task");
     return -1;
@@ -201,6 +247,7 @@ int sed_task_init(sed_task_conf_t conf) {
 }
 
 void sed_task_release() {
+  nn_model_server_detach(s_sed_task_params.model_handle);
   if (s_agc_handle) {
     esp_agc_close(s_agc_handle);
     s_agc_handle = NULL;
@@ -225,7 +272,16 @@ void sed_task_release() {
     vTaskDelete(xSEDTaskHandle);
     xSEDTaskHandle = NULL;
   }
-  if (pp) {
-    delete pp;
+  if (s_sed_task_params.fe) {
+    delete s_sed_task_params.fe;
+    s_sed_task_params.fe = NULL;
   }
+  delete[] s_sed_task_params.proc_frame;
+  s_sed_task_params.proc_frame = NULL;
+  delete[] s_sed_task_params.pp_features;
+  s_sed_task_params.pp_features = NULL;
+  delete[] s_sed_task_params.features;
+  s_sed_task_params.features = NULL;
+  s_sed_task_params.model_handle = NULL;
+  nn_model_server_release();
 }
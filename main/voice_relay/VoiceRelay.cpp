@@ -4,6 +4,7 @@
 #include "kws_event_task.h"
 #include "kws_task.h"
 #include "model.h"
+#include "model_op_resolver.h"
 #include "utils.h"
 #include "vad_task.h"
 
@@ -181,15 +182,20 @@ void releaseScenario(App *app) {
 }
 
 void initScenario(App *app) {
+  const nn_model_desc_t *model_desc =
+    nn_model_desc_get("voice_relay", &voice_relay_model);
   int errors = vad_task_init() < 0;
   errors += nn_model_init(&s_model_handle, nn_model_config_t{
-                                             .model_desc = &voice_relay_model,
+                                             .model_desc = model_desc,
                                              .inference_threshold =
                                                VOICE_RELAY_INFERENCE_THRESHOLD,
+                                             .op_resolver =
+                                               model_op_resolver_get(
+                                                 "voice_relay"),
                                            }) < 0;
   errors += kws_task_init(kws_task_conf_t{
               .model_handle = s_model_handle,
-              .model_desc = &voice_relay_model,
+              .model_desc = model_desc,
             }) < 0;
   errors += kws_event_task_init(&kws_event_cb);
 
@@ -2,8 +2,10 @@
 #define _MODELS_H_
 
 #include "nn_model.h"
+#include "nn_model_partition.h"
 #include "utils.h"
 
-extern const nn_model_desc_t voice_relay_model;
+/*! \brief Linked into the app unless APP_MODELS_PARTITION_ONLY, else NULL. */
+extern const nn_model_desc_t voice_relay_model __attribute__((weak));
 
 #endif // _MODELS_H_
@@ -0,0 +1,5 @@
+#include "bootloader_random.h"
+
+void bootloader_random_enable(void) {}
+
+void bootloader_random_disable(void) {}
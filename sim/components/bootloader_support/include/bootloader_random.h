@@ -0,0 +1,18 @@
+#ifndef _SIM_BOOTLOADER_RANDOM_H_
+#define _SIM_BOOTLOADER_RANDOM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Entropy source is always enabled on host.
+ */
+void bootloader_random_enable(void);
+void bootloader_random_disable(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _SIM_BOOTLOADER_RANDOM_H_
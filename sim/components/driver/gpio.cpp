@@ -0,0 +1,81 @@
+#include "driver/gpio.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const char *TAG = "sim_gpio";
+
+struct script_item_t {
+  int64_t time_ms;
+  int gpio_num;
+  int level;
+};
+
+static std::once_flag s_script_flag;
+static std::vector<script_item_t> s_script;
+static int s_out_levels[GPIO_NUM_MAX] = {0};
+
+static void load_script() {
+  const char *path = getenv("SIM_BUTTONS");
+  if (!path) {
+    return;
+  }
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    ESP_LOGE(TAG, "Unable to open %s", path);
+    return;
+  }
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    script_item_t item;
+    if (line[0] == '#' || sscanf(line, "%lld %d %d", &item.time_ms,
+                                 &item.gpio_num, &item.level) != 3) {
+      continue;
+    }
+    s_script.push_back(item);
+  }
+  fclose(file);
+  ESP_LOGI(TAG, "%s: %d items", path, s_script.size());
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num) { return ESP_OK; }
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode) {
+  return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+  if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (s_out_levels[gpio_num] != int(level)) {
+    s_out_levels[gpio_num] = level;
+    ESP_LOGI(TAG, "gpio %d: %d", gpio_num, level);
+  }
+  return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+  std::call_once(s_script_flag, load_script);
+  const int64_t now_ms = esp_timer_get_time() / 1000;
+  int level = 1;
+  for (const auto &item : s_script) {
+    if (item.time_ms > now_ms) {
+      break;
+    }
+    if (item.gpio_num == gpio_num) {
+      level = item.level;
+    }
+  }
+  return level;
+}
+
+esp_err_t gpio_pullup_en(gpio_num_t gpio_num) { return ESP_OK; }
+esp_err_t gpio_pullup_dis(gpio_num_t gpio_num) { return ESP_OK; }
+esp_err_t gpio_pulldown_en(gpio_num_t gpio_num) { return ESP_OK; }
+esp_err_t gpio_pulldown_dis(gpio_num_t gpio_num) { return ESP_OK; }
@@ -0,0 +1,84 @@
+#include "esp_agc.h"
+#include "esp_ns.h"
+#include "esp_vad.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+struct agc_t {
+  float gain;
+  int limit;
+};
+
+void *esp_agc_open(int agc_mode, int sample_rate) {
+  return new agc_t{1.f, 32767};
+}
+
+void set_agc_config(void *agc_handle, int gain_dB, int limiter_enable,
+                    int target_level_dbfs) {
+  agc_t *agc = static_cast<agc_t *>(agc_handle);
+  agc->gain = powf(10.f, gain_dB / 20.f);
+  agc->limit = limiter_enable
+                 ? int(32767 * powf(10.f, -target_level_dbfs / 20.f))
+                 : 32767;
+}
+
+int esp_agc_process(void *agc_handle, short *in_pcm, short *out_pcm,
+                    int frame_size, int sample_rate) {
+  const agc_t *agc = static_cast<agc_t *>(agc_handle);
+  for (int i = 0; i < frame_size; i++) {
+    const int val = lrintf(in_pcm[i] * agc->gain);
+    out_pcm[i] = std::clamp(val, -agc->limit, agc->limit);
+  }
+  return 0;
+}
+
+void esp_agc_close(void *agc_handle) {
+  delete static_cast<agc_t *>(agc_handle);
+}
+
+struct ns_t {
+  int frame_len;
+};
+
+ns_handle_t ns_create(int frame_length) { return new ns_t{frame_length}; }
+
+ns_handle_t ns_pro_create(int frame_length, int mode, int sample_rate) {
+  return new ns_t{sample_rate / 1000 * frame_length};
+}
+
+void ns_process(ns_handle_t inst, short *indata, short *outdata) {
+  const ns_t *ns = static_cast<ns_t *>(inst);
+  if (indata != outdata) {
+    memmove(outdata, indata, ns->frame_len * sizeof(short));
+  }
+}
+
+void ns_destroy(ns_handle_t inst) { delete static_cast<ns_t *>(inst); }
+
+struct vad_t {
+  float margin_db;
+  float noise_db;
+};
+
+vad_handle_t vad_create(vad_mode_t vad_mode) {
+  return new vad_t{6.f + 2.f * vad_mode, 30.f};
+}
+
+vad_state_t vad_process(vad_handle_t inst, int16_t *data, int sample_rate_hz,
+                        int one_frame_ms) {
+  vad_t *vad = static_cast<vad_t *>(inst);
+  const int len = sample_rate_hz / 1000 * one_frame_ms;
+  float energy = 0;
+  for (int i = 0; i < len; i++) {
+    energy += float(data[i]) * data[i];
+  }
+  const float db = 10.f * log10f(energy / len + 1.f);
+  // fast down, slow up
+  const float alpha = db < vad->noise_db ? 0.5f : 0.002f;
+  vad->noise_db += alpha * (db - vad->noise_db);
+  return db > vad->noise_db + vad->margin_db ? VAD_SPEECH : VAD_SILENCE;
+}
+
+void vad_destroy(vad_handle_t inst) { delete static_cast<vad_t *>(inst); }
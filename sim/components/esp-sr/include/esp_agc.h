@@ -0,0 +1,22 @@
+#ifndef _SIM_ESP_AGC_H_
+#define _SIM_ESP_AGC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Subset of esp-sr AGC API: fixed gain with limiter, no adaptation.
+ */
+void *esp_agc_open(int agc_mode, int sample_rate);
+void set_agc_config(void *agc_handle, int gain_dB, int limiter_enable,
+                    int target_level_dbfs);
+int esp_agc_process(void *agc_handle, short *in_pcm, short *out_pcm,
+                    int frame_size, int sample_rate);
+void esp_agc_close(void *agc_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _SIM_ESP_AGC_H_
@@ -0,0 +1,22 @@
+#ifndef _SIM_ESP_NS_H_
+#define _SIM_ESP_NS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *ns_handle_t;
+
+/*
+ * Subset of esp-sr NS API: pass-through.
+ */
+ns_handle_t ns_create(int frame_length);
+ns_handle_t ns_pro_create(int frame_length, int mode, int sample_rate);
+void ns_process(ns_handle_t inst, short *indata, short *outdata);
+void ns_destroy(ns_handle_t inst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _SIM_ESP_NS_H_
@@ -0,0 +1,38 @@
+#ifndef _SIM_ESP_VAD_H_
+#define _SIM_ESP_VAD_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  VAD_SILENCE = 0,
+  VAD_SPEECH = 1,
+} vad_state_t;
+
+typedef enum {
+  VAD_MODE_0 = 0,
+  VAD_MODE_1,
+  VAD_MODE_2,
+  VAD_MODE_3,
+  VAD_MODE_4,
+} vad_mode_t;
+
+typedef void *vad_handle_t;
+
+/*
+ * Subset of esp-sr VAD API: energy over tracked noise floor, higher mode
+ * requires higher margin.
+ */
+vad_handle_t vad_create(vad_mode_t vad_mode);
+vad_state_t vad_process(vad_handle_t inst, int16_t *data, int sample_rate_hz,
+                        int one_frame_ms);
+void vad_destroy(vad_handle_t inst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _SIM_ESP_VAD_H_
@@ -0,0 +1,22 @@
+#include "esp_timer.h"
+#include "esp_timer_sim.h"
+
+#include <atomic>
+#include <time.h>
+
+static int64_t monotonic_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return int64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+static const int64_t s_start_us = monotonic_us();
+static std::atomic<int64_t> s_advance_us(0);
+
+int64_t esp_timer_get_time(void) {
+  return esp_timer_sim_real_time() + s_advance_us.load();
+}
+
+void esp_timer_sim_advance(int64_t us) { s_advance_us += us; }
+
+int64_t esp_timer_sim_real_time(void) { return monotonic_us() - s_start_us; }
@@ -0,0 +1,20 @@
+#ifndef _SIM_ESP_TIMER_H_
+#define _SIM_ESP_TIMER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief Get time since start.
+ * \return Time in microseconds.
+ */
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _SIM_ESP_TIMER_H_
@@ -0,0 +1,25 @@
+#ifndef _ESP_TIMER_SIM_H_
+#define _ESP_TIMER_SIM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief Move clock forward, used by sim virtual time.
+ * \param us Time in microseconds.
+ */
+void esp_timer_sim_advance(int64_t us);
+/*!
+ * \brief Get real time since start, without advances.
+ * \return Time in microseconds.
+ */
+int64_t esp_timer_sim_real_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ESP_TIMER_SIM_H_
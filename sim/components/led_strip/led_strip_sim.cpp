@@ -0,0 +1,52 @@
+#include "led_strip.h"
+
+#include "esp_log.h"
+
+#include <string.h>
+#include <vector>
+
+static const char *TAG = "sim_led";
+
+struct led_strip_t {
+  std::vector<uint32_t> pixels;
+  std::vector<uint32_t> shown;
+};
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config,
+                                   const led_strip_rmt_config_t *rmt_config,
+                                   led_strip_handle_t *ret_strip) {
+  *ret_strip = new led_strip_t{
+    std::vector<uint32_t>(led_config->max_leds),
+    std::vector<uint32_t>(led_config->max_leds),
+  };
+  return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index,
+                              uint32_t red, uint32_t green, uint32_t blue) {
+  if (index >= strip->pixels.size()) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  strip->pixels[index] = (red << 16) | (green << 8) | blue;
+  return ESP_OK;
+}
+
+esp_err_t led_strip_refresh(led_strip_handle_t strip) {
+  if (strip->pixels != strip->shown) {
+    strip->shown = strip->pixels;
+    for (size_t i = 0; i < strip->shown.size(); i++) {
+      ESP_LOGD(TAG, "led %d: #%06x", i, strip->shown[i]);
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t led_strip_clear(led_strip_handle_t strip) {
+  std::fill(strip->pixels.begin(), strip->pixels.end(), 0);
+  return led_strip_refresh(strip);
+}
+
+esp_err_t led_strip_del(led_strip_handle_t strip) {
+  delete strip;
+  return ESP_OK;
+}
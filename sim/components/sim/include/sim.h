@@ -0,0 +1,65 @@
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Host simulation, configured by environment:
+ *  SIM_MIC_WAV - microphone input, 16 bit PCM WAV, mono or mic channels,
+ *  SIM_TX_WAV  - speaker output, default "sim_tx.wav",
+ *  SIM_BUTTONS - button script, see driver/gpio.h,
+ *  SIM_TRACE   - trace output, default stdout.
+ * Trace lines: "TRACE <time_us> <mic_time_us> <event> <value>", mic time is
+ * position in SIM_MIC_WAV, latency of detection is time_us - mic_time_us
+ * relative to the first trace line.
+ */
+
+/*!
+ * \brief Open microphone input, opened once for all rx slot re-inits.
+ * \param sample_rate Sample rate.
+ * \param channels Channels per frame.
+ * \return Result.
+ */
+int sim_mic_open(size_t sample_rate, size_t channels);
+/*!
+ * \brief Read mic frames at real-time rate, exits at end of input.
+ * \param buffer Pointer to buffer.
+ * \param bytes Buffer size.
+ * \return Result.
+ */
+int sim_mic_read(void *buffer, size_t bytes);
+/*!
+ * \brief Get position of the last read sample.
+ * \return Time in microseconds.
+ */
+int64_t sim_mic_time_us();
+/*!
+ * \brief Open speaker output.
+ * \param sample_rate Sample rate.
+ * \return Result.
+ */
+int sim_tx_open(size_t sample_rate);
+/*!
+ * \brief Write samples to speaker output at real-time rate.
+ * \param data Data pointer.
+ * \param bytes Data size.
+ */
+void sim_tx_write(const void *data, size_t bytes);
+/*!
+ * \brief Finalize speaker output.
+ */
+void sim_tx_close();
+/*!
+ * \brief Add trace line.
+ * \param event Event name.
+ * \param value Event value.
+ */
+void sim_trace(const char *event, int value);
+/*!
+ * \brief Print summary and exit.
+ * \param code Exit code.
+ */
+void sim_exit(int code);
+
+#endif // _SIM_H_
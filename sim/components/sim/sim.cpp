@@ -0,0 +1,294 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_timer_sim.h"
+
+#include <algorithm>
+#include <malloc.h>
+#include <map>
+#include <mutex>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "sim.h"
+#include "wav.h"
+
+static const char *TAG = "sim";
+
+/*! \brief Reader may lag this many reads before samples are dropped, as
+ * with I2S_RX_DMA_BUF_NUM. */
+#define MIC_MAX_LAG_READS 2
+
+#define HEAP_SAMPLE_PERIOD_US 100000
+
+static std::mutex s_mutex;
+
+static FILE *s_mic_file = NULL;
+static wav_info_t s_mic_info;
+static size_t s_mic_channels = 1;
+static int64_t s_mic_start_us = 0;
+static uint64_t s_mic_samples = 0;
+static size_t s_mic_overruns = 0;
+static std::vector<int16_t> s_mic_buf;
+
+static FILE *s_tx_file = NULL;
+static wav_info_t s_tx_info;
+static int64_t s_tx_start_us = 0;
+static uint64_t s_tx_samples = 0;
+
+static FILE *s_trace_file = NULL;
+static std::map<std::string, size_t> s_trace_counts;
+
+static const bool s_virtual_time =
+  getenv("SIM_VIRTUAL_TIME") && atoi(getenv("SIM_VIRTUAL_TIME"));
+
+struct latency_stats_t {
+  int64_t min_us = INT64_MAX;
+  int64_t max_us = 0;
+  int64_t sum_us = 0;
+  size_t num = 0;
+};
+/*! \brief Time from VAD word end to kws result. */
+static latency_stats_t s_kws_latency;
+static int64_t s_word_end_us = -1;
+
+static size_t s_heap_peak = 0;
+static int64_t s_heap_sampled_us = -HEAP_SAMPLE_PERIOD_US;
+
+static void sample_heap() {
+  const int64_t now = esp_timer_get_time();
+  if (now - s_heap_sampled_us < HEAP_SAMPLE_PERIOD_US) {
+    return;
+  }
+  s_heap_sampled_us = now;
+  const struct mallinfo2 info = mallinfo2();
+  s_heap_peak = std::max(s_heap_peak, info.uordblks);
+}
+
+#if CONFIG_FREERTOS_USE_IDLE_HOOK
+extern "C" void vApplicationIdleHook(void) {
+  if (s_virtual_time) {
+    // all tasks are blocked, nothing happens till the next tick
+    esp_timer_sim_advance(portTICK_PERIOD_MS * 1000);
+    xTaskCatchUpTicks(1);
+  }
+  sample_heap();
+}
+#endif
+
+static void wait_until(int64_t time_us) {
+  for (;;) {
+    const int64_t wait_us = time_us - esp_timer_get_time();
+    if (wait_us <= 0) {
+      break;
+    }
+    vTaskDelay(std::max(pdMS_TO_TICKS(wait_us / 1000), TickType_t(1)));
+  }
+}
+
+int sim_mic_open(size_t sample_rate, size_t channels) {
+  if (s_mic_file) {
+    return 0;
+  }
+  const char *path = getenv("SIM_MIC_WAV");
+  if (!path) {
+    ESP_LOGE(TAG, "SIM_MIC_WAV is not set");
+    return -1;
+  }
+  s_mic_file = fopen(path, "rb");
+  if (!s_mic_file || wav_read_header(s_mic_file, &s_mic_info) < 0) {
+    ESP_LOGE(TAG, "Unable to open %s, 16 bit PCM WAV is expected", path);
+    return -1;
+  }
+  if (s_mic_info.sample_rate != sample_rate ||
+      (s_mic_info.channels != 1 && s_mic_info.channels != channels)) {
+    ESP_LOGE(TAG, "%s: %dHz/%dch, expected %dHz/%dch", path,
+             s_mic_info.sample_rate, s_mic_info.channels, sample_rate,
+             channels);
+    return -1;
+  }
+  s_mic_channels = channels;
+  s_mic_start_us = esp_timer_get_time();
+#if !CONFIG_FREERTOS_USE_IDLE_HOOK
+  if (s_virtual_time) {
+    ESP_LOGE(TAG, "SIM_VIRTUAL_TIME requires CONFIG_FREERTOS_USE_IDLE_HOOK");
+  }
+#endif
+  ESP_LOGI(TAG, "mic: %s, %.1f s", path,
+           float(s_mic_info.data_bytes) /
+             (2 * s_mic_info.channels * s_mic_info.sample_rate));
+  return 0;
+}
+
+int sim_mic_read(void *buffer, size_t bytes) {
+  if (!s_mic_file) {
+    return -1;
+  }
+  const size_t samples = bytes / (sizeof(int16_t) * s_mic_channels);
+  const int64_t read_us = samples * 1000000 / s_mic_info.sample_rate;
+
+  // samples are dropped if reader is late, as DMA buffers are overwritten
+  const int64_t lag_us = esp_timer_get_time() - s_mic_start_us -
+                         s_mic_samples * 1000000 / s_mic_info.sample_rate;
+  if (lag_us > (MIC_MAX_LAG_READS + 1) * read_us) {
+    const uint64_t skip = (lag_us - read_us) * s_mic_info.sample_rate / 1000000;
+    fseek(s_mic_file, skip * sizeof(int16_t) * s_mic_info.channels, SEEK_CUR);
+    s_mic_samples += skip;
+    s_mic_overruns++;
+    sim_trace("mic_overrun", skip);
+  }
+
+  s_mic_buf.resize(samples * s_mic_info.channels);
+  const size_t read =
+    fread(s_mic_buf.data(), sizeof(int16_t) * s_mic_info.channels, samples,
+          s_mic_file);
+  if (read < samples) {
+    ESP_LOGI(TAG, "end of mic input");
+    sim_exit(0);
+  }
+  int16_t *dst = static_cast<int16_t *>(buffer);
+  if (s_mic_info.channels == s_mic_channels) {
+    memcpy(dst, s_mic_buf.data(), bytes);
+  } else {
+    for (size_t i = 0; i < samples; i++) {
+      for (size_t ch = 0; ch < s_mic_channels; ch++) {
+        dst[i * s_mic_channels + ch] = s_mic_buf[i];
+      }
+    }
+  }
+  s_mic_samples += samples;
+  sample_heap();
+
+  wait_until(s_mic_start_us +
+             s_mic_samples * 1000000 / s_mic_info.sample_rate);
+  return 0;
+}
+
+int64_t sim_mic_time_us() {
+  return s_mic_info.sample_rate
+           ? s_mic_samples * 1000000 / s_mic_info.sample_rate
+           : 0;
+}
+
+int sim_tx_open(size_t sample_rate) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if (s_tx_file) {
+    return 0;
+  }
+  const char *path = getenv("SIM_TX_WAV");
+  s_tx_file = fopen(path ? path : "sim_tx.wav", "wb");
+  if (!s_tx_file) {
+    ESP_LOGE(TAG, "Unable to open tx output");
+    return -1;
+  }
+  s_tx_info = {.sample_rate = sample_rate, .channels = 1, .data_bytes = 0};
+  wav_write_header(s_tx_file, s_tx_info);
+  return 0;
+}
+
+void sim_tx_write(const void *data, size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (!s_tx_file) {
+      return;
+    }
+    fwrite(data, 1, bytes, s_tx_file);
+    s_tx_info.data_bytes += bytes;
+  }
+  // playback takes its real time, continuous writes are queued back to back
+  const int64_t now = esp_timer_get_time();
+  const int64_t end_us = s_tx_start_us + s_tx_samples * 1000000 /
+                                           s_tx_info.sample_rate;
+  if (end_us < now) {
+    s_tx_start_us = now;
+    s_tx_samples = 0;
+  }
+  s_tx_samples += bytes / sizeof(int16_t);
+  wait_until(s_tx_start_us + s_tx_samples * 1000000 / s_tx_info.sample_rate);
+}
+
+void sim_tx_close() {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if (s_tx_file) {
+    wav_write_header(s_tx_file, s_tx_info);
+    fclose(s_tx_file);
+    s_tx_file = NULL;
+  }
+}
+
+void sim_trace(const char *event, int value) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if (!s_trace_file) {
+    const char *path = getenv("SIM_TRACE");
+    s_trace_file = path ? fopen(path, "w") : NULL;
+    if (!s_trace_file) {
+      s_trace_file = stdout;
+    }
+  }
+  const int64_t now = esp_timer_get_time();
+  fprintf(s_trace_file, "TRACE %lld %lld %s %d\n", now, sim_mic_time_us(),
+          event, value);
+  s_trace_counts[event]++;
+
+  if (strcmp(event, "vad_word") == 0) {
+    s_word_end_us = now;
+  } else if (strcmp(event, "kws") == 0 && s_word_end_us >= 0) {
+    const int64_t latency_us = now - s_word_end_us;
+    s_kws_latency.min_us = std::min(s_kws_latency.min_us, latency_us);
+    s_kws_latency.max_us = std::max(s_kws_latency.max_us, latency_us);
+    s_kws_latency.sum_us += latency_us;
+    s_kws_latency.num++;
+  }
+  sample_heap();
+}
+
+static void print_summary() {
+  const int64_t mic_time_us = sim_mic_time_us();
+  const int64_t real_time_us = esp_timer_sim_real_time();
+  printf("SIM SUMMARY: mic_time_s=%.1f real_time_s=%.1f speedup=%.1fx%s\n",
+         mic_time_us / 1e6f, real_time_us / 1e6f,
+         float(mic_time_us) / std::max(real_time_us, int64_t(1)),
+         s_virtual_time ? " (virtual time)" : "");
+  printf("SIM SUMMARY: mic_overruns=%d\n", s_mic_overruns);
+  for (const auto &[event, count] : s_trace_counts) {
+    printf("SIM SUMMARY: %s=%d, %.1f per 24h\n", event.c_str(), count,
+           count * 86400e6f / std::max(mic_time_us, int64_t(1)));
+  }
+  if (s_kws_latency.num) {
+    printf("SIM SUMMARY: kws_latency_us min=%lld avg=%lld max=%lld\n",
+           s_kws_latency.min_us, s_kws_latency.sum_us / s_kws_latency.num,
+           s_kws_latency.max_us);
+  }
+
+  const struct mallinfo2 info = mallinfo2();
+  // free chunks below the top of heap are fragmentation
+  printf("SIM SUMMARY: heap_peak=%d heap_in_use=%d heap_fragmented=%d\n",
+         std::max(s_heap_peak, info.uordblks), info.uordblks,
+         info.fordblks - info.keepcost);
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+  std::vector<TaskStatus_t> tasks(uxTaskGetNumberOfTasks());
+  tasks.resize(uxTaskGetSystemState(tasks.data(), tasks.size(), NULL));
+  for (const auto &task : tasks) {
+    printf("SIM SUMMARY: stack_hwm[%s]=%d\n", task.pcTaskName,
+           task.usStackHighWaterMark);
+  }
+#endif
+}
+
+void sim_exit(int code) {
+  sim_tx_close();
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    print_summary();
+    if (s_trace_file) {
+      fflush(s_trace_file);
+    }
+  }
+  fflush(stdout);
+  exit(code);
+}
@@ -0,0 +1,75 @@
+#include "wav.h"
+
+#include <string.h>
+
+struct __attribute__((packed)) chunk_t {
+  char id[4];
+  uint32_t size;
+};
+
+struct __attribute__((packed)) fmt_t {
+  uint16_t audio_format;
+  uint16_t channels;
+  uint32_t sample_rate;
+  uint32_t byte_rate;
+  uint16_t block_align;
+  uint16_t bits_per_sample;
+};
+
+int wav_read_header(FILE *file, wav_info_t *info) {
+  chunk_t riff;
+  char wave[4];
+  if (fread(&riff, sizeof(riff), 1, file) != 1 ||
+      fread(wave, sizeof(wave), 1, file) != 1 ||
+      memcmp(riff.id, "RIFF", 4) != 0 || memcmp(wave, "WAVE", 4) != 0) {
+    return -1;
+  }
+
+  bool has_fmt = false;
+  chunk_t chunk;
+  while (fread(&chunk, sizeof(chunk), 1, file) == 1) {
+    if (memcmp(chunk.id, "fmt ", 4) == 0 && chunk.size >= sizeof(fmt_t)) {
+      fmt_t fmt;
+      if (fread(&fmt, sizeof(fmt), 1, file) != 1) {
+        return -1;
+      }
+      if (fmt.audio_format != 1 || fmt.bits_per_sample != 16) {
+        return -1;
+      }
+      info->sample_rate = fmt.sample_rate;
+      info->channels = fmt.channels;
+      has_fmt = true;
+      fseek(file, chunk.size - sizeof(fmt) + (chunk.size & 1), SEEK_CUR);
+    } else if (memcmp(chunk.id, "data", 4) == 0) {
+      info->data_bytes = chunk.size;
+      return has_fmt ? 0 : -1;
+    } else {
+      fseek(file, chunk.size + (chunk.size & 1), SEEK_CUR);
+    }
+  }
+  return -1;
+}
+
+int wav_write_header(FILE *file, const wav_info_t &info) {
+  const fmt_t fmt = {
+    .audio_format = 1,
+    .channels = uint16_t(info.channels),
+    .sample_rate = uint32_t(info.sample_rate),
+    .byte_rate = uint32_t(info.sample_rate * info.channels * 2),
+    .block_align = uint16_t(info.channels * 2),
+    .bits_per_sample = 16,
+  };
+  const chunk_t riff = {{'R', 'I', 'F', 'F'},
+                        uint32_t(4 + 2 * sizeof(chunk_t) + sizeof(fmt) +
+                                 info.data_bytes)};
+  const chunk_t fmt_chunk = {{'f', 'm', 't', ' '}, sizeof(fmt)};
+  const chunk_t data_chunk = {{'d', 'a', 't', 'a'}, uint32_t(info.data_bytes)};
+
+  fseek(file, 0, SEEK_SET);
+  const bool ok = fwrite(&riff, sizeof(riff), 1, file) == 1 &&
+                  fwrite("WAVE", 4, 1, file) == 1 &&
+                  fwrite(&fmt_chunk, sizeof(fmt_chunk), 1, file) == 1 &&
+                  fwrite(&fmt, sizeof(fmt), 1, file) == 1 &&
+                  fwrite(&data_chunk, sizeof(data_chunk), 1, file) == 1;
+  return ok ? 0 : -1;
+}
@@ -0,0 +1,29 @@
+#ifndef _SIM_WAV_H_
+#define _SIM_WAV_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct wav_info_t {
+  size_t sample_rate;
+  size_t channels;
+  size_t data_bytes;
+};
+
+/*!
+ * \brief Parse header of 16 bit PCM WAV, file is left at data start.
+ * \param file WAV file.
+ * \param info Parsed format.
+ * \return Result.
+ */
+int wav_read_header(FILE *file, wav_info_t *info);
+/*!
+ * \brief Write 16 bit PCM WAV header.
+ * \param file WAV file, header is written at start.
+ * \param info Format.
+ * \return Result.
+ */
+int wav_write_header(FILE *file, const wav_info_t &info);
+
+#endif // _SIM_WAV_H_
@@ -0,0 +1,869 @@
+/*!
+ * \brief Offline evaluation of KWS/SED models over a labeled WAV corpus.
+ *
+ * Features come from the FeatureExtractor configured by the model, as in
+ * kws_task and sed_task. The corpus is sharded between worker threads, each
+ * worker owns its extractor, tensor arena and model handle.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "feature_extractor.h"
+#include "feature_store.h"
+#include "model_op_resolver.h"
+#include "multi_feature_extractor.h"
+#include "nn_model.h"
+#include "tensor_arena.h"
+#include "wav.h"
+
+/*! \brief Defined in main/, model headers share the include guard. */
+extern const nn_model_desc_t voice_relay_model;
+extern const nn_model_desc_t numbers_model;
+extern const nn_model_desc_t objects_model;
+extern const nn_model_desc_t baby_cry_model;
+extern const nn_model_desc_t glass_breaking_model;
+extern const nn_model_desc_t bark_model;
+extern const nn_model_desc_t coughing_model;
+
+static const char *TAG = "corpus_eval";
+
+#define SAMPLE_RATE 16000
+#define HOP_MS      500
+#define HOP_LEN     (SAMPLE_RATE / 1000 * HOP_MS)
+#define ROC_STEPS   100
+
+struct model_entry_t {
+  const char *name;
+  const nn_model_desc_t *desc;
+  float threshold;
+};
+
+/*! \brief Thresholds as set in main/CMakeLists.txt. */
+static const model_entry_t s_models[] = {
+  {"voice_relay", &voice_relay_model, 0.8f},
+  {"numbers", &numbers_model, 0.7f},
+  {"objects", &objects_model, 0.7f},
+  {"baby_cry", &baby_cry_model, 0.9f},
+  {"glass_breaking", &glass_breaking_model, 0.9f},
+  {"bark", &bark_model, 0.9f},
+  {"coughing", &coughing_model, 0.9f},
+};
+
+struct corpus_item_t {
+  std::string path;
+  int label;
+  size_t samples;
+  std::vector<float> scores;
+  bool ok;
+};
+
+/*! \brief Op timing summed over the workers. */
+struct profile_t {
+  std::mutex lock;
+  std::vector<nn_model_op_profile_t> ops;
+  int64_t invoke_us;
+  std::vector<nn_model_tensor_usage_t> tensors;
+  size_t arena_used;
+};
+
+struct worker_ctx_t {
+  const model_entry_t *model;
+  std::vector<corpus_item_t> *items;
+  std::atomic<size_t> *next_item;
+  /*! \brief Features are written to the store, NULL - not saved. */
+  feature_store_t *store_writer;
+  /*! \brief Features are read from the store, NULL - computed from WAV. */
+  const feature_store_map_t *store;
+  const std::vector<std::vector<size_t>> *item_records;
+  /*! \brief Op timing is collected, NULL - not profiled. */
+  profile_t *profile;
+};
+
+/*! \brief Feature store parameters of the model preprocessing. */
+static feature_store_header_t store_header(const model_entry_t &model) {
+  const FeatureExtractor fe(model.desc, SAMPLE_RATE);
+  feature_store_header_t header = {};
+  // the store kinds are the model feature types
+  header.kind = feature_store_kind_t(fe.preproc.features);
+  header.sample_rate = SAMPLE_RATE;
+  header.frame_len = fe.frameLen;
+  header.frame_shift = fe.frameShift;
+  header.num_fbank_bins = fe.preproc.num_fbank_bins;
+  header.mel_low_freq = model.desc->mel_low_freq;
+  header.mel_high_freq = model.desc->mel_high_freq;
+  header.num_mfcc = fe.preproc.num_mfcc;
+  header.fft_len = fe.preproc.fft_len;
+  header.frame_num = fe.frameNum;
+  header.row_len = fe.numCoeffs;
+  return header;
+}
+
+static bool store_matches(const feature_store_header_t &a,
+                          const feature_store_header_t &b) {
+  return a.kind == b.kind && a.sample_rate == b.sample_rate &&
+         a.frame_len == b.frame_len && a.frame_shift == b.frame_shift &&
+         a.num_fbank_bins == b.num_fbank_bins &&
+         a.mel_low_freq == b.mel_low_freq &&
+         a.mel_high_freq == b.mel_high_freq && a.num_mfcc == b.num_mfcc &&
+         a.fft_len == b.fft_len && a.frame_num == b.frame_num &&
+         a.row_len == b.row_len;
+}
+
+/*! \brief Input quantization, from a model instance with its own arena. */
+static int model_input_quant(const model_entry_t &model, float *scale,
+                             int *zero_point) {
+  std::vector<uint8_t> arena(TensorArena::getSize());
+  nn_model_handle_t handle = NULL;
+  nn_model_config_t cfg = {
+    .model_desc = model.desc,
+    .inference_threshold = model.threshold,
+    .op_resolver = model_op_resolver_get(model.name),
+    .tensor_arena = arena.data(),
+    .tensor_arena_size = arena.size(),
+  };
+  if (nn_model_init(&handle, cfg) != 0) {
+    return -1;
+  }
+  const int ret = nn_model_get_input_quant(handle, scale, zero_point);
+  nn_model_release(handle);
+  return ret;
+}
+
+static int read_wav(const std::string &path, std::vector<int16_t> &pcm) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    ESP_LOGE(TAG, "unable to open %s", path.c_str());
+    return -1;
+  }
+  wav_info_t info;
+  if (wav_read_header(file, &info) != 0 || info.sample_rate != SAMPLE_RATE) {
+    ESP_LOGE(TAG, "%s: expected 16 bit PCM at %d Hz", path.c_str(),
+             SAMPLE_RATE);
+    fclose(file);
+    return -1;
+  }
+  std::vector<int16_t> data(info.data_bytes / sizeof(int16_t));
+  const size_t read = fread(data.data(), sizeof(int16_t), data.size(), file);
+  fclose(file);
+  pcm.resize(read / info.channels);
+  for (size_t i = 0; i < pcm.size(); i++) {
+    pcm[i] = data[i * info.channels];
+  }
+  return 0;
+}
+
+/*!
+ * \brief Features of a window on its own: the frames of the segment padded
+ * with silence as in kws_task, PCEN state starts from the first frame. Used
+ * for peak normalized models, streamed ones use stream_features().
+ */
+static void compute_features(FeatureExtractor &fe, const int16_t *pcm,
+                             size_t len, float *out) {
+  size_t max_abs = 0;
+  for (size_t i = 0; i < len; i++) {
+    max_abs = std::max(max_abs, size_t(std::abs(int(pcm[i]))));
+  }
+  fe.Reset();
+  const size_t frames =
+    fe.ComputeBatch(pcm, len, fe.Norm(max_abs), out, fe.frameNum);
+  for (size_t f = frames; f < fe.frameNum; f++) {
+    fe.Silence(&out[f * fe.numCoeffs]);
+  }
+}
+
+/*!
+ * \brief Frames of a whole file of a streamed model: sed_task computes a frame
+ * per stride and runs PCEN over the stream without resets, the windows are
+ * cut from these frames. Zeros past a file shorter than a window.
+ */
+static void stream_features(FeatureExtractor &fe,
+                            const std::vector<int16_t> &pcm,
+                            std::vector<float> &out) {
+  const size_t stream_len = (fe.frameNum - 1) * fe.frameShift + 1;
+  std::vector<int16_t> padded(pcm);
+  padded.resize(std::max(pcm.size(), stream_len), 0);
+  const size_t max_frames =
+    (padded.size() + fe.frameShift - 1) / fe.frameShift;
+  out.resize(max_frames * fe.numCoeffs);
+  fe.Reset();
+  const size_t frames = fe.ComputeBatch(padded.data(), padded.size(),
+                                        fe.Norm(0), out.data(), max_frames);
+  out.resize(frames * fe.numCoeffs);
+}
+
+/*! \brief Window of frameNum frames from first, silence past the end. */
+static void stream_window(const FeatureExtractor &fe,
+                          const std::vector<float> &frames, size_t first,
+                          float *out) {
+  const size_t frame_num = frames.size() / fe.numCoeffs;
+  for (size_t f = 0; f < fe.frameNum; f++) {
+    if (first + f < frame_num) {
+      std::copy_n(&frames[(first + f) * fe.numCoeffs], fe.numCoeffs,
+                  &out[f * fe.numCoeffs]);
+    } else {
+      fe.Silence(&out[f * fe.numCoeffs]);
+    }
+  }
+}
+
+/*! \brief The window with the most confident event category (index > 1). */
+static void keep_best(const std::vector<float> &scores, float &best,
+                      corpus_item_t &item) {
+  const float event = *std::max_element(scores.begin() + 2, scores.end());
+  if (event > best) {
+    best = event;
+    item.scores = scores;
+  }
+}
+
+/*! \brief Score a file, windows of the model input duration, 0.5 s hop. */
+static void eval_item(const model_entry_t &model, FeatureExtractor &fe,
+                      nn_model_handle_t handle, feature_store_t *writer,
+                      size_t idx, corpus_item_t &item) {
+  std::vector<int16_t> pcm;
+  item.ok = false;
+  if (read_wav(item.path, pcm) != 0 || pcm.empty()) {
+    return;
+  }
+  item.samples = pcm.size();
+
+  const size_t window_len = SAMPLE_RATE / 1000 * fe.preproc.duration_ms;
+  const size_t features_len = fe.featuresLen;
+  const size_t labels_num = model.desc->labels_num;
+  std::vector<float> features(features_len);
+  std::vector<float> scores(labels_num);
+  float best = -1.f;
+  const bool streamed = fe.preproc.norm != NN_MODEL_NORM_PEAK;
+  std::vector<float> stream;
+  if (streamed) {
+    stream_features(fe, pcm, stream);
+  }
+
+  for (size_t start = 0; start == 0 || start + window_len <= pcm.size();
+       start += HOP_LEN) {
+    if (streamed) {
+      stream_window(fe, stream, start / fe.frameShift, features.data());
+    } else {
+      const size_t len = std::min(pcm.size() - start, window_len);
+      compute_features(fe, &pcm[start], len, features.data());
+    }
+    if (writer) {
+      const feature_store_record_t record = {uint32_t(idx),
+                                             uint32_t(pcm.size())};
+      feature_store_append(writer, record, features.data());
+    }
+    if (nn_model_inference_scores(handle, features.data(), features_len,
+                                  scores.data(), labels_num) != 0) {
+      return;
+    }
+    keep_best(scores, best, item);
+  }
+  item.ok = true;
+}
+
+/*! \brief Score a file from stored windows, inference reads the mapping. */
+static void eval_stored_item(const model_entry_t &model,
+                             nn_model_handle_t handle,
+                             const feature_store_map_t &store,
+                             const std::vector<size_t> &records,
+                             corpus_item_t &item) {
+  const feature_store_header_t &header = *store.header;
+  const size_t features_len = size_t(header.frame_num) * header.row_len;
+  const size_t labels_num = model.desc->labels_num;
+  std::vector<float> scores(labels_num);
+  float best = -1.f;
+  item.ok = false;
+
+  for (const size_t r : records) {
+    const void *data = feature_store_record(store, r);
+    int ret;
+    if (header.dtype == FEATURE_STORE_INT8) {
+      ret = nn_model_inference_quantized(
+        handle, static_cast<const int8_t *>(data), features_len,
+        scores.data(), labels_num);
+    } else {
+      ret = nn_model_inference_scores(handle, static_cast<const float *>(data),
+                                      features_len, scores.data(), labels_num);
+    }
+    if (ret != 0) {
+      return;
+    }
+    keep_best(scores, best, item);
+    item.samples = store.index[r].samples;
+  }
+  item.ok = !records.empty();
+}
+
+static void merge_profile(nn_model_handle_t handle, profile_t &profile) {
+  size_t op_num = 0;
+  int64_t invoke_us = 0;
+  if (nn_model_get_op_profile(handle, NULL, &op_num, NULL) != 0) {
+    return;
+  }
+  std::vector<nn_model_op_profile_t> ops(op_num);
+  nn_model_get_op_profile(handle, ops.data(), &op_num, &invoke_us);
+
+  std::lock_guard<std::mutex> guard(profile.lock);
+  if (profile.ops.empty()) {
+    profile.ops = ops;
+    profile.invoke_us = invoke_us;
+    size_t tensor_num = 0;
+    nn_model_get_tensor_usage(handle, NULL, &tensor_num, NULL);
+    profile.tensors.resize(tensor_num);
+    nn_model_get_tensor_usage(handle, profile.tensors.data(), &tensor_num,
+                              &profile.arena_used);
+    return;
+  }
+  for (size_t i = 0; i < ops.size() && i < profile.ops.size(); i++) {
+    nn_model_op_profile_t &op = profile.ops[i];
+    op.tag = op.tag ? op.tag : ops[i].tag;
+    op.count += ops[i].count;
+    op.total_us += ops[i].total_us;
+    op.max_us = std::max(op.max_us, ops[i].max_us);
+  }
+  profile.invoke_us += invoke_us;
+}
+
+static void worker(worker_ctx_t ctx) {
+  const model_entry_t &model = *ctx.model;
+  FeatureExtractor fe(model.desc, SAMPLE_RATE);
+  std::vector<uint8_t> arena(TensorArena::getSize());
+
+  nn_model_handle_t handle = NULL;
+  nn_model_config_t cfg = {
+    .model_desc = model.desc,
+    .inference_threshold = model.threshold,
+    .op_resolver = model_op_resolver_get(model.name),
+    .tensor_arena = arena.data(),
+    .tensor_arena_size = arena.size(),
+    .profile = ctx.profile != NULL,
+  };
+  if (nn_model_init(&handle, cfg) != 0) {
+    return;
+  }
+
+  for (;;) {
+    const size_t i = (*ctx.next_item)++;
+    if (i >= ctx.items->size()) {
+      break;
+    }
+    if (ctx.store) {
+      eval_stored_item(model, handle, *ctx.store, (*ctx.item_records)[i],
+                       (*ctx.items)[i]);
+    } else {
+      eval_item(model, fe, handle, ctx.store_writer, i, (*ctx.items)[i]);
+    }
+  }
+
+  if (ctx.profile) {
+    merge_profile(handle, *ctx.profile);
+  }
+  nn_model_release(handle);
+}
+
+/*! \brief Category as nn_model_inference reports it, -1 maps to labels[1]. */
+static int predict(const std::vector<float> &scores, float threshold) {
+  const size_t idx =
+    std::max_element(scores.begin(), scores.end()) - scores.begin();
+  return scores[idx] > threshold ? int(idx) : 1;
+}
+
+static int find_label(const nn_model_desc_t *desc, const char *label) {
+  for (size_t i = 0; i < desc->labels_num; i++) {
+    if (strcmp(desc->labels[i], label) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*!
+ * \brief Corpus list, one "path,label" per line. Relative paths are resolved
+ * against the list directory, unknown labels count as labels[1].
+ */
+static int read_corpus(const char *list_path, const nn_model_desc_t *desc,
+                       std::vector<corpus_item_t> &items) {
+  FILE *file = fopen(list_path, "r");
+  if (!file) {
+    ESP_LOGE(TAG, "unable to open %s", list_path);
+    return -1;
+  }
+  std::string dir(list_path);
+  const size_t slash = dir.find_last_of('/');
+  dir = slash == std::string::npos ? "" : dir.substr(0, slash + 1);
+
+  char line[1024];
+  while (fgets(line, sizeof(line), file)) {
+    line[strcspn(line, "\r\n")] = 0;
+    char *comma = strrchr(line, ',');
+    if (line[0] == '#' || !comma) {
+      continue;
+    }
+    *comma = 0;
+    corpus_item_t item = {};
+    item.path = line[0] == '/' ? line : dir + line;
+    item.label = find_label(desc, comma + 1);
+    if (item.label < 0) {
+      item.label = 1;
+    }
+    items.push_back(item);
+  }
+  fclose(file);
+  return items.empty() ? -1 : 0;
+}
+
+static void write_confusion(FILE *out, const nn_model_desc_t *desc,
+                            const std::vector<corpus_item_t> &items,
+                            float threshold) {
+  const size_t n = desc->labels_num;
+  std::vector<size_t> matrix(n * n, 0);
+  size_t correct = 0, total = 0;
+  for (const auto &item : items) {
+    if (!item.ok) {
+      continue;
+    }
+    const int pred = predict(item.scores, threshold);
+    matrix[item.label * n + pred]++;
+    correct += pred == item.label;
+    total++;
+  }
+  fprintf(out, "true\\pred");
+  for (size_t i = 0; i < n; i++) {
+    fprintf(out, ",%s", desc->labels[i]);
+  }
+  fprintf(out, "\n");
+  for (size_t i = 0; i < n; i++) {
+    fprintf(out, "%s", desc->labels[i]);
+    for (size_t j = 0; j < n; j++) {
+      fprintf(out, ",%zu", matrix[i * n + j]);
+    }
+    fprintf(out, "\n");
+  }
+  printf("accuracy: %.4f (%zu/%zu) at threshold %.2f\n",
+         total ? float(correct) / total : 0.f, correct, total, threshold);
+}
+
+/*!
+ * \brief One-vs-rest ROC/DET points per event category, category score is
+ * swept over [0; 1].
+ */
+static void write_roc(FILE *out, const nn_model_desc_t *desc,
+                      const std::vector<corpus_item_t> &items) {
+  fprintf(out, "label,threshold,tpr,fpr,fnr\n");
+  for (size_t c = 2; c < desc->labels_num; c++) {
+    float auc = 0.f, prev_tpr = 1.f, prev_fpr = 1.f;
+    for (size_t s = 0; s <= ROC_STEPS; s++) {
+      const float threshold = float(s) / ROC_STEPS;
+      size_t tp = 0, fp = 0, p = 0, n = 0;
+      for (const auto &item : items) {
+        if (!item.ok) {
+          continue;
+        }
+        const bool positive = item.label == int(c);
+        const bool detected = item.scores[c] >= threshold;
+        p += positive;
+        n += !positive;
+        tp += positive && detected;
+        fp += !positive && detected;
+      }
+      const float tpr = p ? float(tp) / p : 0.f;
+      const float fpr = n ? float(fp) / n : 0.f;
+      fprintf(out, "%s,%.2f,%.4f,%.4f,%.4f\n", desc->labels[c], threshold,
+              tpr, fpr, 1.f - tpr);
+      auc += (prev_fpr - fpr) * (prev_tpr + tpr) / 2;
+      prev_tpr = tpr;
+      prev_fpr = fpr;
+    }
+    auc += prev_fpr * prev_tpr / 2;
+    printf("%s: auc=%.4f\n", desc->labels[c], auc);
+  }
+}
+
+/*! \brief Per-op CSV, time per op type and tensors to stdout. */
+static void write_profile(FILE *out, const profile_t &profile) {
+  fprintf(out, "op,tag,count,avg_us,max_us\n");
+  std::vector<std::pair<const char *, int64_t>> types;
+  for (size_t i = 0; i < profile.ops.size(); i++) {
+    const nn_model_op_profile_t &op = profile.ops[i];
+    if (!op.count) {
+      continue;
+    }
+    fprintf(out, "%zu,%s,%u,%.1f,%lld\n", i, op.tag, unsigned(op.count),
+            double(op.total_us) / op.count, (long long)op.max_us);
+    auto it = std::find_if(types.begin(), types.end(), [&](const auto &t) {
+      return strcmp(t.first, op.tag) == 0;
+    });
+    if (it == types.end()) {
+      types.emplace_back(op.tag, 0);
+      it = types.end() - 1;
+    }
+    it->second += op.total_us;
+  }
+  for (const auto &t : types) {
+    printf("%-24s %5.1f%%\n", t.first,
+           profile.invoke_us ? 100. * t.second / profile.invoke_us : 0.);
+  }
+  size_t tensors_bytes = 0;
+  for (const auto &t : profile.tensors) {
+    tensors_bytes += t.bytes;
+  }
+  printf("arena used %zu bytes, %zu tensors of %zu bytes without reuse\n",
+         profile.arena_used, profile.tensors.size(), tensors_bytes);
+}
+
+/*!
+ * \brief Features of the corpus windows with the frame zero padded to a power
+ * of 2 and with the FFT of the frame length: time per window and difference.
+ */
+static int compare_fft(const model_entry_t &model,
+                       const std::vector<corpus_item_t> &items) {
+  nn_model_desc_t pow2_desc = *model.desc;
+  pow2_desc.preproc.fft_len = NN_MODEL_FFT_LEN_POW2;
+  nn_model_desc_t window_desc = *model.desc;
+  window_desc.preproc.fft_len = NN_MODEL_FFT_LEN_WINDOW;
+  if (FeatureExtractor::Validate(&window_desc, SAMPLE_RATE) != 0) {
+    return -1;
+  }
+  FeatureExtractor pow2(&pow2_desc, SAMPLE_RATE);
+  FeatureExtractor window(&window_desc, SAMPLE_RATE);
+  const size_t window_len = SAMPLE_RATE / 1000 * pow2.preproc.duration_ms;
+  std::vector<float> a(pow2.featuresLen);
+  std::vector<float> b(window.featuresLen);
+
+  using clock = std::chrono::steady_clock;
+  clock::duration pow2_time{}, window_time{};
+  size_t windows = 0;
+  double max_delta = 0, delta_sq = 0, ref_sq = 0;
+  for (const auto &item : items) {
+    std::vector<int16_t> pcm;
+    if (read_wav(item.path, pcm) != 0 || pcm.empty()) {
+      continue;
+    }
+    for (size_t start = 0; start == 0 || start + window_len <= pcm.size();
+         start += HOP_LEN) {
+      const size_t len = std::min(pcm.size() - start, window_len);
+      const auto t1 = clock::now();
+      compute_features(pow2, &pcm[start], len, a.data());
+      const auto t2 = clock::now();
+      compute_features(window, &pcm[start], len, b.data());
+      window_time += clock::now() - t2;
+      pow2_time += t2 - t1;
+      for (size_t i = 0; i < a.size(); i++) {
+        const double d = b[i] - a[i];
+        max_delta = std::max(max_delta, std::abs(d));
+        delta_sq += d * d;
+        ref_sq += double(a[i]) * a[i];
+      }
+      windows++;
+    }
+  }
+  if (!windows) {
+    return -1;
+  }
+
+  size_t padded = 1;
+  while (padded < pow2.frameLen) {
+    padded *= 2;
+  }
+  const auto us = [&](clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count() / windows;
+  };
+  printf("%zu windows, %zu frames of %zu samples\n", windows, pow2.frameNum,
+         pow2.frameLen);
+  printf("fft %zu: %.1f us/window\n", padded, us(pow2_time));
+  printf("fft %zu: %.1f us/window\n", window.frameLen, us(window_time));
+  const size_t values = windows * a.size();
+  printf("feature delta: max %.4f, rms %.4f, relative rms %.4f\n", max_delta,
+         std::sqrt(delta_sq / values), std::sqrt(delta_sq / ref_sq));
+  return 0;
+}
+
+/*!
+ * \brief Features of the full corpus windows of two models from
+ * MultiFeatureExtractor and from a FeatureExtractor per model: time per
+ * window and the largest difference per model.
+ */
+static int compare_multi(const model_entry_t &model,
+                         const model_entry_t &other,
+                         const std::vector<corpus_item_t> &items) {
+  const nn_model_desc_t *descs[] = {model.desc, other.desc};
+  std::unique_ptr<MultiFeatureExtractor> multi(
+    MultiFeatureExtractor::Create(descs, 2, SAMPLE_RATE));
+  if (!multi || FeatureExtractor::Validate(other.desc, SAMPLE_RATE) != 0) {
+    return -1;
+  }
+  FeatureExtractor a(model.desc, SAMPLE_RATE);
+  FeatureExtractor b(other.desc, SAMPLE_RATE);
+  const size_t frames = std::min(a.frameNum, b.frameNum);
+  const size_t window_len = (frames - 1) * a.frameShift + a.frameLen;
+  std::vector<float> ref_a(a.featuresLen), ref_b(b.featuresLen);
+  std::vector<float> out_a(a.featuresLen), out_b(b.featuresLen);
+  float *out[] = {out_a.data(), out_b.data()};
+
+  using clock = std::chrono::steady_clock;
+  clock::duration separate_time{}, multi_time{};
+  size_t windows = 0;
+  double max_a = 0, max_b = 0;
+  for (const auto &item : items) {
+    std::vector<int16_t> pcm;
+    if (read_wav(item.path, pcm) != 0) {
+      continue;
+    }
+    for (size_t start = 0; start + window_len <= pcm.size();
+         start += HOP_LEN) {
+      const int16_t *window = &pcm[start];
+      size_t max_abs = 0;
+      for (size_t i = 0; i < window_len; i++) {
+        max_abs = std::max(max_abs, size_t(std::abs(int(window[i]))));
+      }
+      const float norms[] = {a.Norm(max_abs), b.Norm(max_abs)};
+
+      const auto t1 = clock::now();
+      a.Reset();
+      a.ComputeBatch(window, window_len, norms[0], ref_a.data(), frames);
+      b.Reset();
+      b.ComputeBatch(window, window_len, norms[1], ref_b.data(), frames);
+      const auto t2 = clock::now();
+      multi->Head(0).Reset();
+      multi->Head(1).Reset();
+      multi->ComputeBatch(window, window_len, norms, out, frames);
+      multi_time += clock::now() - t2;
+      separate_time += t2 - t1;
+
+      for (size_t i = 0; i < frames * a.numCoeffs; i++) {
+        max_a = std::max(max_a, double(std::abs(out_a[i] - ref_a[i])));
+      }
+      for (size_t i = 0; i < frames * b.numCoeffs; i++) {
+        max_b = std::max(max_b, double(std::abs(out_b[i] - ref_b[i])));
+      }
+      windows++;
+    }
+  }
+  if (!windows) {
+    return -1;
+  }
+
+  const auto us = [&](clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count() / windows;
+  };
+  printf("%zu windows, %zu frames of %zu samples\n", windows, frames,
+         a.frameLen);
+  printf("separate: %.1f us/window\n", us(separate_time));
+  printf("shared: %.1f us/window\n", us(multi_time));
+  printf("feature delta: %s max %.2e, %s max %.2e\n", model.name, max_a,
+         other.name, max_b);
+  return 0;
+}
+
+static void usage(const char *prog) {
+  printf("usage: %s -m <model> -c <corpus.csv> [-j threads] [-t threshold] "
+         "[-o out_prefix] [-w features.bin [-d float|int8]] "
+         "[-r features.bin] [-p 1] [-f pow2|window] [-x 1] "
+         "[-s other_model]\nmodels:",
+         prog);
+  for (const auto &m : s_models) {
+    printf(" %s", m.name);
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  const char *model_name = NULL;
+  const char *corpus_path = NULL;
+  const char *out_prefix = "corpus_eval";
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  float threshold = -1.f;
+  const char *write_path = NULL;
+  const char *read_path = NULL;
+  const char *dtype = "float";
+  bool profiling = false;
+  const char *fft_len = NULL;
+  bool fft_compare = false;
+  const char *multi_name = NULL;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "-m") == 0) {
+      model_name = argv[i + 1];
+    } else if (strcmp(argv[i], "-c") == 0) {
+      corpus_path = argv[i + 1];
+    } else if (strcmp(argv[i], "-j") == 0) {
+      threads = std::max(1, atoi(argv[i + 1]));
+    } else if (strcmp(argv[i], "-t") == 0) {
+      threshold = atof(argv[i + 1]);
+    } else if (strcmp(argv[i], "-o") == 0) {
+      out_prefix = argv[i + 1];
+    } else if (strcmp(argv[i], "-w") == 0) {
+      write_path = argv[i + 1];
+    } else if (strcmp(argv[i], "-r") == 0) {
+      read_path = argv[i + 1];
+    } else if (strcmp(argv[i], "-d") == 0) {
+      dtype = argv[i + 1];
+    } else if (strcmp(argv[i], "-p") == 0) {
+      profiling = atoi(argv[i + 1]) != 0;
+    } else if (strcmp(argv[i], "-f") == 0) {
+      fft_len = argv[i + 1];
+    } else if (strcmp(argv[i], "-x") == 0) {
+      fft_compare = atoi(argv[i + 1]) != 0;
+    } else if (strcmp(argv[i], "-s") == 0) {
+      multi_name = argv[i + 1];
+    }
+  }
+
+  const model_entry_t *model = NULL;
+  const model_entry_t *multi_model = NULL;
+  for (const auto &m : s_models) {
+    if (model_name && strcmp(m.name, model_name) == 0) {
+      model = &m;
+    }
+    if (multi_name && strcmp(m.name, multi_name) == 0) {
+      multi_model = &m;
+    }
+  }
+  if (!model || !corpus_path || (write_path && read_path) ||
+      (multi_name && !multi_model)) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (threshold < 0) {
+    threshold = model->threshold;
+  }
+  // the model with the other FFT length, e.g. retrained with it
+  static nn_model_desc_t fft_desc;
+  static model_entry_t fft_model;
+  if (fft_len) {
+    fft_desc = *model->desc;
+    fft_desc.preproc.fft_len = strcmp(fft_len, "window") == 0
+                                 ? NN_MODEL_FFT_LEN_WINDOW
+                                 : NN_MODEL_FFT_LEN_POW2;
+    fft_model = *model;
+    fft_model.desc = &fft_desc;
+    model = &fft_model;
+  }
+  if (FeatureExtractor::Validate(model->desc, SAMPLE_RATE) != 0) {
+    return 1;
+  }
+
+  std::vector<corpus_item_t> items;
+  if (read_corpus(corpus_path, model->desc, items) != 0) {
+    ESP_LOGE(TAG, "empty corpus %s", corpus_path);
+    return 1;
+  }
+  if (fft_compare) {
+    return compare_fft(*model, items) == 0 ? 0 : 1;
+  }
+  if (multi_model) {
+    return compare_multi(*model, *multi_model, items) == 0 ? 0 : 1;
+  }
+  threads = std::min(threads, items.size());
+
+  feature_store_t *writer = NULL;
+  if (write_path) {
+    feature_store_header_t header = store_header(*model);
+    if (strcmp(dtype, "int8") == 0) {
+      header.dtype = FEATURE_STORE_INT8;
+      if (model_input_quant(*model, &header.scale, &header.zero_point) != 0) {
+        ESP_LOGE(TAG, "int8 features need a quantized model");
+        return 1;
+      }
+    }
+    writer = feature_store_create(write_path, header);
+    if (!writer) {
+      return 1;
+    }
+  }
+
+  feature_store_map_t store = {};
+  std::vector<std::vector<size_t>> item_records(items.size());
+  if (read_path) {
+    if (feature_store_map(read_path, &store) != 0) {
+      return 1;
+    }
+    const feature_store_header_t &header = *store.header;
+    if (!store_matches(header, store_header(*model))) {
+      ESP_LOGE(TAG, "%s: preprocessing differs from %s", read_path,
+               model->name);
+      return 1;
+    }
+    float scale;
+    int zero_point;
+    if (header.dtype == FEATURE_STORE_INT8 &&
+        (model_input_quant(*model, &scale, &zero_point) != 0 ||
+         scale != header.scale || zero_point != header.zero_point)) {
+      ESP_LOGE(TAG, "%s: quantization differs from %s", read_path,
+               model->name);
+      return 1;
+    }
+    for (size_t r = 0; r < header.record_num; r++) {
+      if (store.index[r].item < items.size()) {
+        item_records[store.index[r].item].push_back(r);
+      }
+    }
+  }
+
+  std::atomic<size_t> next_item(0);
+  profile_t profile = {};
+  const auto t1 = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (size_t i = 0; i < threads; i++) {
+    pool.emplace_back(worker,
+                      worker_ctx_t{model, &items, &next_item, writer,
+                                   read_path ? &store : NULL, &item_records,
+                                   profiling ? &profile : NULL});
+  }
+  for (auto &t : pool) {
+    t.join();
+  }
+  const double elapsed = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - t1)
+                           .count();
+  if (writer && feature_store_close(writer) != 0) {
+    return 1;
+  }
+  feature_store_unmap(&store);
+
+  size_t files = 0, samples = 0;
+  for (const auto &item : items) {
+    files += item.ok;
+    samples += item.ok ? item.samples : 0;
+  }
+  if (files == 0) {
+    ESP_LOGE(TAG, "no files evaluated");
+    return 1;
+  }
+  printf("%s: %zu/%zu files, %zu threads\n", model->name, files,
+         items.size(), threads);
+  printf("throughput: %.1f files/s, %.1f audio s/s\n", files / elapsed,
+         double(samples) / SAMPLE_RATE / elapsed);
+
+  const std::string confusion_path = std::string(out_prefix) + "_confusion.csv";
+  const std::string roc_path = std::string(out_prefix) + "_roc.csv";
+  FILE *out = fopen(confusion_path.c_str(), "w");
+  if (out) {
+    write_confusion(out, model->desc, items, threshold);
+    fclose(out);
+  }
+  out = fopen(roc_path.c_str(), "w");
+  if (out) {
+    write_roc(out, model->desc, items);
+    fclose(out);
+  }
+  if (profiling) {
+    const std::string profile_path =
+      std::string(out_prefix) + "_profile.csv";
+    out = fopen(profile_path.c_str(), "w");
+    if (out) {
+      write_profile(out, profile);
+      fclose(out);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+#include "feature_store.h"
+
+#include "esp_log.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "feature_store";
+
+static size_t record_size(const feature_store_header_t &header) {
+  const size_t elem_size =
+    header.dtype == FEATURE_STORE_INT8 ? sizeof(int8_t) : sizeof(float);
+  return size_t(header.frame_num) * header.row_len * elem_size;
+}
+
+feature_store_t *feature_store_create(const char *path,
+                                      const feature_store_header_t &header) {
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    ESP_LOGE(TAG, "unable to create %s", path);
+    return NULL;
+  }
+  feature_store_t *store = new feature_store_t;
+  store->file = file;
+  store->header = header;
+  store->header.magic = FEATURE_STORE_MAGIC;
+  store->header.version = FEATURE_STORE_VERSION;
+  store->header.record_num = 0;
+  store->header.data_offset = FEATURE_STORE_DATA_OFFSET;
+  store->header.index_offset = 0;
+  store->qbuf.resize(size_t(header.frame_num) * header.row_len);
+  fseek(file, FEATURE_STORE_DATA_OFFSET, SEEK_SET);
+  return store;
+}
+
+int feature_store_append(feature_store_t *store,
+                         const feature_store_record_t &record,
+                         const float *features) {
+  std::lock_guard<std::mutex> guard(store->lock);
+  const feature_store_header_t &header = store->header;
+  const void *data = features;
+  if (header.dtype == FEATURE_STORE_INT8) {
+    // same rounding and saturation as set_input() in nn_model
+    for (size_t i = 0; i < store->qbuf.size(); i++) {
+      const long q = lroundf(features[i] / header.scale) + header.zero_point;
+      store->qbuf[i] = int8_t(std::clamp(q, -128l, 127l));
+    }
+    data = store->qbuf.data();
+  }
+  if (fwrite(data, record_size(header), 1, store->file) != 1) {
+    ESP_LOGE(TAG, "write failed");
+    return -1;
+  }
+  store->index.push_back(record);
+  return 0;
+}
+
+int feature_store_close(feature_store_t *store) {
+  feature_store_header_t &header = store->header;
+  header.record_num = store->index.size();
+  header.index_offset =
+    (header.data_offset + header.record_num * record_size(header) + 7) & ~7u;
+
+  int ret = 0;
+  if (fseek(store->file, header.index_offset, SEEK_SET) != 0 ||
+      fwrite(store->index.data(), sizeof(feature_store_record_t),
+             store->index.size(),
+             store->file) != store->index.size() ||
+      fseek(store->file, 0, SEEK_SET) != 0 ||
+      fwrite(&header, sizeof(header), 1, store->file) != 1) {
+    ESP_LOGE(TAG, "write failed");
+    ret = -1;
+  }
+  fclose(store->file);
+  delete store;
+  return ret;
+}
+
+int feature_store_map(const char *path, feature_store_map_t *map) {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    ESP_LOGE(TAG, "unable to open %s", path);
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(*map->header)) {
+    ESP_LOGE(TAG, "%s is truncated", path);
+    close(fd);
+    return -1;
+  }
+  void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    ESP_LOGE(TAG, "unable to map %s", path);
+    return -1;
+  }
+
+  const feature_store_header_t *header =
+    static_cast<const feature_store_header_t *>(base);
+  const size_t rec_size = record_size(*header);
+  if (header->magic != FEATURE_STORE_MAGIC ||
+      header->version != FEATURE_STORE_VERSION) {
+    ESP_LOGE(TAG, "%s: unsupported format", path);
+    munmap(base, st.st_size);
+    return -1;
+  }
+  if (header->index_offset <
+        header->data_offset + size_t(header->record_num) * rec_size ||
+      header->index_offset +
+          size_t(header->record_num) * sizeof(feature_store_record_t) >
+        size_t(st.st_size)) {
+    ESP_LOGE(TAG, "%s is truncated", path);
+    munmap(base, st.st_size);
+    return -1;
+  }
+
+  const uint8_t *bytes = static_cast<const uint8_t *>(base);
+  map->header = header;
+  map->data = bytes + header->data_offset;
+  map->index = reinterpret_cast<const feature_store_record_t *>(
+    bytes + header->index_offset);
+  map->record_size = rec_size;
+  map->base = base;
+  map->size = st.st_size;
+  madvise(base, st.st_size, MADV_WILLNEED);
+  return 0;
+}
+
+void feature_store_unmap(feature_store_map_t *map) {
+  if (map->base) {
+    munmap(map->base, map->size);
+    map->base = NULL;
+  }
+}
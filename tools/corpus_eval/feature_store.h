@@ -0,0 +1,128 @@
+#ifndef _FEATURE_STORE_H_
+#define _FEATURE_STORE_H_
+
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+/*!
+ * Feature store file layout, little endian:
+ * - feature_store_header_t;
+ * - records at data_offset, frame_num * row_len values each, float32 or
+ *   int8 quantized as the model input: q = round(value / scale) + zero_point
+ *   saturated to [-128, 127];
+ * - feature_store_record_t per record at index_offset, 8 byte aligned.
+ */
+#define FEATURE_STORE_MAGIC       0x54534647 // "GFST"
+#define FEATURE_STORE_VERSION     1
+#define FEATURE_STORE_DATA_OFFSET 128
+
+enum feature_store_kind_t : uint16_t {
+  FEATURE_STORE_MFCC = 0,
+  FEATURE_STORE_LOG_MEL = 1,
+  FEATURE_STORE_PCEN = 2,
+};
+
+enum feature_store_dtype_t : uint16_t {
+  FEATURE_STORE_FLOAT32 = 0,
+  FEATURE_STORE_INT8 = 1,
+};
+
+struct feature_store_header_t {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t kind;
+  uint16_t dtype;
+  /*! \brief nn_model_fft_len_t, 0 in older files is NN_MODEL_FFT_LEN_POW2. */
+  uint16_t fft_len;
+  /*! \brief AudioPreprocessor parameters. */
+  uint32_t sample_rate;
+  uint32_t frame_len;
+  uint32_t frame_shift;
+  uint32_t num_fbank_bins;
+  uint32_t mel_low_freq;
+  uint32_t mel_high_freq;
+  uint32_t num_mfcc;
+  /*! \brief Frames per record and values per frame. */
+  uint32_t frame_num;
+  uint32_t row_len;
+  /*! \brief Quantization of int8 records. */
+  float scale;
+  int32_t zero_point;
+  uint32_t record_num;
+  uint32_t data_offset;
+  uint32_t index_offset;
+};
+
+struct feature_store_record_t {
+  /*! \brief Corpus item index. */
+  uint32_t item;
+  /*! \brief Item length in samples. */
+  uint32_t samples;
+};
+
+/*! \brief Feature store writer, append is thread safe. */
+struct feature_store_t {
+  FILE *file;
+  feature_store_header_t header;
+  std::vector<feature_store_record_t> index;
+  std::vector<int8_t> qbuf;
+  std::mutex lock;
+};
+
+/*! \brief Mapped feature store. */
+struct feature_store_map_t {
+  const feature_store_header_t *header;
+  const uint8_t *data;
+  const feature_store_record_t *index;
+  size_t record_size;
+  void *base;
+  size_t size;
+};
+
+/*!
+ * \brief Create feature store.
+ * \param path File path.
+ * \param header Preprocessing parameters, record layout and quantization.
+ * \return Writer or NULL.
+ */
+feature_store_t *feature_store_create(const char *path,
+                                      const feature_store_header_t &header);
+/*!
+ * \brief Append a record.
+ * \param store Writer.
+ * \param record Record index entry.
+ * \param features frame_num * row_len features.
+ * \return Result.
+ */
+int feature_store_append(feature_store_t *store,
+                         const feature_store_record_t &record,
+                         const float *features);
+/*!
+ * \brief Write index and header, close the file.
+ * \param store Writer.
+ * \return Result.
+ */
+int feature_store_close(feature_store_t *store);
+/*!
+ * \brief Map feature store read only.
+ * \param path File path.
+ * \param map Mapped store.
+ * \return Result.
+ */
+int feature_store_map(const char *path, feature_store_map_t *map);
+/*!
+ * \brief Unmap feature store.
+ * \param map Mapped store.
+ */
+void feature_store_unmap(feature_store_map_t *map);
+
+/*! \brief Record data, float or int8 as header->dtype. */
+static inline const void *feature_store_record(const feature_store_map_t &map,
+                                               size_t idx) {
+  return map.data + idx * map.record_size;
+}
+
+#endif // _FEATURE_STORE_H_
@@ -0,0 +1,21 @@
+#ifndef _HOST_ESP_LOG_H_
+#define _HOST_ESP_LOG_H_
+
+#include <stdio.h>
+
+/*! \brief Host build of firmware modules, only errors and warnings. */
+#define ESP_LOGE(tag, fmt, ...)                                                \
+  fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...)                                                \
+  fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+// dropped, but the arguments are still checked and count as used
+#define ESP_LOG_NONE(tag, fmt, ...)                                            \
+  do {                                                                         \
+    if (0)                                                                     \
+      fprintf(stderr, "%s: " fmt "\n", tag, ##__VA_ARGS__);                    \
+  } while (0)
+#define ESP_LOGI(tag, fmt, ...) ESP_LOG_NONE(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) ESP_LOG_NONE(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) ESP_LOG_NONE(tag, fmt, ##__VA_ARGS__)
+
+#endif // _HOST_ESP_LOG_H_
@@ -0,0 +1,6 @@
+#ifndef _HOST_SDKCONFIG_H_
+#define _HOST_SDKCONFIG_H_
+
+/*! \brief Host build of firmware modules, Kconfig options are off. */
+
+#endif // _HOST_SDKCONFIG_H_
@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+"""Generate op resolvers with only the ops the models use.
+
+A model is given as name=source where source is a model .cpp with the C array
+(as for pack_models.py) or a .tflite file. The operator codes of every model
+are read from its flatbuffer, models with the same ops share one resolver.
+Generation fails when a model uses an op that has no kernel here, such ops
+and custom ones are registered with --kernel OP=registration, e.g.
+--kernel FULLY_CONNECTED=tflite::Register_FULLY_CONNECTED_INT8() or
+--kernel MyOp=MyOpRegistration(), the expression is passed to the Add method
+as is (AddCustom for custom ops).
+
+Output is model_op_resolver.h and model_op_resolver.cpp in the output dir.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+from pack_models import parse_cpp
+
+CUSTOM = 32
+
+# BuiltinOperator of the TFLite schema: (name, MicroMutableOpResolver method)
+BUILTIN_OPS = {
+    0: ("ADD", "AddAdd"),
+    1: ("AVERAGE_POOL_2D", "AddAveragePool2D"),
+    2: ("CONCATENATION", "AddConcatenation"),
+    3: ("CONV_2D", "AddConv2D"),
+    4: ("DEPTHWISE_CONV_2D", "AddDepthwiseConv2D"),
+    5: ("DEPTH_TO_SPACE", "AddDepthToSpace"),
+    6: ("DEQUANTIZE", "AddDequantize"),
+    8: ("FLOOR", "AddFloor"),
+    9: ("FULLY_CONNECTED", "AddFullyConnected"),
+    11: ("L2_NORMALIZATION", "AddL2Normalization"),
+    12: ("L2_POOL_2D", "AddL2Pool2D"),
+    14: ("LOGISTIC", "AddLogistic"),
+    17: ("MAX_POOL_2D", "AddMaxPool2D"),
+    18: ("MUL", "AddMul"),
+    19: ("RELU", "AddRelu"),
+    21: ("RELU6", "AddRelu6"),
+    22: ("RESHAPE", "AddReshape"),
+    23: ("RESIZE_BILINEAR", "AddResizeBilinear"),
+    25: ("SOFTMAX", "AddSoftmax"),
+    26: ("SPACE_TO_DEPTH", "AddSpaceToDepth"),
+    27: ("SVDF", "AddSvdf"),
+    28: ("TANH", "AddTanh"),
+    34: ("PAD", "AddPad"),
+    36: ("GATHER", "AddGather"),
+    37: ("BATCH_TO_SPACE_ND", "AddBatchToSpaceNd"),
+    38: ("SPACE_TO_BATCH_ND", "AddSpaceToBatchNd"),
+    39: ("TRANSPOSE", "AddTranspose"),
+    40: ("MEAN", "AddMean"),
+    41: ("SUB", "AddSub"),
+    42: ("DIV", "AddDiv"),
+    43: ("SQUEEZE", "AddSqueeze"),
+    44: ("UNIDIRECTIONAL_SEQUENCE_LSTM", "AddUnidirectionalSequenceLSTM"),
+    45: ("STRIDED_SLICE", "AddStridedSlice"),
+    47: ("EXP", "AddExp"),
+    49: ("SPLIT", "AddSplit"),
+    50: ("LOG_SOFTMAX", "AddLogSoftmax"),
+    53: ("CAST", "AddCast"),
+    54: ("PRELU", "AddPrelu"),
+    55: ("MAXIMUM", "AddMaximum"),
+    56: ("ARG_MAX", "AddArgMax"),
+    57: ("MINIMUM", "AddMinimum"),
+    60: ("PADV2", "AddPadV2"),
+    65: ("SLICE", "AddSlice"),
+    67: ("TRANSPOSE_CONV", "AddTransposeConv"),
+    70: ("EXPAND_DIMS", "AddExpandDims"),
+    73: ("LOG", "AddLog"),
+    74: ("SUM", "AddSum"),
+    75: ("SQRT", "AddSqrt"),
+    76: ("RSQRT", "AddRsqrt"),
+    77: ("SHAPE", "AddShape"),
+    82: ("REDUCE_MAX", "AddReduceMax"),
+    83: ("PACK", "AddPack"),
+    88: ("UNPACK", "AddUnpack"),
+    92: ("SQUARE", "AddSquare"),
+    98: ("LEAKY_RELU", "AddLeakyRelu"),
+    99: ("SQUARED_DIFFERENCE", "AddSquaredDifference"),
+    101: ("ABS", "AddAbs"),
+    102: ("SPLIT_V", "AddSplitV"),
+    114: ("QUANTIZE", "AddQuantize"),
+    117: ("HARD_SWISH", "AddHardSwish"),
+    123: ("SELECT_V2", "AddSelectV2"),
+}
+
+
+class FlatBuffer:
+    """Just enough of the flatbuffers format to read Model.operator_codes."""
+
+    def __init__(self, data):
+        self.data = data
+
+    def u32(self, pos):
+        return struct.unpack_from("<I", self.data, pos)[0]
+
+    def field(self, table, idx):
+        vtable = table - struct.unpack_from("<i", self.data, table)[0]
+        vtable_size = struct.unpack_from("<H", self.data, vtable)[0]
+        if 4 + 2 * idx >= vtable_size:
+            return 0
+        offset = struct.unpack_from("<H", self.data, vtable + 4 + 2 * idx)[0]
+        return table + offset if offset else 0
+
+    def scalar(self, table, idx, fmt, default):
+        pos = self.field(table, idx)
+        return struct.unpack_from(fmt, self.data, pos)[0] if pos else default
+
+    def deref(self, pos):
+        return pos + self.u32(pos)
+
+    def vector(self, table, idx):
+        pos = self.field(table, idx)
+        if not pos:
+            return []
+        vec = self.deref(pos)
+        return [self.deref(vec + 4 + 4 * i) for i in range(self.u32(vec))]
+
+    def string(self, table, idx):
+        pos = self.field(table, idx)
+        if not pos:
+            return None
+        s = self.deref(pos)
+        return self.data[s + 4:s + 4 + self.u32(s)].decode()
+
+
+def model_ops(data):
+    """Op keys of the model: builtin code or custom op name."""
+    if data[4:8] != b"TFL3":
+        raise ValueError("not a TFLite model")
+    fb = FlatBuffer(data)
+    model = fb.deref(0)
+    ops = []
+    # Model.operator_codes
+    for code in fb.vector(model, 1):
+        # OperatorCode.deprecated_builtin_code and builtin_code
+        builtin = max(fb.scalar(code, 0, "<b", 0), fb.scalar(code, 3, "<i", 0))
+        op = fb.string(code, 1) if builtin == CUSTOM else builtin
+        if op not in ops:
+            ops.append(op)
+    return ops
+
+
+def op_name(op):
+    return BUILTIN_OPS[op][0] if op in BUILTIN_OPS else str(op)
+
+
+def add_call(op, kernels):
+    if isinstance(op, str):
+        return 'AddCustom("%s", %s)' % (op, kernels[op])
+    registration = kernels.get(BUILTIN_OPS[op][0], "")
+    return "%s(%s)" % (BUILTIN_OPS[op][1], registration)
+
+
+def check_ops(name, ops, kernels):
+    missing = []
+    for op in ops:
+        if isinstance(op, str):
+            if op not in kernels:
+                missing.append("custom op %s" % op)
+        elif op not in BUILTIN_OPS:
+            missing.append("builtin op %d" % op)
+    if missing:
+        raise ValueError("%s: no kernel for %s, register it with --kernel" %
+                         (name, ", ".join(missing)))
+
+
+HEADER = """\
+// Generated by tools/gen_op_resolver.py, do not edit.
+#ifndef _MODEL_OP_RESOLVER_H_
+#define _MODEL_OP_RESOLVER_H_
+
+namespace tflite {
+class MicroOpResolver;
+}
+
+/*!
+ * \\brief Get resolver with the ops of the model.
+ * \\param name Model name.
+ * \\return Resolver or NULL for unknown model.
+ */
+const tflite::MicroOpResolver *model_op_resolver_get(const char *name);
+
+#endif // _MODEL_OP_RESOLVER_H_
+"""
+
+
+def generate_source(models, kernels, includes):
+    groups = []
+    for name, ops in models:
+        key = sorted(ops, key=str)
+        for group in groups:
+            if group["key"] == key:
+                group["names"].append(name)
+                break
+        else:
+            groups.append({"key": key, "ops": ops, "names": [name]})
+
+    out = ["// Generated by tools/gen_op_resolver.py, do not edit.",
+           '#include "model_op_resolver.h"', "",
+           '#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"']
+    out += ['#include "%s"' % inc for inc in includes]
+    out += ["", "#include <string.h>", ""]
+    for i, group in enumerate(groups):
+        cls = "ModelOpResolver%d" % i
+        out += ["/*! \\brief %s: %s. */" % (", ".join(group["names"]),
+                                           ", ".join(op_name(op) for op in group["ops"])),
+                "class %s {" % cls,
+                "public:",
+                "  static const tflite::MicroOpResolver &getInstance() {",
+                "    static %s instance;" % cls,
+                "    return instance.op_resolver_;",
+                "  }",
+                "  %s(%s const &) = delete;" % (cls, cls),
+                "  void operator=(%s const &) = delete;" % cls,
+                "",
+                "private:",
+                "  tflite::MicroMutableOpResolver<%d> op_resolver_;" % len(group["ops"]),
+                "  %s() {" % cls]
+        out += ["    op_resolver_.%s;" % add_call(op, kernels) for op in group["ops"]]
+        out += ["  }", "};", ""]
+
+    out += ["const tflite::MicroOpResolver *model_op_resolver_get(const char *name) {"]
+    for i, group in enumerate(groups):
+        for name in group["names"]:
+            out += ['  if (strcmp(name, "%s") == 0) {' % name,
+                    "    return &ModelOpResolver%d::getInstance();" % i,
+                    "  }"]
+    out += ["  return NULL;", "}", ""]
+    return "\n".join(out)
+
+
+def write(path, text):
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-o", "--output-dir", required=True)
+    parser.add_argument("--kernel", action="append", default=[],
+                        metavar="OP=registration",
+                        help="kernel for a builtin op name or a custom op")
+    parser.add_argument("--include", action="append", default=[],
+                        metavar="header", help="header with the kernels")
+    parser.add_argument("models", nargs="*", metavar="name=source")
+    args = parser.parse_args()
+
+    kernels = dict(k.split("=", 1) for k in args.kernel)
+    models = []
+    try:
+        for spec in args.models:
+            name, _, source = spec.partition("=")
+            if source.endswith(".cpp"):
+                data = parse_cpp(source)["data"]
+            else:
+                data = open(source, "rb").read()
+            try:
+                ops = model_ops(data)
+            except (ValueError, struct.error) as e:
+                raise ValueError("%s: %s" % (source, e))
+            check_ops(name, ops, kernels)
+            models.append((name, ops))
+            print("%s: %s" % (name, ", ".join(op_name(op) for op in ops)))
+    except (ValueError, OSError) as e:
+        sys.exit("gen_op_resolver: %s" % e)
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    write(os.path.join(args.output_dir, "model_op_resolver.h"), HEADER)
+    write(os.path.join(args.output_dir, "model_op_resolver.cpp"),
+          generate_source(models, kernels, args.include))
+
+
+if __name__ == "__main__":
+    main()
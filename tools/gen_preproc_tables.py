@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+"""Generate AudioPreprocessor tables of the model feature configurations.
+
+A model is given as name=source where source is a model .cpp with the
+nn_model_desc_t (as for pack_models.py), other sources are skipped. The Hann
+window, mel filterbank and DCT matrix of every distinct configuration at the
+given sample rate are written as const arrays, so they stay in flash and
+AudioPreprocessor does not compute them at runtime. The filterbank follows
+AudioPreprocessor::CreateMelFbank() in single precision, so the filters
+cover the same FFT bins; the window and DCT are computed in double precision.
+
+Output is model_preproc_tables.h and model_preproc_tables.cpp in the output
+dir.
+"""
+
+import argparse
+import math
+import os
+import struct
+import sys
+
+from pack_models import PREPROC_FIELDS, parse_cpp
+
+FEATURES_MFCC = 0
+FFT_LEN_POW2 = 0
+
+
+def f32(x):
+    return struct.unpack("<f", struct.pack("<f", x))[0]
+
+
+def mel_scale(freq):
+    return f32(1127.0 * f32(math.log(f32(1.0 + f32(freq / 700.0)))))
+
+
+def hann_window(frame_len):
+    return [0.5 - 0.5 * math.cos(2 * math.pi * i / frame_len)
+            for i in range(frame_len)]
+
+
+def mel_fbank(samp_freq, fft_len, num_bins, mel_low, mel_high):
+    """First and last FFT bins and weights of the filters, None if a filter
+    has no FFT bins."""
+    num_fft_bins = fft_len // 2
+    bin_width = f32(f32(samp_freq) / fft_len)
+    low = mel_scale(mel_low)
+    high = mel_scale(mel_high)
+    delta = f32(f32(high - low) / (num_bins + 1))
+    first, last, weights = [], [], []
+    for b in range(num_bins):
+        left = f32(low + f32(b * delta))
+        center = f32(low + f32((b + 1) * delta))
+        right = f32(low + f32((b + 2) * delta))
+        this_bin = []
+        for i in range(num_fft_bins):
+            mel = mel_scale(f32(bin_width * i))
+            if left < mel < right:
+                if mel <= center:
+                    w = f32(f32(mel - left) / f32(center - left))
+                else:
+                    w = f32(f32(right - mel) / f32(right - center))
+                this_bin.append((i, w))
+        if not this_bin:
+            return None
+        first.append(this_bin[0][0])
+        last.append(this_bin[-1][0])
+        weights += [w for _, w in this_bin]
+    return first, last, weights
+
+
+def dct_matrix(num_bins, num_mfcc):
+    """num_bins x num_mfcc, transposed as in DCT."""
+    norm = math.sqrt(2.0 / num_bins)
+    return [norm * math.cos(math.pi / num_bins * (n + 0.5) * k)
+            for n in range(num_bins) for k in range(num_mfcc)]
+
+
+def config(model, sample_rate):
+    p = dict(zip(PREPROC_FIELDS, model["preproc"]))
+    frame_len = sample_rate // 1000 * p["win_ms"]
+    fft_len = frame_len
+    if p["fft_len"] == FFT_LEN_POW2:
+        fft_len = 1 << (frame_len - 1).bit_length()
+    num_mfcc = p["num_mfcc"] if p["features"] == FEATURES_MFCC else 0
+    return (sample_rate, frame_len, fft_len, p["num_fbank_bins"], num_mfcc,
+            model["mel_low_freq"], model["mel_high_freq"])
+
+
+HEADER = """\
+// Generated by tools/gen_preproc_tables.py, do not edit.
+#ifndef _MODEL_PREPROC_TABLES_H_
+#define _MODEL_PREPROC_TABLES_H_
+
+#include "nn_model.h"
+#include "preproc_tables.h"
+
+/*!
+ * \\brief Get generated tables of the model features.
+ * \\param desc Model description.
+ * \\param sample_rate Input sample rate.
+ * \\return Tables or NULL, AudioPreprocessor computes them then.
+ */
+const preproc_tables_t *model_preproc_tables_get(const nn_model_desc_t *desc,
+                                                 int sample_rate);
+
+#endif // _MODEL_PREPROC_TABLES_H_
+"""
+
+
+def c_array(ctype, name, values, fmt):
+    out = ["static const %s %s[%d] = {" % (ctype, name, len(values))]
+    for i in range(0, len(values), 6):
+        out.append("  " + " ".join(fmt(v) + "," for v in values[i:i + 6]))
+    out.append("};")
+    return out
+
+
+def c_float(v):
+    text = "%.9g" % f32(v)
+    if "." not in text and "e" not in text:
+        text += ".0"
+    return text + "f"
+
+
+def generate_source(configs):
+    out = ["// Generated by tools/gen_preproc_tables.py, do not edit.",
+           '#include "model_preproc_tables.h"', ""]
+    windows, fbanks, dcts = {}, {}, {}
+    for cfg, names in configs:
+        sr, frame_len, fft_len, bins, mfcc, low, high = cfg
+        fbank = (sr, fft_len, bins, low, high)
+        if fbank not in fbanks:
+            fbanks[fbank] = "fbank_%d" % len(fbanks)
+            first, last, weights = mel_fbank(*fbank)
+            out += ["/*! \\brief %d Hz, FFT %d, %d filters %d-%d Hz. */" %
+                    fbank]
+            out += c_array("int32_t", fbanks[fbank] + "_first", first, str)
+            out += c_array("int32_t", fbanks[fbank] + "_last", last, str)
+            out += c_array("float", fbanks[fbank] + "_weights", weights,
+                           c_float)
+        if frame_len not in windows:
+            windows[frame_len] = "window_%d" % frame_len
+            out += c_array("float", windows[frame_len],
+                           hann_window(frame_len), c_float)
+        if mfcc and (bins, mfcc) not in dcts:
+            dcts[(bins, mfcc)] = "dct_%dx%d" % (bins, mfcc)
+            out += c_array("float", dcts[(bins, mfcc)],
+                           dct_matrix(bins, mfcc), c_float)
+        out.append("")
+
+    out += ["const preproc_tables_t *model_preproc_tables_get(const nn_model_desc_t *desc,",
+            "                                                 int sample_rate) {"]
+    if not configs:
+        out += ["  (void)desc;", "  (void)sample_rate;", "  return NULL;",
+                "}", ""]
+        return "\n".join(out)
+
+    out += ["  static const preproc_tables_t tables[] = {"]
+    for cfg, names in configs:
+        sr, frame_len, fft_len, bins, mfcc, low, high = cfg
+        fbank = fbanks[(sr, fft_len, bins, low, high)]
+        out += ["    // %s" % ", ".join(names),
+                "    {%d, %d, %d, %d, %d, %d, %d, %s, %s_first, %s_last," %
+                (sr, frame_len, fft_len, bins, mfcc, low, high,
+                 windows[frame_len], fbank, fbank),
+                "     %s_weights, %s}," %
+                (fbank, dcts[(bins, mfcc)] if mfcc else "NULL")]
+    out += ["  };",
+            "  const nn_model_preproc_t &p = desc->preproc;",
+            "  const int frame_len = sample_rate / 1000 * p.win_ms;",
+            "  int fft_len = frame_len;",
+            "  if (p.fft_len == NN_MODEL_FFT_LEN_POW2) {",
+            "    fft_len = 1;",
+            "    while (fft_len < frame_len) {",
+            "      fft_len *= 2;",
+            "    }",
+            "  }",
+            "  const int num_mfcc =",
+            "    p.features == NN_MODEL_FEATURES_MFCC ? p.num_mfcc : 0;",
+            "  for (const auto &t : tables) {",
+            "    if (t.samp_freq == sample_rate && t.frame_len == frame_len &&",
+            "        t.fft_len == fft_len && t.num_fbank_bins == p.num_fbank_bins &&",
+            "        t.num_mfcc == num_mfcc &&",
+            "        t.mel_low_freq == int(desc->mel_low_freq) &&",
+            "        t.mel_high_freq == int(desc->mel_high_freq)) {",
+            "      return &t;",
+            "    }",
+            "  }",
+            "  return NULL;",
+            "}", ""]
+    return "\n".join(out)
+
+
+def write(path, text):
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-o", "--output-dir", required=True)
+    parser.add_argument("-r", "--sample-rate", type=int, required=True)
+    parser.add_argument("models", nargs="*", metavar="name=source")
+    args = parser.parse_args()
+
+    configs = []
+    try:
+        for spec in args.models:
+            name, _, source = spec.partition("=")
+            if not source.endswith(".cpp"):
+                continue
+            cfg = config(parse_cpp(source), args.sample_rate)
+            if mel_fbank(cfg[0], *cfg[2:4], *cfg[5:]) is None:
+                # runtime tables, the empty filter is left to AudioPreprocessor
+                print("%s: a mel filter has no FFT bins, skipped" % name)
+                continue
+            for known, names in configs:
+                if known == cfg:
+                    names.append(name)
+                    break
+            else:
+                configs.append((cfg, [name]))
+            print("%s: frame %d, FFT %d, %d filters, %d MFCC" %
+                  ((name,) + cfg[1:5]))
+        source = generate_source(configs)
+    except (ValueError, OSError) as e:
+        sys.exit("gen_preproc_tables: %s" % e)
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    write(os.path.join(args.output_dir, "model_preproc_tables.h"), HEADER)
+    write(os.path.join(args.output_dir, "model_preproc_tables.cpp"), source)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Pack models into the models partition image.
+
+Layout matches components/nn_model/nn_model_partition.h. A model is given as
+name=source where source is either a model .cpp with the C array and
+nn_model_desc_t, or model.tflite:labels.txt:mel_low:mel_high[:float]. The
+preprocessing config of a .tflite model is read from its "grc_preproc"
+metadata at runtime.
+"""
+
+import argparse
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = 0x4C444D47  # "GMDL"
+VERSION = 3
+NAME_LEN = 24
+HEADER = struct.Struct("<IHH")
+ENTRY = struct.Struct("<%dsIIIHBBHHBBHHHHHBBxxI" % NAME_LEN)
+PREPROC_FIELDS = ("features", "norm", "win_ms", "stride_ms", "duration_ms",
+                  "num_fbank_bins", "num_mfcc", "fft_len", "reserved")
+PREPROC_ENUMS = {
+    "NN_MODEL_FEATURES_MFCC": 0,
+    "NN_MODEL_FEATURES_LOG_MEL": 1,
+    "NN_MODEL_FEATURES_PCEN": 2,
+    "NN_MODEL_NORM_PEAK": 0,
+    "NN_MODEL_NORM_FULL_SCALE": 1,
+    "NN_MODEL_FFT_LEN_POW2": 0,
+    "NN_MODEL_FFT_LEN_WINDOW": 1,
+}
+# fields the model source may omit, zero initialized as in C++
+PREPROC_DEFAULTS = {"fft_len": "0", "reserved": "0"}
+MODEL_ALIGN = 16
+
+
+def parse_cpp(path):
+    src = open(path).read()
+    array = re.search(r"\[\]\s*=\s*\{([^}]*)\}", src)
+    labels = re.search(r"\*labels\[\]\s*=\s*\{([^}]*)\}", src)
+    if not array or not labels:
+        raise ValueError("%s: model array or labels are not found" % path)
+
+    def field(name):
+        m = re.search(r"\.%s\s*=\s*(\w+)" % name, src)
+        if not m:
+            raise ValueError("%s: .%s is not found" % (path, name))
+        return m.group(1)
+
+    preproc_src = re.search(r"\.preproc\s*=\s*\{([^}]*)\}", src)
+    if not preproc_src:
+        raise ValueError("%s: .preproc is not found" % path)
+    values = dict(re.findall(r"\.(\w+)\s*=\s*(\w+)", preproc_src.group(1)))
+    values = dict(PREPROC_DEFAULTS, **values)
+    preproc = [int(PREPROC_ENUMS.get(values[f], values[f])) for f in PREPROC_FIELDS]
+
+    return {
+        "data": bytes(int(v, 16) for v in re.findall(r"0x[0-9a-fA-F]+", array.group(1))),
+        "preproc": preproc,
+        "labels": re.findall(r'"([^"]*)"', labels.group(1)),
+        "is_quantized": field("is_quantized") == "true",
+        "mel_low_freq": int(field("mel_low_freq")),
+        "mel_high_freq": int(field("mel_high_freq")),
+    }
+
+
+def parse_tflite(spec):
+    parts = spec.split(":")
+    if len(parts) not in (4, 5):
+        raise ValueError("%s: expected model.tflite:labels.txt:mel_low:mel_high[:float]" % spec)
+    with open(parts[1]) as f:
+        labels = [line.strip() for line in f if line.strip()]
+    return {
+        "data": open(parts[0], "rb").read(),
+        # taken from the model metadata at runtime
+        "preproc": [0] * len(PREPROC_FIELDS),
+        "labels": labels,
+        "is_quantized": len(parts) == 4,
+        "mel_low_freq": int(parts[2]),
+        "mel_high_freq": int(parts[3]),
+    }
+
+
+def align(offset):
+    return (offset + MODEL_ALIGN - 1) & ~(MODEL_ALIGN - 1)
+
+
+def pack(models):
+    offset = HEADER.size + ENTRY.size * len(models)
+    entries = b""
+    payload = b""
+    for name, m in models:
+        if len(name.encode()) > NAME_LEN:
+            raise ValueError("%s: name is longer than %d" % (name, NAME_LEN))
+        pad = align(offset) - offset
+        payload += b"\0" * pad
+        model_offset = offset + pad
+        labels = b"".join(label.encode() + b"\0" for label in m["labels"])
+        labels_offset = model_offset + len(m["data"])
+        payload += m["data"] + labels
+        offset = labels_offset + len(labels)
+        entries += ENTRY.pack(name.encode(), model_offset, len(m["data"]),
+                              labels_offset, len(m["labels"]),
+                              int(m["is_quantized"]), 0, m["mel_low_freq"],
+                              m["mel_high_freq"], *m["preproc"],
+                              zlib.crc32(m["data"]) & 0xFFFFFFFF)
+    return HEADER.pack(MAGIC, VERSION, len(models)) + entries + payload
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--max-size", type=lambda v: int(v, 0),
+                        help="partition size")
+    parser.add_argument("models", nargs="+", metavar="name=source")
+    args = parser.parse_args()
+
+    models = []
+    for spec in args.models:
+        name, _, source = spec.partition("=")
+        if source.endswith(".cpp"):
+            models.append((name, parse_cpp(source)))
+        else:
+            models.append((name, parse_tflite(source)))
+
+    image = pack(models)
+    if args.max_size and len(image) > args.max_size:
+        sys.exit("models image is %d bytes, partition is %d" %
+                 (len(image), args.max_size))
+    with open(args.output, "wb") as f:
+        f.write(image)
+    for name, m in models:
+        print("%s: %d bytes, %d labels" % (name, len(m["data"]), len(m["labels"])))
+    print("%s: %d bytes" % (args.output, len(image)))
+
+
+if __name__ == "__main__":
+    main()